@@ -19,7 +19,7 @@
 #pragma once
 #include <Arduino.h>
 #include <DallasTemperature.h>
-#include <AM2320.h>
+#include <Wire.h>
 #include <Clock.h>
 #include <settings.h>
 #include <DynamicArray.h>
@@ -54,12 +54,45 @@
 #define DEFAULT_READ_DATA_TIME 5 // sec
 #define DEFAULT_DS18B20_NAME "Tn"
 #define DEFAULT_DS18B20_RESOLUTION 12
+#define DEFAULT_DS18B20_AUTO_RESOLUTION_FLAG false
+#define DEFAULT_AUTO_RESOLUTION_RATIO 10 // %
+#define DEFAULT_DS18B20_CRC_PERIOD 10 // cycles
+#define DEFAULT_DS18B20_READ_TIME 0 // sec, 0 - read data time
+#define DEFAULT_DS18B20_ADAPTIVE_FLAG false
+#define DEFAULT_ADAPTIVE_RATE 5 // 0.1°/min
+#define DEFAULT_DS18B20_BUS 0
+#define DEFAULT_DS18B20_BUS_PORT DS18B20_BUS_OFF // buses after the first
+#define DEFAULT_DS18B20_ALARM_BAND 0 // °, 0 - every scratchpad is read
+#define DEFAULT_DS18B20_FILTER_MEDIAN 1 // samples, 1 - off
+#define DEFAULT_DS18B20_FILTER_EMA 0 // alpha = 1 / 2^n, 0 - off
+#define DEFAULT_DS18B20_FILTER_SLEW 0 // 0.1°/sec, 0 - off
+#define DEFAULT_FAULT_STUCK_COUNT 0 // repeated samples, 0 - off
+#define DEFAULT_FAULT_RATE 0 // °/min, 0 - off
+#define DEFAULT_FAULT_PAIR_DELTA 0 // °, 0 - off
+#define DEFAULT_DS18B20_PAIR -1
+#define DEFAULT_FLOW_PORT FLOW_PORT_OFF
+#define DEFAULT_FLOW_PULSES 450 // per liter
+#define DEFAULT_ANALOG_WORK_FLAG false
+#define DEFAULT_ANALOG_TYPE SENSOR_TYPE_PRESSURE
+#define DEFAULT_ANALOG_MAX_VALUE 1000 // hundredths at the full scale
 
 /* SolarSystemManager */
 #define DEFAULT_SOLAR_WORK_FLAG true
 #define DEFAULT_SOLAR_ERROR_ON_FLAG true
 #define DEFAULT_SOLAR_RELE_INVERT_FLAG true
 #define DEFAULT_SOLAR_DELTA 5
+#define DEFAULT_SOLAR_CHANNELS_COUNT 1
+
+/* ReleDriver */
+#define DEFAULT_RELE_MIN_ON_TIME 30 // sec
+#define DEFAULT_RELE_MIN_OFF_TIME 30 // sec
+#define DEFAULT_RELE_MAX_RATE 20 // starts per hour, 0 - off
+#define DEFAULT_RELE_OVERRIDE_TIME 30 // min, 0 - never expires
+
+/* EnergyMeter */
+#define DEFAULT_ENERGY_WORK_FLAG true
+#define DEFAULT_ENERGY_FLOW 200 // centi l/min, without a flow meter
+#define DEFAULT_ENERGY_CAPACITY 4186 // J/(l·K), water
 
 /* DisplayManager */
 #define DEFAULT_DISPLAY_WORK_FLAG true
@@ -79,21 +112,239 @@
 /* --- Macroces --- */
 /* SystemManager */
 #define SAVE_SETTINGS_TIME 5 // sec
-#define SETTINGS_BUFFER_SIZE 1100
+#define SETTINGS_ENTRY(code, value) ((code) + (value) + 2) // "<code>=<value>;", code with its index
+#define SETTINGS_BOOL 1 // value widths, integers in decimal
+#define SETTINGS_UINT8 3
+#define SETTINGS_INT8 4
+#define SETTINGS_UINT16 5
+#define SETTINGS_INT32 11
+#define SETTINGS_UINT32 10
+#define SETTINGS_FLOAT(integer) ((integer) + 4) // sign, point and 2 decimals
+#define SETTINGS_STRING(size) ((size) - 1)
+#define SETTINGS_ARRAY(count, value) ((count) * ((value) + 1) - 1) // comma separated
+#define SYSTEM_SETTINGS_SIZE SETTINGS_ENTRY(3, SETTINGS_BOOL)
+#define SETTINGS_BUFFER_SIZE (SYSTEM_SETTINGS_SIZE + TIME_SETTINGS_SIZE + SENSORS_SETTINGS_SIZE + SOLAR_SETTINGS_SIZE + \
+	DISPLAY_SETTINGS_SIZE + NETWORK_SETTINGS_SIZE + BLYNK_SETTINGS_SIZE)
 
 /* TimeManager */
 #define NTP_SYNC_TIME 1 // min
+#define TIME_SETTINGS_SIZE (SETTINGS_ENTRY(4, SETTINGS_BOOL) + SETTINGS_ENTRY(3, SETTINGS_INT8))
+
+/* I2CManager */
+#define I2C_DEVICES_MAX_COUNT 4
+#define I2C_TICK_BUDGET 3000 // mcs, display transactions per tick
+#define I2C_RESERVE_GUARD 300 // mcs
+#define I2C_PRIORITY_SENSOR 0
+#define I2C_PRIORITY_DISPLAY 1
+#define I2C_ERROR_LENGTH 5
 
 /* SensorsManager */
 #define MODULE_MANAGER_BLYNK_SUPPORT
 #define UNSPECIFIED_STATUS 255
 #define DS_SENSORS_MAX_COUNT 10
 #define DS_NAME_SIZE 3
+#define DS18B20_BUS_COUNT 2
+#define DS18B20_BUS_OFF 255
+
+#define SENSOR_DRIVERS_MAX_COUNT 4
+#define SENSOR_SOURCE_AM2320_T 0
+#define SENSOR_SOURCE_AM2320_H 1
+#define SENSOR_SOURCE_DS18B20 2 // + sensor index
+#define SENSOR_SOURCE_DRIVERS (SENSOR_SOURCE_DS18B20 + DS_SENSORS_MAX_COUNT) // added drivers
+#define SENSOR_SAMPLES_COUNT (SENSOR_SOURCE_DRIVERS + 4)
+#define SENSOR_TYPE_NONE 0
+#define SENSOR_TYPE_TEMPERATURE 1
+#define SENSOR_TYPE_HUMIDITY 2
+#define SENSOR_TYPE_PRESSURE 3
+#define SENSOR_TYPE_FLOW 4
+#define SENSOR_TYPE_VOLUME 5
+#define SENSOR_TYPE_IRRADIANCE 6
+#define SENSOR_SOURCE_FLOW (SENSOR_SOURCE_DRIVERS + 0)
+#define SENSOR_SOURCE_FLOW_VOLUME (SENSOR_SOURCE_DRIVERS + 1)
+#define SENSOR_SOURCE_ANALOG (SENSOR_SOURCE_DRIVERS + 2)
+
+#define FLOW_PORT_OFF 255
+#define FLOW_WINDOW_TIME 1000 // mls
+#define FLOW_PULSES_MIN 1 // per liter
+#define FLOW_PULSES_MAX 10000 // per liter
+
+#define ANALOG_PORT A0
+#define ANALOG_OVERSAMPLE 16 // reads per sample, 2 extra bits
+#define ANALOG_RAW_MAX 4095 // 10 bit adc + 2 bits
+#define ANALOG_READ_INTERVAL 5000 // mcs, frequent reads break the wifi
+#define ANALOG_POINTS_COUNT 4
+
+#define AM2320_STATE_IDLE 0
+#define AM2320_STATE_WAKE 1
+#define AM2320_STATE_MEASURE 2
+
+#define AM2320_ADDRESS 0x5C
+#define AM2320_READ_REGISTERS 0x03
+#define AM2320_WAKE_TIME 1000 // mcs
+#define AM2320_MEASURE_TIME 1600 // mcs
+#define AM2320_OFFLINE_COUNT 3
+#define AM2320_OFFLINE_TIME 1 // min
+#define AM2320_ERROR_NO_ACK 1
+#define AM2320_ERROR_TIMEOUT 2
+#define AM2320_ERROR_CRC 3
+#define AM2320_ERROR_DATA 4
+
+#define DS18B20_STATE_IDLE 0
+#define DS18B20_STATE_CONVERT 1
+#define DS18B20_STATE_READ 2
+#define DS18B20_STATE_PUBLISH 3
+#define DS18B20_STATE_ALARM 4
+
+#define DS18B20_TRANSFER_IDLE 0
+#define DS18B20_TRANSFER_BUSY 1
+#define DS18B20_TRANSFER_DONE 2
+#define DS18B20_TRANSFER_FAILED 3
+#define DS18B20_TRANSFER_READ 0 // owners
+#define DS18B20_TRANSFER_ARM 1
+#define DS18B20_TRANSFER_VERIFY 2
+#define DS18B20_TRANSFER_PEEK 3
+#define DS18B20_TRANSFER_CONFIG 4
+#define DS18B20_TRANSFER_POWER 5
+#define DS18B20_TRANSFER_BYTES 4 // per tick, 0.5 ms each at standard speed, a reset counts as two
+#define DS18B20_MATCH_ROM 0x55
+#define DS18B20_SKIP_ROM 0xCC
+
+#define DS18B20_CONFIG_SYNC_TIME 1000 // mls
+#define DS18B20_CONFIG_VERIFY_TIME 10 // min
+#define DS18B20_COPY_TIME 20 // mls, the eeprom write, 10 by the datasheet
+#define DS18B20_WRITE_SCRATCHPAD 0x4E
+#define DS18B20_READ_SCRATCHPAD 0xBE
+#define DS18B20_COPY_SCRATCHPAD 0x48
+#define DS18B20_READ_POWER_SUPPLY 0xB4
+#define DS18B20_DISCONNECTED_T -12700 // c°
+#define DS18B20_POWER_ON_T 8500 // c°
+#define DS18B20_CORRECTION_MAX 2000 // c°
+#define DS18B20_ALARM_HIGH 125
+#define DS18B20_ALARM_LOW -55
+#define DS18B20_ADAPTIVE_MIN_TIME 1000 // mls
+#define DS18B20_ADAPTIVE_MAX_RATIO 4
+#define DS18B20_SCHEDULE_RATIO 4
+#define DS18B20_ALARM_BAND_MAX 20 // °
+#define DS18B20_ALARM_SEARCH 0xEC
+#define DS18B20_FILTER_MEDIAN_MAX 5 // samples
+#define DS18B20_FILTER_EMA_MAX 4
+#define DS18B20_FILTER_EMA_SHIFT 4 // fraction bits of the ema accumulator
+#define DS18B20_FILTER_SLEW_MAX 100 // 0.1°/sec
+
+#define DS18B20_STATUS_DISCONNECTED 1
+#define DS18B20_STATUS_POWER_ON 2
+#define DS18B20_STATUS_STUCK 3
+#define DS18B20_STATUS_RATE 4
+#define DS18B20_STATUS_PAIR 5
+#define DS18B20_FAULT_STUCK_MAX 250 // samples
+#define DS18B20_FAULT_RATE_MAX 100 // °/min
+#define DS18B20_FAULT_PAIR_MAX 50 // °
+#define DS18B20_FAULT_PAIR_AGE 1 // min, older pair samples are not compared
+
+#define DS18B20_SEARCH_IDLE 0
+#define DS18B20_SEARCH_WAIT 1
+#define DS18B20_SEARCH_PASS 2
+#define DS18B20_SEARCH_READ 3 // the scratchpad of the found device
+#define DS18B20_SEARCH_POWER 4 // the power supply of a new device
+
+#define DS18B20_SEARCH_ROM 0xF0
+#define DS18B20_SEARCH_FAMILY 0x28
+#define DS18B20_SEARCH_BITS 10 // per tick, three slots each, about DS18B20_TRANSFER_BYTES of wire time
+#define DS18B20_SEARCH_TIME 1 // min
+#define DS18B20_BUS_EVENTS_COUNT 8
+#define DS18B20_BUS_EVENT_APPEARED 1
+#define DS18B20_BUS_EVENT_MISSING 2
+
+// the index of a sensor, a bus or an analog point is one digit
+#define SENSORS_SETTINGS_SIZE (SETTINGS_ENTRY(5, SETTINGS_UINT8) * 4 + SETTINGS_ENTRY(4, SETTINGS_UINT8) * 4 + \
+	SETTINGS_ENTRY(5, SETTINGS_UINT8) + SETTINGS_ENTRY(5, SETTINGS_UINT16) + SETTINGS_ENTRY(5, SETTINGS_BOOL) + SETTINGS_ENTRY(5, SETTINGS_UINT8) * 2 + \
+	(SETTINGS_ENTRY(6, SETTINGS_UINT16) + SETTINGS_ENTRY(6, SETTINGS_INT32)) * ANALOG_POINTS_COUNT + \
+	SETTINGS_ENTRY(7, SETTINGS_UINT8) * DS18B20_BUS_COUNT + DS18B20_SETTINGS_SIZE * DS_SENSORS_MAX_COUNT)
+#define DS18B20_SETTINGS_SIZE (SETTINGS_ENTRY(6, SETTINGS_STRING(DS_NAME_SIZE)) + SETTINGS_ENTRY(6, SETTINGS_ARRAY(8, SETTINGS_UINT8)) + \
+	SETTINGS_ENTRY(6, SETTINGS_UINT8) * 3 + SETTINGS_ENTRY(7, SETTINGS_BOOL) * 2 + SETTINGS_ENTRY(6, SETTINGS_FLOAT(2)) + \
+	SETTINGS_ENTRY(7, SETTINGS_UINT8) * 3 + SETTINGS_ENTRY(6, SETTINGS_INT8))
 
 /* SolarSystemManager */
 #define SOLAR_SYSTEM_MANAGER_BLYNK_SUPPORT
 #define SOLAR_DELTA_MIN 3
 #define SOLAR_DELTA_MAX 10
+#define SOLAR_HYSTERESIS 2
+#define SOLAR_NO_FLOW_TIME 30 // sec
+#define SOLAR_NO_FLOW_RETRY_TIME 60 // sec, the pause after the first dry run, doubles with every next one
+#define SOLAR_NO_FLOW_RETRY_MAX 3600 // sec
+#define SOLAR_REASON_OFF 0
+#define SOLAR_REASON_ERROR 1
+#define SOLAR_REASON_DELTA_ON 2
+#define SOLAR_REASON_DELTA_OFF 3
+#define SOLAR_REASON_HYSTERESIS 4
+#define SOLAR_REASON_MANUAL 5
+#define SOLAR_REASON_RULE 6
+#define SOLAR_REASON_NO_FLOW 7
+#define SOLAR_CHANNELS_COUNT 4
+#define SOLAR_ERROR_HOLD 0
+#define SOLAR_ERROR_ON 1
+#define SOLAR_ERROR_OFF 2
+#define SOLAR_RULES_COUNT 4
+#define SOLAR_RULE_OFF 0
+#define SOLAR_RULE_ON 1
+#define SOLAR_SETTINGS_SIZE (SETTINGS_ENTRY(4, SETTINGS_BOOL) + SETTINGS_ENTRY(5, SETTINGS_INT8) + SETTINGS_ENTRY(5, SETTINGS_UINT8) + \
+	RELE_SETTINGS_SIZE + ENERGY_SETTINGS_SIZE + SOLAR_CHANNEL_SETTINGS_SIZE * SOLAR_CHANNELS_COUNT + RULE_SETTINGS_SIZE * SOLAR_RULES_COUNT)
+#define SOLAR_CHANNEL_SETTINGS_SIZE (SETTINGS_ENTRY(6, SETTINGS_INT8) * 2 + SETTINGS_ENTRY(6, SETTINGS_UINT8) * 4 + SETTINGS_ENTRY(6, SETTINGS_BOOL) + \
+	SETTINGS_ENTRY(7, SETTINGS_UINT32) * 3)
+
+/* ReleDriver */
+#define RELE_OUTPUT_UNKNOWN 255
+#define RELE_PORT_OFF 255
+#define RELE_PORT_MAX 16
+#define RELE_TIME_MAX 3600 // sec
+#define RELE_RATE_MAX 60 // starts per hour
+#define RELE_OVERRIDE_TIME_MAX 240 // min
+#define RELE_RTC_OFFSET 0 // 4 byte blocks of the rtc user memory
+#define RELE_RTC_MAGIC 0x52454C45
+#define RELE_RTC_TIME 60 // sec, while on
+#define RELE_FLUSH_TIME 60 // min, counters to the flash
+#define RELE_SETTINGS_SIZE (SETTINGS_ENTRY(5, SETTINGS_UINT16) * 2 + SETTINGS_ENTRY(5, SETTINGS_UINT8) * 2) // limits, the counters are per channel
+
+/* EnergyMeter */
+#define ENERGY_FLOW_MAX 10000 // centi l/min
+#define ENERGY_CAPACITY_MIN 1000 // J/(l·K)
+#define ENERGY_CAPACITY_MAX 5000 // J/(l·K)
+#define ENERGY_STEP_MAX 60000 // mls, a longer gap than this and two read intervals is not integrated
+#define ENERGY_SCALE 600000000 // centi K * centi l/min * mls per J
+#define ENERGY_RTC_OFFSET 24 // after the relay counters
+#define ENERGY_RTC_MAGIC 0x454E5247
+#define ENERGY_RTC_TIME 60 // sec
+#define ENERGY_FLUSH_TIME 60 // min, counters to the flash
+#define ENERGY_SETTINGS_SIZE (SETTINGS_ENTRY(4, SETTINGS_BOOL) + SETTINGS_ENTRY(4, SETTINGS_UINT16) * 2 + SETTINGS_ENTRY(4, SETTINGS_UINT32) * 3 + \
+	SETTINGS_ENTRY(5, SETTINGS_UINT32))
+
+/* RuleEngine */
+#define RULE_TEXT_SIZE 40
+#define RULE_CODE_SIZE 24
+#define RULE_STACK_SIZE 8
+#define RULE_NUMBER_MAX 1000000
+#define RULE_TRUE 100 // 1.00
+#define RULE_OP_CONST 0
+#define RULE_OP_SAMPLE 1
+#define RULE_OP_RELE 2
+#define RULE_OP_HOUR 3
+#define RULE_OP_MINUTE 4
+#define RULE_OP_NOT 5
+#define RULE_OP_NEG 6
+#define RULE_OP_MUL 7
+#define RULE_OP_DIV 8
+#define RULE_OP_ADD 9
+#define RULE_OP_SUB 10
+#define RULE_OP_LT 11
+#define RULE_OP_LE 12
+#define RULE_OP_GT 13
+#define RULE_OP_GE 14
+#define RULE_OP_EQ 15
+#define RULE_OP_NE 16
+#define RULE_OP_AND 17
+#define RULE_OP_OR 18
+#define RULE_OP_LEFT 19 // compiler only
+#define RULE_SETTINGS_SIZE (SETTINGS_ENTRY(6, SETTINGS_STRING(RULE_TEXT_SIZE)) + SETTINGS_ENTRY(6, SETTINGS_UINT8) * 2)
 
 /* NetworkManager */
 #define NETWORK_OFF 0
@@ -102,6 +353,7 @@
 #define NETWORK_AUTO 3
 #define NETWORK_SSID_PASS_SIZE 15
 #define NETWORK_RECONNECT_TIME 20 // sec
+#define NETWORK_SETTINGS_SIZE (SETTINGS_ENTRY(3, SETTINGS_UINT8) + SETTINGS_ENTRY(4, SETTINGS_STRING(NETWORK_SSID_PASS_SIZE)) * 4)
 
 #define UDP_RESEND_TIME 5 //sec
 #define NTP_SERVER "time.nist.gov"
@@ -120,11 +372,14 @@
 #define BLYNK_AUTH_SIZE 35
 #define BLYNK_ELEMENT_CODE_SIZE 10
 #define BLYNK_RECONNECT_TIME 20 // sec
+#define BLYNK_SETTINGS_SIZE (SETTINGS_ENTRY(3, SETTINGS_BOOL) + SETTINGS_ENTRY(5, SETTINGS_UINT8) + SETTINGS_ENTRY(3, SETTINGS_STRING(BLYNK_AUTH_SIZE)) + \
+	(SETTINGS_ENTRY(6, SETTINGS_UINT8) + SETTINGS_ENTRY(6, SETTINGS_STRING(BLYNK_ELEMENT_CODE_SIZE))) * BLYNK_LINKS_MAX) // two digit link index
 
 /* --- Macro functions --- */
 #define SEC_TO_MLS(TIME) ((TIME) * 1000)
 #define MIN_TO_MLS(TIME) ((TIME) * 60000)
 #define IS_EVEN_SECOND(MLS) ((MLS / 1000) % 2)
+#define IS_DS18B20_FAULT(STATUS) ((STATUS) >= DS18B20_STATUS_STUCK && (STATUS) <= DS18B20_STATUS_PAIR)
 
 const uint8_t wifi[] = {0b00000, 0b01110, 0b10001, 0b00100, 0b01010, 0b00000, 0b00100, 0b00000};
 const uint8_t down_symbol[] = {0b00000, 0b00000, 0b00000, 0b00000, 0b00000, 0b10001, 0b01010, 0b00100};
@@ -145,19 +400,111 @@ struct ds18b20_data_t {
 		strcpy(name, other.name);
 		memcpy(address, other.address, sizeof(DeviceAddress));
 		resolution = other.resolution;
+		auto_resolution_flag = other.auto_resolution_flag;
+		read_time = other.read_time;
+		adaptive_flag = other.adaptive_flag;
+		bus = other.bus;
 		correction = other.correction;
+		filter_median = other.filter_median;
+		filter_ema = other.filter_ema;
+		filter_slew = other.filter_slew;
+		pair = other.pair;
+		dirty_flag = other.dirty_flag;
 
-		t = other.t;
-		status = other.status;
+		crc_errors = other.crc_errors;
 	}
 	
 	char name[DS_NAME_SIZE];
 	DeviceAddress address;
 	uint8_t resolution;
-	float correction;
+	bool auto_resolution_flag;
+	uint8_t read_time; // sec
+	bool adaptive_flag;
+	uint8_t bus;
+	int16_t correction; // c°
+	uint8_t filter_median; // samples
+	uint8_t filter_ema;
+	uint8_t filter_slew; // 0.1°/sec
+	int8_t pair; // -1 - none
+	bool dirty_flag;
 	
-	float t;
+	uint16_t crc_errors;
+};
+
+struct ds18b20_bus_device_t {
+	void operator=(const ds18b20_bus_device_t& other) {
+		memcpy(address, other.address, sizeof(DeviceAddress));
+		bus = other.bus;
+		family = other.family;
+		parasite_flag = other.parasite_flag;
+		t = other.t;
+	}
+
+	DeviceAddress address;
+	uint8_t bus;
+	uint8_t family;
+	bool parasite_flag;
+	int16_t t; // c°, last broadcast conversion
+};
+
+struct ds18b20_bus_event_t {
+	DeviceAddress address;
+	uint8_t bus;
+	uint8_t type;
+	uint32_t time;
+};
+
+struct sensor_sample_t {
+	int32_t value; // hundredths of the unit
+	int32_t raw; // before filtering
+	uint32_t time; // mls
+	uint8_t quality; // 0 - ok, else driver status
+	uint8_t type;
+	uint8_t source;
+	const char* name; // added drivers only
+};
+
+struct solar_channel_t {
+	int8_t source; // ds18b20 index
+	int8_t sink; // ds18b20 index
+	uint8_t on_delta; // °
+	uint8_t off_delta; // °
+	uint8_t error_policy;
+};
+
+struct solar_channel_state_t {
+	int16_t delta; // centi, source - sink
 	uint8_t status;
+	bool rele_flag;
+	uint8_t reason;
+};
+
+struct solar_snapshot_t {
+	uint32_t sequence; // increments with every rebuild
+	int16_t battery_t; // centi
+	int16_t boiler_t; // centi
+	int16_t exit_t; // centi
+	int16_t delta; // centi, battery - boiler
+	uint8_t battery_status;
+	uint8_t boiler_status;
+	uint8_t exit_status;
+	uint8_t flow_status;
+	uint8_t status;
+	bool rele_flag;
+	uint8_t reason;
+
+	// channel 0 is the battery - boiler pair above
+	uint8_t channels_count;
+	solar_channel_state_t channels[SOLAR_CHANNELS_COUNT];
+};
+
+struct i2c_device_t {
+	uint8_t address;
+	uint32_t transactions;
+	uint16_t naks;
+	uint16_t errors;
+	uint16_t latency; // mcs, last transaction
+	uint16_t latency_max; // mcs
 };
 
 struct blynk_element_t {
@@ -243,6 +590,155 @@ private:
 	uint32_t ntp_sync_timer;
 };
 
+class I2CManager {
+public:
+	I2CManager();
+	void begin();
+
+	void tick();
+	void makeDefault();
+
+	uint8_t write(uint8_t address, const uint8_t* data, uint8_t length, uint8_t priority = I2C_PRIORITY_SENSOR);
+	uint8_t read(uint8_t address, uint8_t* data, uint8_t length, uint8_t priority = I2C_PRIORITY_SENSOR);
+	void reserve(uint32_t time);
+	void resetStats();
+
+	uint32_t getBudget(uint8_t priority);
+	uint8_t getDevicesCount();
+	i2c_device_t* getDevice(uint8_t index);
+
+private:
+	void addStats(uint8_t address, uint8_t status, uint32_t latency, uint8_t priority);
+
+	i2c_device_t devices[I2C_DEVICES_MAX_COUNT];
+	uint8_t devices_count;
+
+	uint32_t tick_time; // mcs, spent by the display in this tick
+	uint32_t reserve_timer; // mcs
+	uint32_t reserve_time; // mcs
+};
+
+class SensorsManager;
+class SensorDriver {
+public:
+	// poll() does one bounded step per tick, blocking waits are not allowed
+	virtual void begin(SystemManager* system) = 0;
+	virtual bool start() = 0;
+	virtual bool poll() = 0;
+	virtual void collect(SensorsManager* sensors) = 0;
+	virtual uint32_t getPeriod() { return 0; } // mls, 0 - read data time
+};
+
+class AM2320Driver : public SensorDriver {
+public:
+	AM2320Driver();
+	void begin(SystemManager* system);
+	bool start();
+	bool poll();
+	void collect(SensorsManager* sensors);
+	void resetStats();
+
+	uint16_t getCrcErrors();
+	uint16_t getTimeouts();
+	uint32_t getTransactions();
+
+private:
+	void parse(uint8_t* data);
+	void fail(uint8_t status);
+	uint16_t calcCrc(uint8_t* data, uint8_t length);
+
+	I2CManager* i2c;
+
+	uint8_t state;
+	uint8_t errors;
+	uint32_t timer; // mcs
+	uint32_t offline_timer;
+	bool ready_flag;
+
+	int16_t t; // c°
+	int16_t h; // c%
+	uint8_t status;
+	uint16_t crc_errors;
+	uint16_t timeouts;
+	uint32_t transactions;
+};
+
+class FlowMeterDriver : public SensorDriver {
+public:
+	FlowMeterDriver();
+	void begin(SystemManager* system);
+	bool start();
+	bool poll();
+	void collect(SensorsManager* sensors);
+	uint32_t getPeriod();
+
+	void setPort(uint8_t port);
+	void setPulses(uint16_t pulses);
+	void setVolume(uint32_t volume);
+
+	uint8_t getPort();
+	uint16_t getPulses();
+	int32_t getRate();
+	uint32_t getVolume();
+
+private:
+	static void pulseInterrupt();
+
+	// written only by the isr, the loop takes differences
+	static volatile uint32_t pulses_count;
+
+	uint8_t port;
+	uint16_t pulses; // per liter
+
+	uint32_t last_count;
+	uint32_t window_timer;
+	uint32_t volume_pulses; // below one liter
+	uint32_t volume; // l
+	int32_t rate; // c l/min
+	bool ready_flag;
+};
+
+class AnalogDriver : public SensorDriver {
+public:
+	AnalogDriver();
+	void begin(SystemManager* system);
+	bool start();
+	bool poll();
+	void collect(SensorsManager* sensors);
+	void makeDefault();
+
+	void setWorkFlag(bool work_flag);
+	void setType(uint8_t type);
+	void setPointsCount(uint8_t count);
+	void setPoint(uint8_t index, uint16_t raw, int32_t value);
+
+	bool getWorkFlag();
+	uint8_t getType();
+	uint8_t getPointsCount();
+	uint16_t getPointRaw(uint8_t index);
+	int32_t getPointValue(uint8_t index);
+	uint16_t getRaw();
+	int32_t getValue();
+
+private:
+	int32_t calibrate(uint16_t raw);
+
+	bool work_flag;
+	uint8_t type;
+	uint8_t points_count; // 2 - linear, more - table
+
+	// raw ascending, values in hundredths of the unit
+	uint16_t points_raw[ANALOG_POINTS_COUNT];
+	int32_t points_value[ANALOG_POINTS_COUNT];
+
+	bool burst_flag;
+	uint8_t reads;
+	uint32_t accumulator;
+	uint32_t read_timer; // mcs
+	uint16_t raw;
+	bool ready_flag;
+};
+
 class SensorsManager {
 public:
 	SensorsManager();
@@ -259,59 +755,454 @@ public:
 #endif
 
 	void updateSensorsData();
+	bool addDriver(SensorDriver* driver);
+	void setSample(uint8_t source, uint8_t type, int32_t value, uint8_t quality, const char* name = NULL);
 	bool addDS18B20();
 	bool deleteDS18B20(uint8_t index);
 
-	uint8_t makeDS18B20AddressList(DynamicArray<DeviceAddress>* array, DynamicArray<float>* t_array = NULL, DynamicArray<String>* string_array = NULL);
+	void rescanDS18B20Bus();
+	void invalidateDS18B20Bus();
+	void verifyDS18B20Config();
+	void saveDS18B20Config();
+
+	uint8_t makeDS18B20AddressList(DynamicArray<DeviceAddress>* array, DynamicArray<int16_t>* t_array = NULL, DynamicArray<String>* string_array = NULL);
 	int8_t scanDS18B20AddressIndex(DynamicArray<DeviceAddress>* array, uint8_t* address);
+	void DS18B20AddressToString(uint8_t* address, String* string);
+	void resetStats();
 	
 	void setSystemManager(SystemManager* system);
 	void setReadDataTime(uint8_t time);
+	void setAutoResolutionRatio(uint8_t ratio);
+	void setCrcPeriod(uint8_t period);
+	void setAdaptiveRate(uint8_t rate);
+	void setAlarmBand(uint8_t band);
+	void setFaultStuckCount(uint8_t count);
+	void setFaultRate(uint8_t rate);
+	void setFaultPairDelta(uint8_t delta);
+	void setDS18B20BusPort(uint8_t bus, uint8_t port);
+	void setFlowPort(uint8_t port);
+	void setFlowPulses(uint16_t pulses);
+	void setAnalogWorkFlag(bool work_flag);
 
 	void setDS18B20(uint8_t index, ds18b20_data_t* ds18b20);
 	void setDS18B20Name(uint8_t index, String name);
 	void setDS18B20Address(uint8_t index, uint8_t* address);
 	void setDS18B20Resolution(uint8_t index, uint8_t resolution);
+	void setDS18B20AutoResolutionFlag(uint8_t index, bool auto_resolution_flag);
+	void setDS18B20ReadTime(uint8_t index, uint8_t time);
+	void setDS18B20AdaptiveFlag(uint8_t index, bool adaptive_flag);
+	void setDS18B20Bus(uint8_t index, uint8_t bus);
 	void setDS18B20Correction(uint8_t index, float correction);
+	void setDS18B20CorrectionCenti(uint8_t index, int16_t correction);
+	void setDS18B20FilterMedian(uint8_t index, uint8_t median);
+	void setDS18B20FilterEma(uint8_t index, uint8_t ema);
+	void setDS18B20FilterSlew(uint8_t index, uint8_t slew);
+	void setDS18B20Pair(uint8_t index, int8_t pair);
 
-	DallasTemperature* getDallasTemperature();
+	DallasTemperature* getDallasTemperature(uint8_t bus = 0);
 	uint8_t getReadDataTime();
+	uint8_t getAutoResolutionRatio();
+	uint8_t getCrcPeriod();
+	uint8_t getAdaptiveRate();
+	uint8_t getAlarmBand();
+	uint8_t getFaultStuckCount();
+	uint8_t getFaultRate();
+	uint8_t getFaultPairDelta();
+	uint8_t getDS18B20BusCount();
+	uint8_t getDS18B20BusPort(uint8_t bus);
+	uint8_t getFlowPort();
+	uint16_t getFlowPulses();
+	uint32_t getFlowVolume();
+	AnalogDriver* getAnalogDriver();
 
 	float getAM2320T();
 	float getAM2320H();
+	int16_t getAM2320TCenti();
+	int16_t getAM2320HCenti();
 	uint8_t getAM2320Status();
+	uint16_t getAM2320CrcErrors();
+	uint16_t getAM2320Timeouts();
+
+	uint32_t getTickTime();
+	uint32_t getTickTimeAverage();
+	uint32_t getTickTimeMax();
+	uint32_t getOneWireTransactions();
+	uint32_t getI2cTransactions();
+
+	uint8_t getSamplesCount();
+	uint32_t getSamplesVersion();
+	sensor_sample_t* getSample(uint8_t source);
 
 	uint8_t getGlobalDS18B20Count();
-	float getDS18B20TByAddress(uint8_t* address);
+	ds18b20_bus_device_t* getGlobalDS18B20(uint8_t index);
+	uint32_t getDS18B20BusScanTime(uint8_t bus);
+	bool getDS18B20BusScanFlag();
+	uint16_t getDS18B20BusVersion();
+	uint8_t getDS18B20BusEventsCount();
+	ds18b20_bus_event_t* getDS18B20BusEvent(uint8_t index);
+	int16_t getDS18B20TByAddress(uint8_t* address);
 	uint8_t getDS18B20Count();
 	ds18b20_data_t* getDS18B20(uint8_t index);
 	char* getDS18B20Name(uint8_t index);
 	uint8_t* getDS18B20Address(uint8_t index);
-	uint8_t getDS18B20Resolution(uint8_t index, bool sync_flag = true);
+	uint8_t getDS18B20Resolution(uint8_t index);
+	bool getDS18B20AutoResolutionFlag(uint8_t index);
+	uint8_t getDS18B20AutoResolution(uint8_t index);
+	uint8_t getDS18B20ReadTime(uint8_t index);
+	bool getDS18B20AdaptiveFlag(uint8_t index);
+	uint8_t getDS18B20Bus(uint8_t index);
+	uint32_t getDS18B20ReadInterval(uint8_t index);
+	uint32_t getDS18B20ReadIntervalMax();
 	float getDS18B20Correction(uint8_t index);
+	uint8_t getDS18B20FilterMedian(uint8_t index);
+	uint8_t getDS18B20FilterEma(uint8_t index);
+	uint8_t getDS18B20FilterSlew(uint8_t index);
+	int8_t getDS18B20Pair(uint8_t index);
 	float getDS18B20T(uint8_t index);
+	int16_t getDS18B20TCenti(uint8_t index);
+	int16_t getDS18B20RawTCenti(uint8_t index);
 	uint8_t getDS18B20Status(uint8_t index);
+	String getDS18B20StatusString(uint8_t index);
+	uint16_t getDS18B20CrcErrors(uint8_t index);
 
 private:
+	void driversTick();
+	void beginDS18B20Bus(uint8_t bus);
+	void ds18b20Tick(uint8_t bus);
+	void scheduleDS18B20(uint8_t bus);
+	bool requestDS18B20Conversion(uint8_t bus, uint16_t mask);
+	bool readNextDS18B20(uint8_t bus, uint8_t max_resolution);
+	uint8_t readDS18B20(uint8_t bus, uint8_t index);
+	void startDS18B20Transfer(uint8_t bus, uint8_t owner, uint8_t index, uint8_t* address, uint8_t command, const uint8_t* data, uint8_t write_length, uint8_t read_length);
+	uint8_t transferDS18B20(uint8_t bus);
+	int16_t convertDS18B20Raw(uint8_t* scratchpad, uint8_t family, uint8_t resolution);
+	void publishDS18B20Data(uint8_t bus);
+	void adaptDS18B20Interval(uint8_t index, int16_t t, uint32_t period);
+	int16_t filterDS18B20(uint8_t index, int16_t t);
+	void resetDS18B20Filter(uint8_t index);
+	uint8_t checkDS18B20Fault(uint8_t index, int16_t t);
+	void resetDS18B20Schedule();
+	uint8_t getReadyResolution(uint32_t convert_time);
+	void startDS18B20AlarmSearch(uint8_t bus);
+	void alarmDS18B20(uint8_t bus);
+	void finishDS18B20AlarmSearch(uint8_t bus, bool complete_flag);
+	void updateDS18B20Alarm(uint8_t index);
+	bool armDS18B20Alarm(uint8_t bus);
+
+	void startDS18B20Search(uint8_t bus);
+	bool isDS18B20SearchTick(uint8_t bus);
+	void discoverDS18B20(uint8_t bus);
+	bool searchDS18B20Bit(uint8_t bus, bool alarm_flag = false);
+	bool addDS18B20SearchResult(uint8_t bus);
+	void endDS18B20SearchPass(uint8_t bus);
+	void finishDS18B20Search(uint8_t bus, bool complete_flag);
+	void addDS18B20BusEvent(uint8_t bus, uint8_t* address, uint8_t type);
+	void checkDS18B20Bus(uint8_t bus);
+	void syncDS18B20Config(uint8_t bus);
+	void finishDS18B20Config(uint8_t bus);
+	uint16_t getDS18B20BusMask(uint8_t bus);
+	int8_t findDS18B20Bus(uint8_t* address);
+
 	bool isCorrectDS18B20Index(uint8_t index);
-	void DS18B20AddressToString(uint8_t* address, String* string);
 
-	AM2320 am2320_sensor;
-	OneWire oneWire;
-	DallasTemperature ds18b20_sensor;
+	OneWire oneWire[DS18B20_BUS_COUNT];
+	DallasTemperature ds18b20_sensor[DS18B20_BUS_COUNT];
 	SystemManager* system;
 
 	uint8_t read_data_time;
+	uint8_t auto_resolution_ratio;
+	uint8_t crc_period;
+	uint8_t adaptive_rate;
+	uint8_t alarm_band;
+	uint8_t fault_stuck_count;
+	uint8_t fault_rate;
+	uint8_t fault_pair_delta;
+
+	AM2320Driver am2320;
+	FlowMeterDriver flow;
+	AnalogDriver analog;
+	SensorDriver* drivers[SENSOR_DRIVERS_MAX_COUNT];
+	uint32_t drivers_timer[SENSOR_DRIVERS_MAX_COUNT];
+	uint8_t drivers_count;
+
+	// every consumer reads values from here
+	sensor_sample_t samples[SENSOR_SAMPLES_COUNT];
+	uint32_t samples_version; // changes with every published sample
+	DynamicArray<ds18b20_data_t> ds18b20_data;
 
-	struct am2320_data_t {
-		float t;
-		float h;
-		uint8_t status;
+	struct ds18b20_bus_t {
+		uint8_t port;
+		DynamicArray<ds18b20_bus_device_t> devices;
+		bool valid_flag;
+		uint32_t scan_timer;
+	} ds18b20_bus[DS18B20_BUS_COUNT];
+
+	struct ds18b20_bus_log_t {
+		uint16_t version;
+
+		ds18b20_bus_event_t events[DS18B20_BUS_EVENTS_COUNT];
+		uint8_t events_head;
+		uint8_t events_count;
+	} ds18b20_bus_log;
+
+	struct ds18b20_search_t {
+		uint8_t state;
+		DeviceAddress rom;
+		uint8_t bit;
+		uint8_t last_discrepancy;
+		uint8_t last_zero;
+		DynamicArray<ds18b20_bus_device_t> devices;
+	};
+	ds18b20_search_t ds18b20_search[DS18B20_BUS_COUNT];
+	ds18b20_search_t ds18b20_alarm_search[DS18B20_BUS_COUNT]; // devices are not used
+
+	struct ds18b20_pipeline_t {
+		uint8_t state;
+		uint8_t cycle;
+		uint16_t cycle_mask;
+		uint16_t read_mask;
+		uint16_t retry_mask;
+		uint16_t alarm_mask;
+		uint16_t quiet_mask;
+		uint8_t refresh_index;
+		uint16_t convert_time;
+		uint32_t convert_timer;
+		uint32_t config_sync_timer;
+	} ds18b20_pipeline[DS18B20_BUS_COUNT];
+
+	// one match rom exchange spread over ticks, only one owner uses the bus at a time
+	struct ds18b20_transfer_t {
+		uint8_t state;
+		uint8_t owner;
+		uint8_t index; // sensor or search result
+		DeviceAddress address; // zeros - skip rom
+		uint8_t command;
+		uint8_t data[9];
+		uint8_t write_length;
+		uint8_t read_length;
+		uint8_t position; // 0 - reset, then rom, command and data bytes
+		uint32_t copy_timer; // mls, the eeprom copy holds the bus
+	} ds18b20_transfer[DS18B20_BUS_COUNT];
+
+	struct ds18b20_schedule_t {
+		uint16_t verify_mask;
+		uint32_t config_verify_timer;
+
+		// resolutions written to the scratchpad only, copied to the eeprom on a user save
+		uint16_t unsaved_mask;
+		uint16_t save_mask;
+
+		// sensors with th/tl programmed around the last value
+		uint16_t armed_mask;
+		uint16_t arm_mask;
+		int8_t alarm_high[DS_SENSORS_MAX_COUNT]; // °
+		int8_t alarm_low[DS_SENSORS_MAX_COUNT]; // °
+
+		uint8_t resolution[DS_SENSORS_MAX_COUNT];
+		int16_t t[DS_SENSORS_MAX_COUNT];
+
+		uint32_t read_timer[DS_SENSORS_MAX_COUNT];
+		uint32_t read_interval[DS_SENSORS_MAX_COUNT]; // mls, 0 - read time
+	} ds18b20_schedule;
+
+	// median -> slew -> ema, only valid samples pass through
+	struct ds18b20_filter_t {
+		int16_t history[DS18B20_FILTER_MEDIAN_MAX]; // c°
+		uint8_t head;
+		uint8_t count;
+		int32_t ema; // c° << DS18B20_FILTER_EMA_SHIFT
+		int16_t output; // c°
+		uint32_t time; // mls, 0 - empty
+	} ds18b20_filter[DS_SENSORS_MAX_COUNT];
+
+	struct ds18b20_fault_t {
+		int16_t t; // c°, last raw value
+		uint8_t same_count;
+		uint32_t time; // mls, 0 - empty
+	} ds18b20_fault[DS_SENSORS_MAX_COUNT];
+
+	struct sensors_stats_t {
+		uint32_t tick_time; // mcs
+		uint32_t tick_time_average; // mcs
+		uint32_t tick_time_max; // mcs
+		uint32_t onewire_transactions;
+	} stats;
+};
 
-	} am2320_data;
-	DynamicArray<ds18b20_data_t> ds18b20_data;
+class ReleDriver {
+public:
+	ReleDriver();
+	void begin(SystemManager* system, uint8_t port, uint8_t index);
+
+	void tick();
+	void makeDefault();
+
+	void request(bool flag);
+	void override(bool flag);
+	void release();
+	void stop();
+	void loadStats(uint32_t cycles, uint32_t on_time, uint32_t change_time);
+	void resetStats();
+
+	void setPort(uint8_t port);
+	void setInvertFlag(bool invert_flag);
+	void setMinOnTime(uint16_t time);
+	void setMinOffTime(uint16_t time);
+	void setMaxRate(uint8_t rate);
+	void setOverrideTime(uint8_t time);
+
+	bool getState();
+	bool getOverrideFlag();
+	uint8_t getPort();
+	bool getInvertFlag();
+	uint16_t getMinOnTime();
+	uint16_t getMinOffTime();
+	uint8_t getMaxRate();
+	uint8_t getOverrideTime();
+	uint32_t getCycles();
+	uint32_t getOnTime();
+	uint32_t getChangeTime();
+
+private:
+	bool isChangeAllowed();
+	void apply(bool flag);
+	void write();
+	void saveStats();
+	uint32_t calcStatsChecksum();
+
+	SystemManager* system;
+	uint8_t port;
+	uint8_t index;
+
+	bool invert_flag;
+	uint16_t min_on_time; // sec
+	uint16_t min_off_time; // sec
+	uint8_t max_rate; // starts per hour
+	uint8_t override_time; // min
+
+	bool state;
+	bool auto_flag;
+	bool override_flag;
+	bool override_state;
+	uint8_t output; // written port level
+
+	uint32_t change_timer;
+	uint32_t start_timer;
+	uint32_t override_timer;
+	uint32_t on_timer; // on time not counted yet
+	uint32_t rtc_timer;
+	uint32_t flush_timer;
+	bool flush_flag;
+
+	// survives a soft reset in the rtc memory
+	struct rele_stats_t {
+		uint32_t magic;
+		uint32_t cycles;
+		uint32_t on_time; // sec
+		uint32_t change_time; // unix
+		uint32_t checksum;
+	} stats;
+};
+
+class EnergyMeter {
+public:
+	EnergyMeter();
+	void begin(SystemManager* system);
+
+	void tick(const solar_snapshot_t* snapshot, int32_t flow);
+	void makeDefault();
+
+	void loadStats(uint32_t day, uint32_t month, uint32_t lifetime, uint32_t date);
+	void resetStats();
+
+	void setWorkFlag(bool work_flag);
+	void setFlow(uint16_t flow);
+	void setCapacity(uint16_t capacity);
+
+	bool getWorkFlag();
+	uint16_t getFlow();
+	uint16_t getCapacity();
+	uint32_t getPower();
+	uint32_t getDay();
+	uint32_t getMonth();
+	uint32_t getLifetime();
+	uint32_t getDate();
+
+private:
+	void rollover();
+	void saveStats();
+	uint32_t calcStatsChecksum();
+	uint32_t getStepMax();
 
-	uint32_t read_data_timer;
+	SystemManager* system;
+
+	bool work_flag;
+	uint16_t flow; // centi l/min
+	uint16_t capacity; // J/(l·K)
+
+	// the inputs of the last sample, integrated up to the next one
+	int32_t delta_t; // centi
+	int32_t sample_flow; // centi l/min
+	uint32_t timer;
+	uint32_t power; // W
+	uint32_t remainder; // J / ENERGY_SCALE
+
+	uint32_t rtc_timer;
+	uint32_t flush_timer;
+	bool flush_flag;
+
+	// survives a soft reset in the rtc memory
+	struct energy_stats_t {
+		uint32_t magic;
+		uint32_t day; // Wh
+		uint32_t month; // Wh
+		uint32_t lifetime; // Wh
+		uint32_t joules; // below 1 Wh
+		uint32_t date; // yyyymmdd of the day counter
+		uint32_t checksum;
+	} stats;
+};
+
+struct rule_op_t {
+	uint8_t code;
+	int32_t arg;
+};
+
+struct rule_context_t {
+	SensorsManager* sensors;
+	const solar_snapshot_t* snapshot;
+	uint8_t hour;
+	uint8_t minute;
+	bool time_flag; // the clock is set
+};
+
+class RuleEngine {
+public:
+	RuleEngine();
+
+	bool compile(const char* text);
+	bool evaluate(rule_context_t* context, int32_t* result);
+	void clear();
+
+	const char* getText();
+	bool isCompiled();
+	uint8_t getError();
+	uint8_t getLength();
+	uint16_t getTime();
+
+private:
+	bool parseOperand(const char** pointer);
+	uint8_t parseOperator(const char** pointer);
+	uint8_t getPriority(uint8_t code);
+	bool emit(uint8_t code, int32_t arg = 0);
+	int32_t saturate(int64_t value);
+
+	char text[RULE_TEXT_SIZE];
+	rule_op_t code[RULE_CODE_SIZE];
+	uint8_t length;
+	uint8_t depth; // compiler, values on the stack
+	uint8_t error; // text position + 1
+	uint16_t time; // mcs, last evaluation
 };
 
 class SolarSystemManager {
@@ -337,6 +1228,18 @@ public:
 	void setReleInvertFlag(bool rele_invert_flag);
 	void setDelta(uint8_t delta);
 
+	void setChannelsCount(uint8_t count);
+	void setChannelSource(uint8_t channel, int8_t ds18b20_index);
+	void setChannelSink(uint8_t channel, int8_t ds18b20_index);
+	void setChannelOnDelta(uint8_t channel, uint8_t delta);
+	void setChannelOffDelta(uint8_t channel, uint8_t delta);
+	void setChannelErrorPolicy(uint8_t channel, uint8_t policy);
+	void setChannelReleFlag(uint8_t channel, bool rele_flag);
+
+	void setRule(uint8_t index, const char* text);
+	void setRuleChannel(uint8_t index, uint8_t channel);
+	void setRuleAction(uint8_t index, uint8_t action);
+
 	void setSensor(uint8_t solar_sensor, int8_t ds18b20_index);
 	void setBatterySensor(int8_t ds18b20_index);
 	void setBoilerSensor(int8_t ds18b20_index);
@@ -344,16 +1247,35 @@ public:
 
 	SystemManager* getSystemManager();
 	uint8_t getStatus();
+	const solar_snapshot_t* getSnapshot();
+	String getReasonString(uint8_t channel = 0);
 
 	bool getReleFlag();
 	bool getWorkFlag();
 	bool getErrorOnFlag();
 	bool getReleInvertFlag();
 	uint8_t getDelta();
+	uint8_t getHysteresis();
+	ReleDriver* getReleDriver(uint8_t channel = 0);
+	EnergyMeter* getEnergyMeter();
+
+	uint8_t getChannelsCount();
+	int8_t getChannelSource(uint8_t channel);
+	int8_t getChannelSink(uint8_t channel);
+	uint8_t getChannelOnDelta(uint8_t channel);
+	uint8_t getChannelOffDelta(uint8_t channel);
+	uint8_t getChannelErrorPolicy(uint8_t channel);
+	uint8_t getSensorHysteresis(int8_t ds18b20_index);
+
+	RuleEngine* getRule(uint8_t index);
+	uint8_t getRuleChannel(uint8_t index);
+	uint8_t getRuleAction(uint8_t index);
+	String getRuleStatusString(uint8_t index);
 	
 	uint8_t getBatterySensorStatus();
 	uint8_t getBoilerSensorStatus();
 	uint8_t getExitSensorStatus();
+	uint8_t getFlowStatus();
 
 	int8_t getSensor(uint8_t solar_sensor);
 	int8_t getBatterySensor();
@@ -363,23 +1285,42 @@ public:
 	float getBatteryT();
 	float getBoilerT();
 	float getExitT();
+	int16_t getBatteryTCenti();
+	int16_t getBoilerTCenti();
+	int16_t getExitTCenti();
 
 private:
-	void releTick();
+	void flowTick();
+	void channelTick(uint8_t channel, solar_snapshot_t* next, int8_t rule_action);
+	void rulesTick(solar_snapshot_t* next, int8_t* actions);
+	void buildSnapshot(solar_snapshot_t* next);
+	uint8_t readSensorStatus(int8_t ds18b20_index);
+	int16_t readSensorTCenti(int8_t ds18b20_index);
+	uint8_t readFlowStatus();
+	uint32_t getFlowRetryTime();
 
 	SystemManager* system;
+	ReleDriver rele[SOLAR_CHANNELS_COUNT];
+	EnergyMeter energy;
+	solar_snapshot_t snapshot;
 
 	bool work_flag;
-	bool error_on_flag;
-	bool rele_invert_flag;
-	uint8_t delta;
+	uint8_t channels_count;
+	solar_channel_t channels[SOLAR_CHANNELS_COUNT];
+
+	RuleEngine rules[SOLAR_RULES_COUNT];
+	uint8_t rules_channel[SOLAR_RULES_COUNT];
+	uint8_t rules_action[SOLAR_RULES_COUNT];
 
-	int8_t battery_sensor_index;
-	int8_t boiler_sensor_index;
 	int8_t exit_sensor_index;
 
-	bool rele_flag;
-	
+	uint32_t flow_timer; // mls, last flow or pump off
+	uint32_t flow_lock_timer; // mls, the pump was stopped without flow
+	bool flow_lock_flag;
+	uint8_t flow_retry_count; // dry runs since the last flow
+
+	uint32_t samples_version;
+	bool update_flag;
 };
 
 #include "display.h"
@@ -453,6 +1394,7 @@ private:
 	struct web_sensors_block_t {
 		String ds18b20_addresses_string;
 		DynamicArray<DeviceAddress> ds18b20_addresses;
+		uint16_t bus_version;
 	};
 
 	/* --- variables --- */
@@ -559,13 +1501,16 @@ public:
 	DisplayManager* getDisplayManager();
 	NetworkManager* getNetworkManager();
 	BlynkManager* getBlynkManager();
+	I2CManager* getI2CManager();
 	Encoder* getEncoder();
 
 private:
 	// SystemManager does not support Blynk elements
 	void saveSettings(bool ignore_flag = false);
+	bool checkSettingsSize(char* buffer, uint16_t* length, uint16_t size);
 	void readSettings();
 
+	I2CManager i2c;
 	TimeManager time;
 	SensorsManager sensors;
 	SolarSystemManager solar;
@@ -596,6 +1541,61 @@ T1 smartIncr(T1& value, T2 incr_step, T3 min, T4 max) {
 	return value;
 }
 
+// value in hundredths, printed with 0-2 decimals without float math
+inline String centiToString(int32_t value, uint8_t decimals) {
+	char buffer[16];
+	char* pointer = buffer + sizeof(buffer) - 1;
+	uint32_t number = (value < 0) ? -value : value;
+
+	decimals = min(decimals, (uint8_t) 2);
+	if (decimals < 2) {
+		uint8_t divider = decimals ? 10 : 100;
+		number = (number + divider / 2) / divider;
+	}
+
+	bool negative_flag = (value < 0 && number);
+	*pointer = '\0';
+
+	for (uint8_t i = 0;i < decimals;i++) {
+		*--pointer = '0' + number % 10;
+		number /= 10;
+	}
+
+	if (decimals) {
+		*--pointer = '.';
+	}
+
+	do {
+		*--pointer = '0' + number % 10;
+		number /= 10;
+	} while (number);
+
+	if (negative_flag) {
+		*--pointer = '-';
+	}
+
+	return String(pointer);
+}
+
+inline const char* sensorTypeUnit(uint8_t type) {
+	switch (type) {
+	case SENSOR_TYPE_TEMPERATURE:
+		return "°";
+	case SENSOR_TYPE_HUMIDITY:
+		return "%";
+	case SENSOR_TYPE_PRESSURE:
+		return "bar";
+	case SENSOR_TYPE_FLOW:
+		return "l/min";
+	case SENSOR_TYPE_VOLUME:
+		return "l";
+	case SENSOR_TYPE_IRRADIANCE:
+		return "W/m2";
+	default:
+		return "";
+	}
+}
+
 template <class T>
 bool windowCursorTick(T& cursor, int8_t direct, uint8_t cursor_max) {
 	if (direct < 0) {
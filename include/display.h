@@ -10,8 +10,15 @@
 #pragma once
 
 /* --- Macroces --- */
+/* LcdManager */
+#define LCD_ADDRESS 0x27
+#define LCD_COLS 20
+#define LCD_ROWS 4
+#define LCD_SEND_TIME 700 // mcs, one command or character
+
 /* DisplayManager */
 #define DISPLAY_AUTO_RESET_TIME 30 // min
+#define DISPLAY_SETTINGS_SIZE (SETTINGS_ENTRY(4, SETTINGS_BOOL) + SETTINGS_ENTRY(5, SETTINGS_UINT8) + SETTINGS_ENTRY(3, SETTINGS_UINT8))
 
 /* SettingsWindow */
 #define SCREEN_EXIT_BUZZER_FREQ 200
@@ -22,11 +29,25 @@
 
 /* SetDS18B20AddressWindow */
 #define DS18B20_START_PRINT_BYTE 4 // byte [0 - 7]
+#define DS18B20_SCAN_RESULT_TIME 500 // mls
 
 
 class LcdManager : public LiquidCrystal_I2C {
 public:
 	LcdManager();
+	void init();
+
+	void flush(bool force_flag = false);
+	void setI2CManager(I2CManager* i2c);
+
+	// drawing goes to the frame, flush() sends the changed cells
+	using Print::write;
+	size_t write(uint8_t value);
+	void setCursor(uint8_t x, uint8_t y);
+	void clear();
+	void createChar(uint8_t location, const uint8_t* charmap);
+	void backlight();
+	void noBacklight();
 
 	void printTitle(uint8_t y, String title, uint16_t delay_time = 800, bool clear_flag = true);
 	void easyPrint(uint8_t x, uint8_t y, String string);
@@ -35,6 +56,19 @@ public:
 	void easyWrite(uint8_t x, uint8_t y, uint8_t code);
 	void clearLine(uint8_t line);
 	void clearColumn(uint8_t column);
+
+private:
+	bool send(uint8_t value, uint8_t mode);
+
+	I2CManager* i2c;
+
+	uint8_t frame[LCD_ROWS][LCD_COLS];
+	uint8_t screen[LCD_ROWS][LCD_COLS];
+	uint8_t cursor_x;
+	uint8_t cursor_y;
+	uint8_t address_x; // controller ddram address, LCD_COLS - unknown
+	uint8_t address_y;
+	uint8_t backlight_value;
 };
 
 
@@ -274,10 +308,12 @@ public:
 private:
 	bool print_flag = true;
 	bool scan_flag = true;
+	bool wait_flag = false;
 	uint8_t cursor = 0;
+	uint32_t result_timer = 0;
 
 	DynamicArray<DeviceAddress> ds18b20_addresses;
-	DynamicArray<float> t_array;
+	DynamicArray<int16_t> t_array;
 
 	uint8_t* config_address;
 };
@@ -678,6 +678,10 @@ bool DallasTemperature::isParasitePowerMode(void) {
 	return parasite;
 }
 
+void DallasTemperature::setParasitePowerMode(bool parasiteMode) {
+	parasite = parasiteMode;
+}
+
 // IF alarm is not used one can store a 16 bit int of userdata in the alarm
 // registers. E.g. an ID of the sensor.
 // See github issue #29
@@ -155,6 +155,9 @@ public:
 	// returns true if the bus requires parasite power
 	bool isParasitePowerMode(void);
 
+	// sets the power mode found without begin(), by a search of the caller
+	void setParasitePowerMode(bool);
+
 	// Is a conversion complete on the wire? Only applies to the first sensor on the wire.
 	bool isConversionComplete(void);
 
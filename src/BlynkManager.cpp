@@ -37,7 +37,7 @@ void BlynkManager::tick() {
 }
 
 void BlynkManager::makeDefault() {
-	links.~DynamicArray();
+	links.clear();
 
 	work_flag = DEFAULT_BLYNK_WORK_STATUS;
 	send_data_time = DEFAULT_BLYNK_SEND_DATA_TIME;
@@ -145,7 +145,8 @@ void BlynkManager::setAuth(String auth) {
 		return;
 	}
 	
-	strcpy(this->auth, auth.c_str());
+	strncpy(this->auth, auth.c_str(), BLYNK_AUTH_SIZE - 1);
+	this->auth[BLYNK_AUTH_SIZE - 1] = 0;
 }
 
 
@@ -162,7 +163,8 @@ void BlynkManager::setLinkElementCode(uint8_t index, String code) {
 		return;
 	}
 
-	strcpy(links[index].element_code, code.c_str());
+	strncpy(links[index].element_code, code.c_str(), BLYNK_ELEMENT_CODE_SIZE - 1);
+	links[index].element_code[BLYNK_ELEMENT_CODE_SIZE - 1] = 0;
 }
 
 
@@ -18,6 +18,7 @@ DisplayManager::~DisplayManager() {
 }
 
 void DisplayManager::begin() {
+	lcd.setI2CManager(system->getI2CManager());
 	lcd.init();
 	lcd.backlight();
 
@@ -56,6 +57,8 @@ void DisplayManager::tick() {
 		
 		window->print(getLcdManager(), this, getSystemManager());
 	}
+
+	lcd.flush();
 }
 
 void DisplayManager::makeDefault() {
@@ -0,0 +1,224 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * Author: Vereshchynskyi Nazar
+ * Email: verechnazar12@gmail.com
+ * Version: 1.3.1
+ * Date: 04.02.2025
+ */
+
+#include "data.h"
+
+EnergyMeter::EnergyMeter() {
+	makeDefault();
+}
+
+void EnergyMeter::begin(SystemManager* system) {
+	this->system = system;
+	timer = millis();
+
+	// a soft reset keeps the counters in the rtc memory
+	energy_stats_t rtc_stats;
+
+	if (ESP.rtcUserMemoryRead(ENERGY_RTC_OFFSET, (uint32_t*) &rtc_stats, sizeof(energy_stats_t))) {
+		energy_stats_t current_stats = stats;
+		stats = rtc_stats;
+
+		if (stats.magic != ENERGY_RTC_MAGIC || stats.checksum != calcStatsChecksum()) {
+			stats = current_stats;
+		}
+	}
+}
+
+
+void EnergyMeter::tick(const solar_snapshot_t* snapshot, int32_t flow) {
+	uint32_t step = millis() - timer;
+	timer = millis();
+
+	rollover();
+
+	// the last sample holds until this one
+	if (getWorkFlag() && delta_t > 0 && sample_flow > 0 && step <= getStepMax()) {
+		uint64_t energy = (uint64_t) delta_t * sample_flow * getCapacity() * step + remainder;
+		uint32_t joules = energy / ENERGY_SCALE;
+
+		remainder = energy % ENERGY_SCALE;
+		stats.joules += joules;
+
+		if (stats.joules >= 3600) {
+			uint32_t wh = stats.joules / 3600;
+
+			stats.joules %= 3600;
+			stats.day += wh;
+			stats.month += wh;
+			stats.lifetime += wh;
+			flush_flag = true;
+		}
+	}
+
+	// a failed sensor or a stopped pump moves no heat
+	bool valid_flag = snapshot->rele_flag && !snapshot->exit_status && !snapshot->boiler_status;
+
+	delta_t = valid_flag ? snapshot->exit_t - snapshot->boiler_t : 0;
+	sample_flow = valid_flag ? flow : 0;
+	power = (getWorkFlag() && delta_t > 0 && sample_flow > 0) ? (uint64_t) delta_t * sample_flow * getCapacity() * 1000 / ENERGY_SCALE : 0;
+
+	if ((power || flush_flag) && millis() - rtc_timer >= SEC_TO_MLS(ENERGY_RTC_TIME)) {
+		saveStats();
+	}
+
+	// the flash is written once an hour at most
+	if (flush_flag && system != NULL && millis() - flush_timer >= MIN_TO_MLS(ENERGY_FLUSH_TIME)) {
+		flush_timer = millis();
+		flush_flag = false;
+
+		saveStats();
+		system->saveSettingsRequest();
+	}
+}
+
+void EnergyMeter::makeDefault() {
+	system = NULL;
+
+	work_flag = DEFAULT_ENERGY_WORK_FLAG;
+	flow = DEFAULT_ENERGY_FLOW;
+	capacity = DEFAULT_ENERGY_CAPACITY;
+
+	delta_t = 0;
+	sample_flow = 0;
+	timer = 0;
+	power = 0;
+	remainder = 0;
+
+	rtc_timer = 0;
+	flush_timer = 0;
+	flush_flag = false;
+
+	memset(&stats, 0, sizeof(energy_stats_t));
+	stats.magic = ENERGY_RTC_MAGIC;
+	stats.checksum = calcStatsChecksum();
+}
+
+
+void EnergyMeter::loadStats(uint32_t day, uint32_t month, uint32_t lifetime, uint32_t date) {
+	// the rtc copy is newer than the flash one
+	if (stats.lifetime || stats.date) {
+		return;
+	}
+
+	stats.day = day;
+	stats.month = month;
+	stats.lifetime = lifetime;
+	stats.date = date;
+	saveStats();
+}
+
+void EnergyMeter::resetStats() {
+	stats.day = 0;
+	stats.month = 0;
+	stats.lifetime = 0;
+	stats.joules = 0;
+	remainder = 0;
+
+	saveStats();
+	flush_flag = true;
+}
+
+
+void EnergyMeter::setWorkFlag(bool work_flag) {
+	this->work_flag = work_flag;
+}
+
+void EnergyMeter::setFlow(uint16_t flow) {
+	this->flow = min(flow, (uint16_t) ENERGY_FLOW_MAX);
+}
+
+void EnergyMeter::setCapacity(uint16_t capacity) {
+	this->capacity = constrain(capacity, ENERGY_CAPACITY_MIN, ENERGY_CAPACITY_MAX);
+}
+
+
+bool EnergyMeter::getWorkFlag() {
+	return work_flag;
+}
+
+uint16_t EnergyMeter::getFlow() {
+	return flow;
+}
+
+uint16_t EnergyMeter::getCapacity() {
+	return capacity;
+}
+
+uint32_t EnergyMeter::getPower() {
+	return power;
+}
+
+uint32_t EnergyMeter::getDay() {
+	return stats.day;
+}
+
+uint32_t EnergyMeter::getMonth() {
+	return stats.month;
+}
+
+uint32_t EnergyMeter::getLifetime() {
+	return stats.lifetime;
+}
+
+uint32_t EnergyMeter::getDate() {
+	return stats.date;
+}
+
+
+void EnergyMeter::rollover() {
+	if (system == NULL) {
+		return;
+	}
+
+	TimeManager* time = system->getTimeManager();
+
+	// the counters wait for a valid clock
+	if (time->getStatus()) {
+		return;
+	}
+
+	uint32_t date = (uint32_t) time->year() * 10000 + time->month() * 100 + time->day();
+	if (date == stats.date) {
+		return;
+	}
+
+	if (date / 100 != stats.date / 100) {
+		stats.month = 0;
+	}
+
+	stats.day = 0;
+	stats.date = date;
+
+	// the finished day goes to the flash at once
+	saveStats();
+	flush_flag = false;
+	flush_timer = millis();
+	system->saveSettingsRequest();
+}
+
+void EnergyMeter::saveStats() {
+	rtc_timer = millis();
+	stats.magic = ENERGY_RTC_MAGIC;
+	stats.checksum = calcStatsChecksum();
+
+	ESP.rtcUserMemoryWrite(ENERGY_RTC_OFFSET, (uint32_t*) &stats, sizeof(energy_stats_t));
+}
+
+// without a flow meter the meter ticks with the samples, one of them may be missed
+uint32_t EnergyMeter::getStepMax() {
+	if (system == NULL) {
+		return ENERGY_STEP_MAX;
+	}
+
+	return max((uint32_t) ENERGY_STEP_MAX, system->getSensorsManager()->getDS18B20ReadIntervalMax() * 2);
+}
+
+uint32_t EnergyMeter::calcStatsChecksum() {
+	return stats.magic ^ stats.day ^ (stats.month << 1) ^ (stats.lifetime << 2) ^ (stats.joules << 3) ^ (stats.date << 4) ^ 0xFFFFFFFF;
+}
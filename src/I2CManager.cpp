@@ -0,0 +1,153 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * Author: Vereshchynskyi Nazar
+ * Email: verechnazar12@gmail.com
+ * Version: 1.3.1
+ * Date: 04.02.2025
+ */
+
+#include "data.h"
+
+I2CManager::I2CManager() {
+	makeDefault();
+}
+
+void I2CManager::begin() {
+	Wire.begin();
+}
+
+
+void I2CManager::tick() {
+	tick_time = 0;
+
+	if (reserve_time && micros() - reserve_timer >= reserve_time) {
+		reserve_time = 0;
+	}
+}
+
+void I2CManager::makeDefault() {
+	memset(devices, 0, sizeof(devices));
+	devices_count = 0;
+
+	tick_time = 0;
+	reserve_timer = 0;
+	reserve_time = 0;
+}
+
+
+uint8_t I2CManager::write(uint8_t address, const uint8_t* data, uint8_t length, uint8_t priority) {
+	uint32_t timer = micros();
+	uint8_t status;
+
+	Wire.beginTransmission(address);
+	Wire.write(data, length);
+	status = Wire.endTransmission();
+
+	// a zero length write only wakes a device, nobody has to answer
+	if (!length) {
+		status = 0;
+	}
+
+	addStats(address, status, micros() - timer, priority);
+	return status;
+}
+
+uint8_t I2CManager::read(uint8_t address, uint8_t* data, uint8_t length, uint8_t priority) {
+	uint32_t timer = micros();
+	uint8_t status = 0;
+
+	if (Wire.requestFrom(address, length) != length) {
+		status = I2C_ERROR_LENGTH;
+	}
+
+	for (uint8_t i = 0;i < length;i++) {
+		data[i] = Wire.available() ? Wire.read() : 0xFF;
+	}
+
+	addStats(address, status, micros() - timer, priority);
+	return status;
+}
+
+void I2CManager::reserve(uint32_t time) {
+	// a sensor needs the bus in time mcs, the display must be done by then
+	reserve_timer = micros();
+	reserve_time = time;
+}
+
+void I2CManager::resetStats() {
+	for (uint8_t i = 0;i < devices_count;i++) {
+		uint8_t address = devices[i].address;
+
+		memset(&devices[i], 0, sizeof(i2c_device_t));
+		devices[i].address = address;
+	}
+}
+
+
+uint32_t I2CManager::getBudget(uint8_t priority) {
+	// sensor transactions are never delayed
+	if (priority == I2C_PRIORITY_SENSOR) {
+		return UINT32_MAX;
+	}
+
+	uint32_t budget = (tick_time < I2C_TICK_BUDGET) ? I2C_TICK_BUDGET - tick_time : 0;
+
+	if (reserve_time) {
+		uint32_t passed = micros() - reserve_timer;
+		uint32_t left = (passed < reserve_time) ? reserve_time - passed : 0;
+
+		budget = min(budget, (left > I2C_RESERVE_GUARD) ? left - I2C_RESERVE_GUARD : 0);
+	}
+
+	return budget;
+}
+
+uint8_t I2CManager::getDevicesCount() {
+	return devices_count;
+}
+
+i2c_device_t* I2CManager::getDevice(uint8_t index) {
+	if (index >= devices_count) {
+		return NULL;
+	}
+
+	return &devices[index];
+}
+
+
+void I2CManager::addStats(uint8_t address, uint8_t status, uint32_t latency, uint8_t priority) {
+	i2c_device_t* device = NULL;
+
+	if (priority != I2C_PRIORITY_SENSOR) {
+		tick_time += latency;
+	}
+
+	for (uint8_t i = 0;i < devices_count;i++) {
+		if (devices[i].address == address) {
+			device = &devices[i];
+			break;
+		}
+	}
+
+	if (device == NULL) {
+		if (devices_count >= I2C_DEVICES_MAX_COUNT) {
+			return;
+		}
+
+		device = &devices[devices_count++];
+		device->address = address;
+	}
+
+	device->transactions++;
+	device->latency = min(latency, (uint32_t) UINT16_MAX);
+	device->latency_max = max(device->latency_max, device->latency);
+
+	// 2 - address nak, 3 - data nak
+	if (status == 2 || status == 3) {
+		device->naks++;
+	}
+	else if (status) {
+		device->errors++;
+	}
+}
@@ -9,16 +9,122 @@
 
 #include "data.h"
 
-LcdManager::LcdManager() : LiquidCrystal_I2C(0x27, 20, 4) {
+LcdManager::LcdManager() : LiquidCrystal_I2C(LCD_ADDRESS, LCD_COLS, LCD_ROWS) {
+	i2c = NULL;
+	backlight_value = LCD_NOBACKLIGHT;
 
+	memset(frame, ' ', sizeof(frame));
+	memset(screen, ' ', sizeof(screen));
+	cursor_x = 0;
+	cursor_y = 0;
+	address_x = LCD_COLS;
+	address_y = 0;
 }
 
+void LcdManager::init() {
+	LiquidCrystal_I2C::init();
+
+	// the controller is cleared, the whole frame is sent again
+	memset(screen, ' ', sizeof(screen));
+	address_x = LCD_COLS;
+}
+
+
+void LcdManager::flush(bool force_flag) {
+	const uint8_t row_offsets[] = {0x00, 0x40, 0x14, 0x54};
+
+	if (i2c == NULL) {
+		return;
+	}
+
+	for (uint8_t y = 0;y < LCD_ROWS;y++) {
+		for (uint8_t x = 0;x < LCD_COLS;x++) {
+			if (frame[y][x] == screen[y][x]) {
+				continue;
+			}
+
+			bool address_flag = (address_x != x || address_y != y);
+
+			// the rest of the frame waits for the next tick, sensors keep their timing
+			if (!force_flag && i2c->getBudget(I2C_PRIORITY_DISPLAY) < (address_flag ? 2 : 1) * LCD_SEND_TIME) {
+				return;
+			}
+
+			if (address_flag) {
+				if (!send(LCD_SETDDRAMADDR | (x + row_offsets[y]), 0)) {
+					return;
+				}
+
+				address_x = x;
+				address_y = y;
+			}
+
+			if (!send(frame[y][x], Rs)) {
+				address_x = LCD_COLS;
+				return;
+			}
+
+			screen[y][x] = frame[y][x];
+			address_x++;
+		}
+	}
+}
+
+void LcdManager::setI2CManager(I2CManager* i2c) {
+	this->i2c = i2c;
+}
+
+
+size_t LcdManager::write(uint8_t value) {
+	if (cursor_x < LCD_COLS && cursor_y < LCD_ROWS) {
+		frame[cursor_y][cursor_x] = value;
+	}
+
+	cursor_x++;
+	return 1;
+}
+
+void LcdManager::setCursor(uint8_t x, uint8_t y) {
+	cursor_x = x;
+	cursor_y = y;
+}
+
+void LcdManager::clear() {
+	memset(frame, ' ', sizeof(frame));
+
+	cursor_x = 0;
+	cursor_y = 0;
+}
+
+void LcdManager::createChar(uint8_t location, const uint8_t* charmap) {
+	send(LCD_SETCGRAMADDR | ((location & 0x07) << 3), 0);
+
+	for (uint8_t i = 0;i < 8;i++) {
+		send(charmap[i], Rs);
+	}
+
+	// the next character needs the ddram address again
+	address_x = LCD_COLS;
+}
+
+void LcdManager::backlight() {
+	backlight_value = LCD_BACKLIGHT;
+	LiquidCrystal_I2C::backlight();
+}
+
+void LcdManager::noBacklight() {
+	backlight_value = LCD_NOBACKLIGHT;
+	LiquidCrystal_I2C::noBacklight();
+}
+
+
 
 void LcdManager::printTitle(uint8_t y, String title, uint16_t delay_time, bool clear_flag) {
 	uint8_t x = 10 - title.length() / 2;
 
 	clear();
 	easyPrint(x, y, title);
+	flush(true);
 	delay(delay_time);
 
 	if (clear_flag) {
@@ -54,4 +160,19 @@ void LcdManager::clearColumn(uint8_t column) {
 	for (uint8_t i = 0;i < 4;i++) {
 		easyPrint(column, i, " ");
 	}
-}
\ No newline at end of file
+}
+
+
+bool LcdManager::send(uint8_t value, uint8_t mode) {
+	if (i2c == NULL) {
+		return false;
+	}
+
+	uint8_t high = (value & 0xF0) | mode | backlight_value;
+	uint8_t low = ((value << 4) & 0xF0) | mode | backlight_value;
+
+	// both nibbles in one transaction, each byte is ~90 mcs on the bus
+	uint8_t data[] = {high, (uint8_t) (high | En), high, (uint8_t) (low | En), low};
+
+	return !i2c->write(LCD_ADDRESS, data, sizeof(data), I2C_PRIORITY_DISPLAY);
+}
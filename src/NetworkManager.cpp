@@ -227,10 +227,12 @@ void NetworkManager::setWifi(String* ssid, String* pass) {
 }
 void NetworkManager::setWifi(const char* ssid, const char* pass) {
 	if (ssid != NULL) {
-		strcpy(ssid_sta, ssid);
+		strncpy(ssid_sta, ssid, NETWORK_SSID_PASS_SIZE - 1);
+		ssid_sta[NETWORK_SSID_PASS_SIZE - 1] = 0;
 	}
 	if (pass != NULL) {
-		strcpy(pass_sta, pass);
+		strncpy(pass_sta, pass, NETWORK_SSID_PASS_SIZE - 1);
+		pass_sta[NETWORK_SSID_PASS_SIZE - 1] = 0;
 	}
 
 	reset_request = true;
@@ -240,11 +242,14 @@ void NetworkManager::setAp(String* ssid, String* pass) {
   	setAp((ssid != NULL) ? ssid->c_str() : NULL, (pass != NULL) ? pass->c_str() : NULL);
 }
 void NetworkManager::setAp(const char* ssid, const char* pass) {
-	if (ssid != NULL) {
-		strcpy(ssid_ap, (!*ssid) ? DEFAULT_NETWORK_SSID_AP : ssid);
+	// readSettings passes the members themselves to fill the defaults
+	if (ssid != NULL && (ssid != ssid_ap || !*ssid)) {
+		strncpy(ssid_ap, (!*ssid) ? DEFAULT_NETWORK_SSID_AP : ssid, NETWORK_SSID_PASS_SIZE - 1);
+		ssid_ap[NETWORK_SSID_PASS_SIZE - 1] = 0;
 	}
-	if (pass != NULL) {
-		strcpy(pass_ap, (!*pass) ? DEFAULT_NETWORK_PASS_AP : pass);
+	if (pass != NULL && (pass != pass_ap || !*pass)) {
+		strncpy(pass_ap, (!*pass) ? DEFAULT_NETWORK_PASS_AP : pass, NETWORK_SSID_PASS_SIZE - 1);
+		pass_ap[NETWORK_SSID_PASS_SIZE - 1] = 0;
 	}
 	
 	WiFiMode_t current_mode = WiFi.getMode();
@@ -0,0 +1,301 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * Author: Vereshchynskyi Nazar
+ * Email: verechnazar12@gmail.com
+ * Version: 1.3.1
+ * Date: 04.02.2025
+ */
+
+#include "data.h"
+
+ReleDriver::ReleDriver() {
+	makeDefault();
+}
+
+void ReleDriver::begin(SystemManager* system, uint8_t port, uint8_t index) {
+	this->system = system;
+	this->index = index;
+
+	setPort(port);
+
+	// a soft reset keeps the counters in the rtc memory
+	rele_stats_t rtc_stats;
+	uint32_t offset = RELE_RTC_OFFSET + index * (sizeof(rele_stats_t) / 4);
+
+	if (ESP.rtcUserMemoryRead(offset, (uint32_t*) &rtc_stats, sizeof(rele_stats_t))) {
+		rele_stats_t current_stats = stats;
+		stats = rtc_stats;
+
+		if (stats.magic != RELE_RTC_MAGIC || stats.checksum != calcStatsChecksum()) {
+			stats = current_stats;
+		}
+	}
+}
+
+
+void ReleDriver::tick() {
+	// a finished override returns to the automatic state
+	if (override_flag && getOverrideTime() && millis() - override_timer >= MIN_TO_MLS(getOverrideTime())) {
+		override_flag = false;
+	}
+
+	bool target = override_flag ? override_state : auto_flag;
+	if (target != state && isChangeAllowed()) {
+		apply(target);
+	}
+
+	if (state) {
+		uint32_t seconds = (millis() - on_timer) / 1000;
+
+		if (seconds) {
+			stats.on_time += seconds;
+			on_timer += SEC_TO_MLS(seconds);
+			flush_flag = true;
+		}
+
+		if (millis() - rtc_timer >= SEC_TO_MLS(RELE_RTC_TIME)) {
+			saveStats();
+		}
+	}
+
+	if (flush_flag && system != NULL && millis() - flush_timer >= MIN_TO_MLS(RELE_FLUSH_TIME)) {
+		flush_timer = millis();
+		flush_flag = false;
+
+		system->saveSettingsRequest();
+	}
+}
+
+void ReleDriver::makeDefault() {
+	system = NULL;
+	port = RELE_PORT_OFF;
+	index = 0;
+
+	invert_flag = DEFAULT_SOLAR_RELE_INVERT_FLAG;
+	min_on_time = DEFAULT_RELE_MIN_ON_TIME;
+	min_off_time = DEFAULT_RELE_MIN_OFF_TIME;
+	max_rate = DEFAULT_RELE_MAX_RATE;
+	override_time = DEFAULT_RELE_OVERRIDE_TIME;
+
+	state = false;
+	auto_flag = false;
+	override_flag = false;
+	override_state = false;
+	output = RELE_OUTPUT_UNKNOWN;
+
+	change_timer = 0;
+	start_timer = 0;
+	override_timer = 0;
+	on_timer = 0;
+	rtc_timer = 0;
+	flush_timer = 0;
+	flush_flag = false;
+
+	memset(&stats, 0, sizeof(rele_stats_t));
+	stats.magic = RELE_RTC_MAGIC;
+	stats.checksum = calcStatsChecksum();
+}
+
+
+void ReleDriver::request(bool flag) {
+	auto_flag = flag;
+	tick();
+}
+
+void ReleDriver::override(bool flag) {
+	override_flag = true;
+	override_state = flag;
+	override_timer = millis();
+
+	tick();
+}
+
+void ReleDriver::release() {
+	override_flag = false;
+	auto_flag = false;
+
+	tick();
+}
+
+void ReleDriver::stop() {
+	override_flag = false;
+	auto_flag = false;
+
+	// a fault does not wait for the minimum on time
+	if (state) {
+		apply(false);
+	}
+}
+
+void ReleDriver::loadStats(uint32_t cycles, uint32_t on_time, uint32_t change_time) {
+	// the rtc copy is newer than the flash one
+	if (stats.cycles || stats.on_time) {
+		return;
+	}
+
+	stats.cycles = cycles;
+	stats.on_time = on_time;
+	stats.change_time = change_time;
+	saveStats();
+}
+
+void ReleDriver::resetStats() {
+	stats.cycles = 0;
+	stats.on_time = 0;
+	stats.change_time = 0;
+	on_timer = millis();
+
+	saveStats();
+	flush_flag = true;
+}
+
+
+void ReleDriver::setPort(uint8_t port) {
+	if (port > RELE_PORT_MAX) {
+		port = RELE_PORT_OFF;
+	}
+
+	// the released port no longer drives the relay
+	if (this->port != RELE_PORT_OFF && this->port != port) {
+		pinMode(this->port, INPUT);
+	}
+
+	this->port = port;
+	output = RELE_OUTPUT_UNKNOWN;
+
+	if (port != RELE_PORT_OFF) {
+		pinMode(port, OUTPUT);
+		write();
+	}
+}
+
+void ReleDriver::setInvertFlag(bool invert_flag) {
+	this->invert_flag = invert_flag;
+	write();
+}
+
+void ReleDriver::setMinOnTime(uint16_t time) {
+	min_on_time = constrain(time, 0, RELE_TIME_MAX);
+}
+
+void ReleDriver::setMinOffTime(uint16_t time) {
+	min_off_time = constrain(time, 0, RELE_TIME_MAX);
+}
+
+void ReleDriver::setMaxRate(uint8_t rate) {
+	max_rate = constrain(rate, 0, RELE_RATE_MAX);
+}
+
+void ReleDriver::setOverrideTime(uint8_t time) {
+	override_time = constrain(time, 0, RELE_OVERRIDE_TIME_MAX);
+}
+
+
+bool ReleDriver::getState() {
+	return state;
+}
+
+bool ReleDriver::getOverrideFlag() {
+	return override_flag;
+}
+
+uint8_t ReleDriver::getPort() {
+	return port;
+}
+
+bool ReleDriver::getInvertFlag() {
+	return invert_flag;
+}
+
+uint16_t ReleDriver::getMinOnTime() {
+	return min_on_time;
+}
+
+uint16_t ReleDriver::getMinOffTime() {
+	return min_off_time;
+}
+
+uint8_t ReleDriver::getMaxRate() {
+	return max_rate;
+}
+
+uint8_t ReleDriver::getOverrideTime() {
+	return override_time;
+}
+
+uint32_t ReleDriver::getCycles() {
+	return stats.cycles;
+}
+
+uint32_t ReleDriver::getOnTime() {
+	return stats.on_time;
+}
+
+uint32_t ReleDriver::getChangeTime() {
+	return stats.change_time;
+}
+
+
+bool ReleDriver::isChangeAllowed() {
+	// the first change after the start is not delayed
+	if (!change_timer) {
+		return true;
+	}
+
+	if (state) {
+		return millis() - change_timer >= SEC_TO_MLS((uint32_t) getMinOnTime());
+	}
+
+	if (millis() - change_timer < SEC_TO_MLS((uint32_t) getMinOffTime())) {
+		return false;
+	}
+
+	// starts are spread over the hour
+	return !getMaxRate() || !start_timer || millis() - start_timer >= MIN_TO_MLS(60) / getMaxRate();
+}
+
+void ReleDriver::apply(bool flag) {
+	if (state) {
+		stats.on_time += (millis() - on_timer) / 1000;
+	}
+
+	state = flag;
+	change_timer = millis();
+	on_timer = millis();
+
+	if (flag) {
+		start_timer = millis();
+		stats.cycles++;
+	}
+
+	if (system != NULL) {
+		stats.change_time = system->getTimeManager()->getUnix();
+	}
+
+	write();
+	saveStats();
+	flush_flag = true;
+}
+
+void ReleDriver::write() {
+	uint8_t level = (getInvertFlag() ? !state : state) ? HIGH : LOW;
+
+	// the port is written only on a change
+	if (port != RELE_PORT_OFF && level != output) {
+		output = level;
+		digitalWrite(port, level);
+	}
+}
+
+void ReleDriver::saveStats() {
+	rtc_timer = millis();
+	stats.magic = RELE_RTC_MAGIC;
+	stats.checksum = calcStatsChecksum();
+
+	ESP.rtcUserMemoryWrite(RELE_RTC_OFFSET + index * (sizeof(rele_stats_t) / 4), (uint32_t*) &stats, sizeof(rele_stats_t));
+}
+
+uint32_t ReleDriver::calcStatsChecksum() {
+	return stats.magic ^ stats.cycles ^ (stats.on_time << 1) ^ (stats.change_time << 2) ^ 0xFFFFFFFF;
+}
@@ -0,0 +1,380 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * Author: Vereshchynskyi Nazar
+ * Email: verechnazar12@gmail.com
+ * Version: 1.3.1
+ * Date: 04.02.2025
+ */
+
+#include "data.h"
+
+RuleEngine::RuleEngine() {
+	clear();
+}
+
+bool RuleEngine::compile(const char* text) {
+	char source[RULE_TEXT_SIZE] = "";
+	uint8_t operators[RULE_CODE_SIZE];
+	uint8_t operators_count = 0;
+	bool operand_flag = true; // an operand or a prefix is expected
+	const char* pointer;
+
+	// ';' ends a settings entry, such a text or a longer one is refused and the rule stays as it was
+	if (strchr(text, ';') != NULL || strlen(text) > RULE_TEXT_SIZE - 1) {
+		return false;
+	}
+
+	// the text may be our own
+	strncpy(source, text, RULE_TEXT_SIZE - 1);
+	clear();
+	strcpy(this->text, source);
+	pointer = this->text;
+
+	// shunting yard straight into the postfix code
+	while (true) {
+		while (*pointer == ' ') {
+			pointer++;
+		}
+
+		if (!*pointer) {
+			break;
+		}
+
+		error = pointer - this->text + 1;
+
+		if (operand_flag) {
+			if (*pointer == '(' || *pointer == '!' || *pointer == '-') {
+				if (operators_count >= RULE_CODE_SIZE) {
+					return false;
+				}
+
+				operators[operators_count++] = (*pointer == '(') ? RULE_OP_LEFT : (*pointer == '!') ? RULE_OP_NOT : RULE_OP_NEG;
+				pointer++;
+
+				continue;
+			}
+
+			if (!parseOperand(&pointer)) {
+				length = 0;
+				return false;
+			}
+
+			operand_flag = false;
+			continue;
+		}
+
+		if (*pointer == ')') {
+			while (operators_count && operators[operators_count - 1] != RULE_OP_LEFT) {
+				if (!emit(operators[--operators_count])) {
+					return false;
+				}
+			}
+
+			if (!operators_count) {
+				length = 0;
+				return false;
+			}
+
+			operators_count--;
+			pointer++;
+
+			continue;
+		}
+
+		uint8_t code = parseOperator(&pointer);
+		if (code == RULE_OP_LEFT) {
+			length = 0;
+			return false;
+		}
+
+		// all binary operators are left associative
+		while (operators_count && operators[operators_count - 1] != RULE_OP_LEFT && getPriority(operators[operators_count - 1]) >= getPriority(code)) {
+			if (!emit(operators[--operators_count])) {
+				return false;
+			}
+		}
+
+		if (operators_count >= RULE_CODE_SIZE) {
+			length = 0;
+			return false;
+		}
+
+		operators[operators_count++] = code;
+		operand_flag = true;
+	}
+
+	error = pointer - this->text + 1;
+
+	if (operand_flag) {
+		length = 0;
+		return false;
+	}
+
+	while (operators_count) {
+		if (operators[operators_count - 1] == RULE_OP_LEFT || !emit(operators[--operators_count])) {
+			length = 0;
+			return false;
+		}
+	}
+
+	error = 0;
+	return true;
+}
+
+bool RuleEngine::evaluate(rule_context_t* context, int32_t* result) {
+	int32_t stack[RULE_STACK_SIZE];
+	uint8_t top = 0;
+	uint32_t timer = micros();
+
+	if (!isCompiled()) {
+		return false;
+	}
+
+	// the compiler has checked the stack depth, the loop has no jumps
+	for (uint8_t i = 0;i < length;i++) {
+		int32_t arg = code[i].arg;
+		int32_t a = top > 1 ? stack[top - 2] : 0;
+		int32_t b = top ? stack[top - 1] : 0;
+
+		switch (code[i].code) {
+		case RULE_OP_CONST:
+			stack[top++] = arg;
+			break;
+		case RULE_OP_SAMPLE: {
+			sensor_sample_t* sample = context->sensors->getSample(arg);
+
+			// a rule over a missing or failed sensor does not fire
+			if (sample == NULL || sample->type == SENSOR_TYPE_NONE || sample->quality) {
+				time = micros() - timer;
+				return false;
+			}
+
+			stack[top++] = sample->value;
+			break;
+		}
+		case RULE_OP_RELE:
+			stack[top++] = context->snapshot->channels[arg].rele_flag ? RULE_TRUE : 0;
+			break;
+		case RULE_OP_HOUR:
+		case RULE_OP_MINUTE:
+			// nor does a rule over the time before the clock is set
+			if (!context->time_flag) {
+				time = micros() - timer;
+				return false;
+			}
+
+			stack[top++] = ((code[i].code == RULE_OP_HOUR) ? context->hour : context->minute) * 100;
+			break;
+		case RULE_OP_NOT:
+			stack[top - 1] = b ? 0 : RULE_TRUE;
+			break;
+		case RULE_OP_NEG:
+			stack[top - 1] = saturate(-(int64_t) b);
+			break;
+		default:
+			// binary, hundredths of the unit, the arithmetic saturates
+			switch (code[i].code) {
+			case RULE_OP_MUL: a = saturate((int64_t) a * b / 100); break;
+			case RULE_OP_DIV: a = b ? saturate((int64_t) a * 100 / b) : 0; break;
+			case RULE_OP_ADD: a = saturate((int64_t) a + b); break;
+			case RULE_OP_SUB: a = saturate((int64_t) a - b); break;
+			case RULE_OP_LT: a = (a < b) ? RULE_TRUE : 0; break;
+			case RULE_OP_LE: a = (a <= b) ? RULE_TRUE : 0; break;
+			case RULE_OP_GT: a = (a > b) ? RULE_TRUE : 0; break;
+			case RULE_OP_GE: a = (a >= b) ? RULE_TRUE : 0; break;
+			case RULE_OP_EQ: a = (a == b) ? RULE_TRUE : 0; break;
+			case RULE_OP_NE: a = (a != b) ? RULE_TRUE : 0; break;
+			case RULE_OP_AND: a = (a && b) ? RULE_TRUE : 0; break;
+			case RULE_OP_OR: a = (a || b) ? RULE_TRUE : 0; break;
+			}
+
+			stack[--top - 1] = a;
+			break;
+		}
+	}
+
+	*result = stack[0];
+	time = micros() - timer;
+
+	return true;
+}
+
+void RuleEngine::clear() {
+	memset(text, 0, RULE_TEXT_SIZE);
+	length = 0;
+	depth = 0;
+	error = 0;
+	time = 0;
+}
+
+
+const char* RuleEngine::getText() {
+	return text;
+}
+
+bool RuleEngine::isCompiled() {
+	return length && !error;
+}
+
+uint8_t RuleEngine::getError() {
+	return error;
+}
+
+uint8_t RuleEngine::getLength() {
+	return length;
+}
+
+uint16_t RuleEngine::getTime() {
+	return time;
+}
+
+
+bool RuleEngine::parseOperand(const char** pointer) {
+	const char* p = *pointer;
+
+	if (isdigit(*p)) {
+		int32_t value = 0;
+
+		while (isdigit(*p)) {
+			value = value * 10 + (*p++ - '0');
+
+			if (value > RULE_NUMBER_MAX) {
+				return false;
+			}
+		}
+
+		value *= 100;
+
+		// two decimals at most
+		if (*p == '.') {
+			p++;
+
+			if (isdigit(*p)) value += (*p++ - '0') * 10;
+			if (isdigit(*p)) value += *p++ - '0';
+			if (isdigit(*p)) return false;
+		}
+
+		*pointer = p;
+		return emit(RULE_OP_CONST, value);
+	}
+
+	char name[8];
+	uint8_t name_length = 0;
+	int32_t index = -1;
+
+	while (isalpha(*p)) {
+		if (name_length >= sizeof(name) - 1) {
+			return false;
+		}
+
+		name[name_length++] = *p++;
+	}
+
+	name[name_length] = 0;
+
+	if (isdigit(*p)) {
+		index = 0;
+
+		while (isdigit(*p) && index < 100) {
+			index = index * 10 + (*p++ - '0');
+		}
+	}
+
+	*pointer = p;
+
+	if (!strcmp(name, "hour") && index < 0) return emit(RULE_OP_HOUR);
+	if (!strcmp(name, "minute") && index < 0) return emit(RULE_OP_MINUTE);
+	if (!strcmp(name, "ds") && index >= 0 && index < DS_SENSORS_MAX_COUNT) return emit(RULE_OP_SAMPLE, SENSOR_SOURCE_DS18B20 + index);
+	if (!strcmp(name, "sm") && index >= 0 && index < SENSOR_SAMPLES_COUNT) return emit(RULE_OP_SAMPLE, index);
+	if (!strcmp(name, "rele") && index >= 0 && index < SOLAR_CHANNELS_COUNT) return emit(RULE_OP_RELE, index);
+
+	return false;
+}
+
+uint8_t RuleEngine::parseOperator(const char** pointer) {
+	const char* p = *pointer;
+	uint8_t code = RULE_OP_LEFT;
+
+	if (p[0] == '<' && p[1] == '=') code = RULE_OP_LE;
+	else if (p[0] == '>' && p[1] == '=') code = RULE_OP_GE;
+	else if (p[0] == '=' && p[1] == '=') code = RULE_OP_EQ;
+	else if (p[0] == '!' && p[1] == '=') code = RULE_OP_NE;
+	else if (p[0] == '&' && p[1] == '&') code = RULE_OP_AND;
+	else if (p[0] == '|' && p[1] == '|') code = RULE_OP_OR;
+
+	if (code != RULE_OP_LEFT) {
+		*pointer = p + 2;
+		return code;
+	}
+
+	switch (*p) {
+	case '*': code = RULE_OP_MUL; break;
+	case '/': code = RULE_OP_DIV; break;
+	case '+': code = RULE_OP_ADD; break;
+	case '-': code = RULE_OP_SUB; break;
+	case '<': code = RULE_OP_LT; break;
+	case '>': code = RULE_OP_GT; break;
+	default: return RULE_OP_LEFT;
+	}
+
+	*pointer = p + 1;
+	return code;
+}
+
+uint8_t RuleEngine::getPriority(uint8_t code) {
+	switch (code) {
+	case RULE_OP_NOT:
+	case RULE_OP_NEG:
+		return 7;
+	case RULE_OP_MUL:
+	case RULE_OP_DIV:
+		return 6;
+	case RULE_OP_ADD:
+	case RULE_OP_SUB:
+		return 5;
+	case RULE_OP_LT:
+	case RULE_OP_LE:
+	case RULE_OP_GT:
+	case RULE_OP_GE:
+		return 4;
+	case RULE_OP_EQ:
+	case RULE_OP_NE:
+		return 3;
+	case RULE_OP_AND:
+		return 2;
+	default:
+		return 1;
+	}
+}
+
+int32_t RuleEngine::saturate(int64_t value) {
+	if (value > INT32_MAX) return INT32_MAX;
+	if (value < INT32_MIN) return INT32_MIN;
+
+	return value;
+}
+
+bool RuleEngine::emit(uint8_t code, int32_t arg) {
+	if (length >= RULE_CODE_SIZE) {
+		length = 0;
+		return false;
+	}
+
+	// operands push, prefixes keep and binary operators pop one value
+	if (code <= RULE_OP_MINUTE) {
+		if (++depth > RULE_STACK_SIZE) {
+			length = 0;
+			return false;
+		}
+	}
+	else if (code > RULE_OP_NEG) {
+		depth--;
+	}
+
+	this->code[length].code = code;
+	this->code[length].arg = arg;
+	length++;
+
+	return true;
+}
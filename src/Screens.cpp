@@ -83,6 +83,7 @@ void MainWindow::printHome(LcdManager* lcd, SystemManager* system) {
 	TimeManager* time = system->getTimeManager();
 	SensorsManager* sensors = system->getSensorsManager();
 	SolarSystemManager* solar = system->getSolarSystemManager();
+	const solar_snapshot_t* snapshot = solar->getSnapshot();
 	NetworkManager* network = system->getNetworkManager();
 	BlynkManager* blynk = system->getBlynkManager();
 
@@ -93,13 +94,13 @@ void MainWindow::printHome(LcdManager* lcd, SystemManager* system) {
 	lcd->print((sensors->getAM2320Status() && IS_EVEN_SECOND(millis()) ) ? "A" : " ");
 
 	lcd->setCursor(15, 0);
-	lcd->print(solar->getReleFlag() ? (IS_EVEN_SECOND(millis()) ? ">" : "<") : " ");
+	lcd->print(snapshot->rele_flag ? (IS_EVEN_SECOND(millis()) ? ">" : "<") : " ");
 	
 	if (!solar->getWorkFlag()) {
 		lcd->print("!");
 	}
 	else {
-		lcd->print((solar->getStatus() && IS_EVEN_SECOND(millis()) ) ? "!" : " ");
+		lcd->print((snapshot->status && IS_EVEN_SECOND(millis()) ) ? "!" : " ");
 	}
 
 	lcd->write((network->isApOn()) ? 178 : 32);
@@ -129,48 +130,55 @@ void MainWindow::printHome(LcdManager* lcd, SystemManager* system) {
 
 	lcd->easyPrint(15, 2, time->year());
 	lcd->easyPrint(15, 3, String(time->day()) + "." + time->month());
+
+	// the heat collected today
+	if (solar->getEnergyMeter()->getWorkFlag()) {
+		lcd->easyPrint(0, 3, centiToString(solar->getEnergyMeter()->getDay() / 10, 2) + "kWh ");
+	}
 }
 
 void MainWindow::printSensors(LcdManager* lcd, SystemManager* system) {
 	SensorsManager* sensors = system->getSensorsManager();
 	SolarSystemManager* solar = system->getSolarSystemManager();
+	const solar_snapshot_t* snapshot = solar->getSnapshot();
 
-	lcd->easyPrint(0, 0, (!solar->getBatterySensorStatus() || IS_EVEN_SECOND(millis()) ) ? "BAT" : "   ");
+	lcd->easyPrint(0, 0, (!snapshot->battery_status || IS_EVEN_SECOND(millis()) ) ? "BAT" : "   ");
 	lcd->print(":");
-	lcd->print(solar->getBatteryT(), 2);
+	lcd->print(centiToString(snapshot->battery_t, 2));
 	lcd->write(223);
 
-	lcd->easyPrint(0, 1, (!solar->getBoilerSensorStatus() || IS_EVEN_SECOND(millis()) ) ? "BOI" : "   ");
+	lcd->easyPrint(0, 1, (!snapshot->boiler_status || IS_EVEN_SECOND(millis()) ) ? "BOI" : "   ");
 	lcd->print(":");
-	lcd->print(solar->getBoilerT(), 2);
+	lcd->print(centiToString(snapshot->boiler_t, 2));
 	lcd->write(223);
 
-	lcd->easyPrint(0, 2, (!solar->getExitSensorStatus() || IS_EVEN_SECOND(millis()) ) ? "EXT" : "   ");
+	lcd->easyPrint(0, 2, (!snapshot->exit_status || IS_EVEN_SECOND(millis()) ) ? "EXT" : "   ");
 	lcd->print(":");
-	lcd->print(solar->getExitT(), 2);
+	lcd->print(centiToString(snapshot->exit_t, 2));
 	lcd->write(223);
 
 	lcd->easyPrint(12, 0, (!sensors->getAM2320Status() || IS_EVEN_SECOND(millis()) ) ? "T" : " ");
 	lcd->print(":");
-	lcd->print(sensors->getAM2320T(), 2);
+	lcd->print(centiToString(sensors->getAM2320TCenti(), 2));
 	lcd->write(223);
 
 	lcd->easyPrint(12, 1, (!sensors-> getAM2320Status() || IS_EVEN_SECOND(millis()) ) ? "H" : " ");
 	lcd->print(":");
-	lcd->print(sensors->getAM2320H(), 2);
+	lcd->print(centiToString(sensors->getAM2320HCenti(), 2));
 	lcd->print("%");
 }
 
 void MainWindow::printSolar(LcdManager* lcd, SystemManager* system) {
 	SolarSystemManager* solar = system->getSolarSystemManager();
+	const solar_snapshot_t* snapshot = solar->getSnapshot();
 
 	for (byte i = 0;i < 3;i++) {
 		lcd->easyPrint(1, i, "|");
 		lcd->easyPrint(5, i, "|");
 	}
-	if (!solar->getBoilerSensorStatus() || IS_EVEN_SECOND(millis()) ) {
-		lcd->easyPrint(2, 0, (int8_t)solar->getBoilerT());
-		lcd->easyPrint(2, 1, String(".") + (int8_t)((solar->getBoilerT() - (int8_t)solar->getBoilerT()) * 100) );
+	if (!snapshot->boiler_status || IS_EVEN_SECOND(millis()) ) {
+		lcd->easyPrint(2, 0, (int32_t) (snapshot->boiler_t / 100));
+		lcd->easyPrint(2, 1, String(".") + abs(snapshot->boiler_t % 100));
 		lcd->easyWrite(4, 2, 223);
 	}
 	else {
@@ -182,8 +190,8 @@ void MainWindow::printSolar(LcdManager* lcd, SystemManager* system) {
 
 	lcd->easyPrint(8, 1, (solar->getWorkFlag()) ? "ON " : "OFF");
 
-	if (!solar->getExitSensorStatus() || IS_EVEN_SECOND(millis()) ) {
-		lcd->easyPrint(7, 2, solar->getExitT());
+	if (!snapshot->exit_status || IS_EVEN_SECOND(millis()) ) {
+		lcd->easyPrint(7, 2, centiToString(snapshot->exit_t, 2));
 		lcd->write(223);
 	}
 	else {
@@ -196,7 +204,7 @@ void MainWindow::printSolar(LcdManager* lcd, SystemManager* system) {
 		lcd->easyPrint(11 - solar_window_data.pointer, 0, " ");
 		lcd->easyPrint(6 + solar_window_data.pointer, 3, " ");
 
-		if (solar->getReleFlag()) {
+		if (snapshot->rele_flag) {
 			solar_window_data.pointer = (solar_window_data.pointer == 5) ? 0 : solar_window_data.pointer + 1;
 			
 			lcd->easyPrint(11 - solar_window_data.pointer, 0, "<");
@@ -211,9 +219,9 @@ void MainWindow::printSolar(LcdManager* lcd, SystemManager* system) {
 	}
 	lcd->easyPrint(15, 3, "-----");
 
-	if (!solar->getBatterySensorStatus() || IS_EVEN_SECOND(millis()) ) {
-		lcd->easyPrint(14, 1, (int)solar->getBatteryT());
-		lcd->easyPrint(15, 2, String(".") + (int)((solar->getBatteryT() - (int)solar->getBatteryT()) * 10) );
+	if (!snapshot->battery_status || IS_EVEN_SECOND(millis()) ) {
+		lcd->easyPrint(14, 1, (int32_t) (snapshot->battery_t / 100));
+		lcd->easyPrint(15, 2, String(".") + abs(snapshot->battery_t % 100) / 10);
 		lcd->write(223);
 	}
 	else {
@@ -440,7 +448,7 @@ void DS18B20Window::print(LcdManager* lcd, DisplayManager* display, SystemManage
 			if (ds_index < sensors->getDS18B20Count()) {
 				lcd->easyPrint(0, i, (!sensors->getDS18B20Status(ds_index) || IS_EVEN_SECOND(millis()) ) ? sensors->getDS18B20Name(ds_index) : "  ");
 				lcd->print(":");
-				lcd->print(sensors->getDS18B20T(ds_index), 2);
+				lcd->print(centiToString(sensors->getDS18B20TCenti(ds_index), 2));
 				lcd->write(223);
 				lcd->print("   ");
 			}
@@ -526,6 +534,7 @@ void SettingsWindow::print(LcdManager* lcd, DisplayManager* display, SystemManag
 		lcd->clear();
 
 		system->saveSettingsRequest();
+		system->getSensorsManager()->saveDS18B20Config();
 		display->deleteWindowFromStack(this);
 	}
 
@@ -1243,7 +1252,7 @@ void DS18B20SensorsSettingsWindow::print(LcdManager* lcd, DisplayManager* displa
 			if (ds_index < sensors->getDS18B20Count()) {
 				lcd->easyPrint(1, i, sensors->getDS18B20Name(ds_index));
 
-				lcd->easyPrint(8, i, sensors->getDS18B20T(ds_index));
+				lcd->easyPrint(8, i, centiToString(sensors->getDS18B20TCenti(ds_index), 2));
 				lcd->write(223);
 			}
 
@@ -1396,13 +1405,16 @@ void SetDS18B20Window::print(LcdManager* lcd, DisplayManager* display, SystemMan
 	if (print_flag) {
 		print_flag = false;
 		if (!(cursor / 4)) {
-			float t = sensors->getDS18B20TByAddress(config_ds18b20->address);
+			int16_t t = sensors->getDS18B20TByAddress(config_ds18b20->address);
 
 			lcd->easyPrint(1, 0, config_ds18b20->name);
 
 			lcd->setCursor(8, 0);
-			if (*config_ds18b20->address) {
-				lcd->print(t);
+			if (*config_ds18b20->address && t <= DS18B20_DISCONNECTED_T) {
+				lcd->print("--    ");
+			}
+			else if (*config_ds18b20->address) {
+				lcd->print(centiToString(t, 2));
 				lcd->write(223);
 			}
 			else {
@@ -1424,13 +1436,35 @@ void SetDS18B20Window::print(LcdManager* lcd, DisplayManager* display, SystemMan
 			lcd->print("]");
 
 			lcd->easyPrint(1, 3, "Correction [");
-			lcd->print(config_ds18b20->correction);
+			lcd->print(centiToString(config_ds18b20->correction, 2));
 			lcd->print("]");
 		}
 		if (cursor / 4 == 1) {
 			lcd->easyPrint(1, 0, "Resolution [");
 			lcd->print(config_ds18b20->resolution);
 			lcd->print("]");
+
+			lcd->easyPrint(1, 1, "Auto res [");
+			lcd->print(config_ds18b20->auto_resolution_flag ? "ON" : "OFF");
+			lcd->print("]");
+
+			lcd->easyPrint(1, 2, "Read time [");
+			if (config_ds18b20->read_time) {
+				lcd->print(config_ds18b20->read_time);
+			}
+			else {
+				lcd->print("COM");
+			}
+			lcd->print("]");
+
+			lcd->easyPrint(1, 3, "Adaptive [");
+			lcd->print(config_ds18b20->adaptive_flag ? "ON" : "OFF");
+			lcd->print("]");
+		}
+		if (cursor / 4 == 2) {
+			lcd->easyPrint(1, 0, "Bus [");
+			lcd->print(config_ds18b20->bus);
+			lcd->print("]");
 		}
 	}
 	lcd->easyPrint(0, cursor % 4, ">");
@@ -1438,7 +1472,7 @@ void SetDS18B20Window::print(LcdManager* lcd, DisplayManager* display, SystemMan
 	if (enc->isLeft(true) || enc->isRight(true)) {
 		lcd->easyPrint(0, cursor % 4, " ");
 
-		if (windowCursorTick(cursor, enc->isLeft() ? -1 : 1, 4)) {
+		if (windowCursorTick(cursor, enc->isLeft() ? -1 : 1, 8)) {
 			print_flag = true;
 			lcd->clear();
 		}
@@ -1448,15 +1482,21 @@ void SetDS18B20Window::print(LcdManager* lcd, DisplayManager* display, SystemMan
 
 	if (enc->isLeftH(true) || enc->isRightH(true)) {
 		print_flag = true;
-		lcd->clearLine(cursor);
+		lcd->clearLine(cursor % 4);
 
 		switch (cursor) {
 		case 3:
-			smartIncr(config_ds18b20->correction, enc->isLeftH() ? -0.1 : 0.1, -20, 20);
+			smartIncr(config_ds18b20->correction, enc->isLeftH() ? -10 : 10, -DS18B20_CORRECTION_MAX, DS18B20_CORRECTION_MAX);
 			break;
 		case 4:
 			smartIncr(config_ds18b20->resolution, enc->isLeftH() ? -1 : 1, 9, 12);
 			break;
+		case 6:
+			smartIncr(config_ds18b20->read_time, enc->isLeftH() ? -1 : 1, 0, 250);
+			break;
+		case 8:
+			smartIncr(config_ds18b20->bus, enc->isLeftH() ? -1 : 1, 0, DS18B20_BUS_COUNT - 1);
+			break;
 		}
 
 		enc->isLeftH();
@@ -1488,6 +1528,12 @@ void SetDS18B20Window::print(LcdManager* lcd, DisplayManager* display, SystemMan
 			display->addWindowToStack(set_ds18b20_address_window);	
 			}
 
+			break;
+		case 5:
+			config_ds18b20->auto_resolution_flag = !config_ds18b20->auto_resolution_flag;
+			break;
+		case 7:
+			config_ds18b20->adaptive_flag = !config_ds18b20->adaptive_flag;
 			break;
 		}
 	}
@@ -1510,19 +1556,39 @@ void SetDS18B20AddressWindow::print(LcdManager* lcd, DisplayManager* display, Sy
 
 	if (scan_flag) {
 		scan_flag = false;
-		print_flag = true;
+		wait_flag = true;
 
 		lcd->clear();
 		lcd->easyPrint(2, 1, "Scanning");
 
+		sensors->rescanDS18B20Bus();
+	}
+
+	// the bus is searched in the background by SensorsManager
+	if (wait_flag) {
+		if (sensors->getDS18B20BusScanFlag()) {
+			return;
+		}
+
+		wait_flag = false;
+		result_timer = millis();
+
 		sensors->makeDS18B20AddressList(&ds18b20_addresses, &t_array);
 		cursor = (cursor >= ds18b20_addresses.size()) ? ds18b20_addresses.size() - 1 : cursor;
 
 		lcd->easyPrint(2, 2, (ds18b20_addresses.size()) ? "OK " : "ERR");
 		lcd->easyPrint(2, 3, (int32_t) ds18b20_addresses.size());
 		lcd->print("sensors");
+	}
+
+	if (result_timer) {
+		if (millis() - result_timer < DS18B20_SCAN_RESULT_TIME) {
+			return;
+		}
+
+		result_timer = 0;
+		print_flag = true;
 
-		delay(500);
 		lcd->clear();
 	}
 
@@ -1549,7 +1615,7 @@ void SetDS18B20AddressWindow::print(LcdManager* lcd, DisplayManager* display, Sy
 					}
 
 					lcd->print(" ");
-					lcd->print(t_array[addr_index]);
+					lcd->print(centiToString(t_array[addr_index], 2));
 					lcd->write(223);
 				}
 			}
@@ -0,0 +1,451 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * Author: Vereshchynskyi Nazar
+ * Email: verechnazar12@gmail.com
+ * Version: 1.3.1
+ * Date: 04.02.2025
+ */
+
+#include "data.h"
+
+AM2320Driver::AM2320Driver() {
+	i2c = NULL;
+
+	state = AM2320_STATE_IDLE;
+	errors = 0;
+	timer = 0;
+	offline_timer = 0;
+	ready_flag = false;
+
+	t = 0;
+	h = 0;
+	status = UNSPECIFIED_STATUS;
+	crc_errors = 0;
+	timeouts = 0;
+	transactions = 0;
+}
+
+void AM2320Driver::begin(SystemManager* system) {
+	i2c = system->getI2CManager();
+}
+
+bool AM2320Driver::start() {
+	if (i2c == NULL || state != AM2320_STATE_IDLE) {
+		return false;
+	}
+
+	// a missing sensor is asked again only after a pause
+	if (errors >= AM2320_OFFLINE_COUNT && millis() - offline_timer < MIN_TO_MLS(AM2320_OFFLINE_TIME)) {
+		return false;
+	}
+
+	// the sleeping sensor does not acknowledge the wake up address
+	i2c->write(AM2320_ADDRESS, NULL, 0);
+	i2c->reserve(AM2320_WAKE_TIME);
+	transactions++;
+
+	timer = micros();
+	state = AM2320_STATE_WAKE;
+
+	return true;
+}
+
+bool AM2320Driver::poll() {
+	uint8_t data[8];
+
+	switch (state) {
+	case AM2320_STATE_IDLE:
+		break;
+	case AM2320_STATE_WAKE:
+		if (micros() - timer < AM2320_WAKE_TIME) {
+			break;
+		}
+
+		// humidity and temperature registers 0x00 - 0x03
+		data[0] = AM2320_READ_REGISTERS;
+		data[1] = 0x00;
+		data[2] = 0x04;
+		transactions++;
+
+		if (i2c->write(AM2320_ADDRESS, data, 3)) {
+			fail(AM2320_ERROR_NO_ACK);
+			break;
+		}
+
+		i2c->reserve(AM2320_MEASURE_TIME);
+		timer = micros();
+		state = AM2320_STATE_MEASURE;
+
+		break;
+	case AM2320_STATE_MEASURE:
+		if (micros() - timer < AM2320_MEASURE_TIME) {
+			break;
+		}
+
+		transactions++;
+
+		if (i2c->read(AM2320_ADDRESS, data, 8)) {
+			timeouts++;
+			fail(AM2320_ERROR_TIMEOUT);
+
+			break;
+		}
+
+		parse(data);
+		break;
+	}
+
+	return ready_flag;
+}
+
+void AM2320Driver::collect(SensorsManager* sensors) {
+	ready_flag = false;
+
+	// a failed measurement keeps the last values with the error status
+	sensors->setSample(SENSOR_SOURCE_AM2320_T, SENSOR_TYPE_TEMPERATURE, t, status);
+	sensors->setSample(SENSOR_SOURCE_AM2320_H, SENSOR_TYPE_HUMIDITY, h, status);
+}
+
+void AM2320Driver::resetStats() {
+	crc_errors = 0;
+	timeouts = 0;
+	transactions = 0;
+}
+
+
+uint16_t AM2320Driver::getCrcErrors() {
+	return crc_errors;
+}
+
+uint16_t AM2320Driver::getTimeouts() {
+	return timeouts;
+}
+
+uint32_t AM2320Driver::getTransactions() {
+	return transactions;
+}
+
+
+void AM2320Driver::parse(uint8_t* data) {
+	state = AM2320_STATE_IDLE;
+
+	if (data[0] != AM2320_READ_REGISTERS || data[1] != 4) {
+		fail(AM2320_ERROR_DATA);
+		return;
+	}
+
+	if (calcCrc(data, 6) != (data[6] | (data[7] << 8))) {
+		crc_errors++;
+		fail(AM2320_ERROR_CRC);
+
+		return;
+	}
+
+	uint16_t raw_h = (data[2] << 8) | data[3];
+	uint16_t raw_t = (data[4] << 8) | data[5];
+
+	// 0.1 units, the temperature is sign and magnitude
+	h = raw_h * 10;
+	t = (raw_t & 0x7FFF) * 10;
+
+	if (raw_t & 0x8000) {
+		t = -t;
+	}
+
+	status = 0;
+	errors = 0;
+	ready_flag = true;
+}
+
+void AM2320Driver::fail(uint8_t status) {
+	state = AM2320_STATE_IDLE;
+	ready_flag = true;
+	this->status = status;
+
+	if (errors < AM2320_OFFLINE_COUNT) {
+		errors++;
+	}
+
+	if (errors >= AM2320_OFFLINE_COUNT) {
+		offline_timer = millis();
+	}
+}
+
+uint16_t AM2320Driver::calcCrc(uint8_t* data, uint8_t length) {
+	uint16_t crc = 0xFFFF;
+
+	// crc16 modbus
+	for (uint8_t i = 0;i < length;i++) {
+		crc ^= data[i];
+
+		for (uint8_t j = 0;j < 8;j++) {
+			crc = (crc & 0x01) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+		}
+	}
+
+	return crc;
+}
+
+
+volatile uint32_t FlowMeterDriver::pulses_count = 0;
+
+FlowMeterDriver::FlowMeterDriver() {
+	port = FLOW_PORT_OFF;
+	pulses = DEFAULT_FLOW_PULSES;
+
+	last_count = 0;
+	window_timer = 0;
+	volume_pulses = 0;
+	volume = 0;
+	rate = 0;
+	ready_flag = false;
+}
+
+void FlowMeterDriver::begin(SystemManager* system) {
+	setPort(port);
+}
+
+bool FlowMeterDriver::start() {
+	if (getPort() == FLOW_PORT_OFF) {
+		return false;
+	}
+
+	// an aligned 32 bit read is atomic, the counter wraps safely
+	uint32_t count = pulses_count;
+	uint32_t delta = count - last_count;
+	uint32_t period = millis() - window_timer;
+
+	last_count = count;
+	window_timer = millis();
+
+	if (!period) {
+		return false;
+	}
+
+	rate = (uint64_t) delta * 100 * MIN_TO_MLS(1) / ((uint64_t) getPulses() * period);
+
+	volume_pulses += delta;
+	volume += volume_pulses / getPulses();
+	volume_pulses %= getPulses();
+
+	ready_flag = true;
+	return true;
+}
+
+bool FlowMeterDriver::poll() {
+	return ready_flag;
+}
+
+void FlowMeterDriver::collect(SensorsManager* sensors) {
+	ready_flag = false;
+
+	sensors->setSample(SENSOR_SOURCE_FLOW, SENSOR_TYPE_FLOW, getRate(), 0, "Flow");
+	sensors->setSample(SENSOR_SOURCE_FLOW_VOLUME, SENSOR_TYPE_VOLUME, (int32_t) (getVolume() * 100 + volume_pulses * 100 / getPulses()), 0, "Volume");
+}
+
+uint32_t FlowMeterDriver::getPeriod() {
+	return FLOW_WINDOW_TIME;
+}
+
+
+void FlowMeterDriver::setPort(uint8_t port) {
+	// esp8266 gpio 0 - 15, gpio 16 has no interrupt
+	if (port > 15) {
+		port = FLOW_PORT_OFF;
+	}
+
+	if (this->port != FLOW_PORT_OFF) {
+		detachInterrupt(this->port);
+	}
+
+	this->port = port;
+	rate = 0;
+
+	if (port == FLOW_PORT_OFF) {
+		return;
+	}
+
+	// open collector hall sensor
+	pinMode(port, INPUT_PULLUP);
+	last_count = pulses_count;
+	window_timer = millis();
+
+	attachInterrupt(port, pulseInterrupt, FALLING);
+}
+
+void FlowMeterDriver::setPulses(uint16_t pulses) {
+	this->pulses = constrain(pulses, FLOW_PULSES_MIN, FLOW_PULSES_MAX);
+	volume_pulses = 0;
+}
+
+void FlowMeterDriver::setVolume(uint32_t volume) {
+	this->volume = volume;
+	volume_pulses = 0;
+}
+
+
+uint8_t FlowMeterDriver::getPort() {
+	return port;
+}
+
+uint16_t FlowMeterDriver::getPulses() {
+	return pulses;
+}
+
+int32_t FlowMeterDriver::getRate() {
+	return rate;
+}
+
+uint32_t FlowMeterDriver::getVolume() {
+	return volume;
+}
+
+
+ICACHE_RAM_ATTR void FlowMeterDriver::pulseInterrupt() {
+	pulses_count++;
+}
+
+
+AnalogDriver::AnalogDriver() {
+	makeDefault();
+}
+
+void AnalogDriver::begin(SystemManager* system) {
+	burst_flag = false;
+	ready_flag = false;
+}
+
+bool AnalogDriver::start() {
+	if (!getWorkFlag() || burst_flag) {
+		return false;
+	}
+
+	reads = 0;
+	accumulator = 0;
+	read_timer = micros() - ANALOG_READ_INTERVAL;
+	burst_flag = true;
+
+	return true;
+}
+
+bool AnalogDriver::poll() {
+	// one conversion per tick at most
+	if (burst_flag && micros() - read_timer >= ANALOG_READ_INTERVAL) {
+		read_timer = micros();
+		accumulator += analogRead(ANALOG_PORT);
+		reads++;
+
+		if (reads >= ANALOG_OVERSAMPLE) {
+			// 16 reads of 10 bits decimate to 12 bits
+			raw = accumulator >> 2;
+			burst_flag = false;
+			ready_flag = true;
+		}
+	}
+
+	return ready_flag;
+}
+
+void AnalogDriver::collect(SensorsManager* sensors) {
+	ready_flag = false;
+
+	sensors->setSample(SENSOR_SOURCE_ANALOG, getType(), getValue(), 0, "A0");
+	sensors->getSample(SENSOR_SOURCE_ANALOG)->raw = getRaw();
+}
+
+void AnalogDriver::makeDefault() {
+	work_flag = DEFAULT_ANALOG_WORK_FLAG;
+	type = DEFAULT_ANALOG_TYPE;
+	points_count = 2;
+
+	// collinear points, any count gives the same full scale map
+	for (uint8_t i = 0;i < ANALOG_POINTS_COUNT;i++) {
+		points_raw[i] = (uint32_t) ANALOG_RAW_MAX * i / (ANALOG_POINTS_COUNT - 1);
+		points_value[i] = (int32_t) DEFAULT_ANALOG_MAX_VALUE * i / (ANALOG_POINTS_COUNT - 1);
+	}
+
+	burst_flag = false;
+	reads = 0;
+	accumulator = 0;
+	read_timer = 0;
+	raw = 0;
+	ready_flag = false;
+}
+
+
+void AnalogDriver::setWorkFlag(bool work_flag) {
+	this->work_flag = work_flag;
+	burst_flag = false;
+}
+
+void AnalogDriver::setType(uint8_t type) {
+	this->type = (type == SENSOR_TYPE_IRRADIANCE) ? SENSOR_TYPE_IRRADIANCE : SENSOR_TYPE_PRESSURE;
+}
+
+void AnalogDriver::setPointsCount(uint8_t count) {
+	points_count = constrain(count, 2, ANALOG_POINTS_COUNT);
+}
+
+void AnalogDriver::setPoint(uint8_t index, uint16_t raw, int32_t value) {
+	if (index >= ANALOG_POINTS_COUNT) {
+		return;
+	}
+
+	points_raw[index] = min(raw, (uint16_t) ANALOG_RAW_MAX);
+	points_value[index] = value;
+}
+
+
+bool AnalogDriver::getWorkFlag() {
+	return work_flag;
+}
+
+uint8_t AnalogDriver::getType() {
+	return type;
+}
+
+uint8_t AnalogDriver::getPointsCount() {
+	return points_count;
+}
+
+uint16_t AnalogDriver::getPointRaw(uint8_t index) {
+	if (index >= ANALOG_POINTS_COUNT) {
+		return 0;
+	}
+
+	return points_raw[index];
+}
+
+int32_t AnalogDriver::getPointValue(uint8_t index) {
+	if (index >= ANALOG_POINTS_COUNT) {
+		return 0;
+	}
+
+	return points_value[index];
+}
+
+uint16_t AnalogDriver::getRaw() {
+	return raw;
+}
+
+int32_t AnalogDriver::getValue() {
+	return calibrate(getRaw());
+}
+
+
+int32_t AnalogDriver::calibrate(uint16_t raw) {
+	uint8_t segment = 0;
+
+	// the last segment below the raw value, the ends extrapolate
+	while (segment + 2 < getPointsCount() && raw >= points_raw[segment + 1]) {
+		segment++;
+	}
+
+	int32_t raw_delta = (int32_t) points_raw[segment + 1] - points_raw[segment];
+	if (!raw_delta) {
+		return points_value[segment];
+	}
+
+	return points_value[segment] + (int64_t) (points_value[segment + 1] - points_value[segment]) * ((int32_t) raw - points_raw[segment]) / raw_delta;
+}
@@ -14,57 +14,205 @@ SensorsManager::SensorsManager() {
 }
 
 void SensorsManager::begin() {
-	oneWire.begin(DS18B20_PORT);
-	ds18b20_sensor.setOneWire(&oneWire);
-	
-	ds18b20_sensor.begin();
-	ds18b20_sensor.setResolution(12);
+	addDriver(&am2320);
+	addDriver(&flow);
+	addDriver(&analog);
+
+	for (uint8_t bus = 0;bus < DS18B20_BUS_COUNT;bus++) {
+		beginDS18B20Bus(bus);
+	}
 }
 
 
 void SensorsManager::tick() {
+	uint32_t tick_timer = micros();
+
 	if (getReadDataTime()) {
-		if (!read_data_timer || millis() - read_data_timer >= SEC_TO_MLS(getReadDataTime())) {
-			read_data_timer = millis();
-			updateSensorsData();
+		for (uint8_t bus = 0;bus < DS18B20_BUS_COUNT;bus++) {
+			scheduleDS18B20(bus);
+		}
+	}
+
+	driversTick();
+
+	// buses convert in parallel, readouts are interleaved one scratchpad per bus per tick,
+	// the wire of a bus has one owner per tick, a search pass or the pipeline
+	for (uint8_t bus = 0;bus < DS18B20_BUS_COUNT;bus++) {
+		if (getDS18B20BusPort(bus) == DS18B20_BUS_OFF) {
+			continue;
+		}
+
+		if (isDS18B20SearchTick(bus)) {
+			discoverDS18B20(bus);
+		}
+		else {
+			ds18b20Tick(bus);
+			checkDS18B20Bus(bus);
 		}
 	}
+
+	// average over ~16 ticks
+	stats.tick_time = micros() - tick_timer;
+	stats.tick_time_average = stats.tick_time_average - stats.tick_time_average / 16 + stats.tick_time / 16;
+	stats.tick_time_max = max(stats.tick_time_max, stats.tick_time);
 }
 
 void SensorsManager::makeDefault() {
-	memset(&am2320_data, 0, sizeof(am2320_data_t));
+	memset(drivers, 0, sizeof(drivers));
+	memset(drivers_timer, 0, sizeof(drivers_timer));
+	drivers_count = 0;
+	memset(&stats, 0, sizeof(sensors_stats_t));
 	ds18b20_data.clear();
 	ds18b20_data.setMaxSize(DS_SENSORS_MAX_COUNT);
+	memset(&ds18b20_bus_log, 0, sizeof(ds18b20_bus_log_t));
+	memset(&ds18b20_schedule, 0, sizeof(ds18b20_schedule_t));
+	memset(ds18b20_filter, 0, sizeof(ds18b20_filter));
+	memset(ds18b20_fault, 0, sizeof(ds18b20_fault));
+
+	for (uint8_t bus = 0;bus < DS18B20_BUS_COUNT;bus++) {
+		ds18b20_bus[bus].port = bus ? DEFAULT_DS18B20_BUS_PORT : DS18B20_PORT;
+		ds18b20_bus[bus].devices.clear();
+		ds18b20_bus[bus].valid_flag = false;
+		ds18b20_bus[bus].scan_timer = 0;
+		ds18b20_search[bus].devices.clear();
+		ds18b20_search[bus].state = DS18B20_SEARCH_IDLE;
+
+		memset(&ds18b20_pipeline[bus], 0, sizeof(ds18b20_pipeline_t));
+		ds18b20_pipeline[bus].state = DS18B20_STATE_IDLE;
+		memset(&ds18b20_transfer[bus], 0, sizeof(ds18b20_transfer_t));
+		ds18b20_transfer[bus].state = DS18B20_TRANSFER_IDLE;
+	}
+
+	samples_version = 0;
+
+	for (uint8_t source = 0;source < SENSOR_SAMPLES_COUNT;source++) {
+		memset(&samples[source], 0, sizeof(sensor_sample_t));
+		samples[source].quality = UNSPECIFIED_STATUS;
+		samples[source].source = source;
+	}
 
+	flow.setPulses(DEFAULT_FLOW_PULSES);
+	analog.makeDefault();
 	system = NULL;
-	am2320_data.status = UNSPECIFIED_STATUS;
 
 	read_data_time = DEFAULT_READ_DATA_TIME;
-	read_data_timer = 0;
+	auto_resolution_ratio = DEFAULT_AUTO_RESOLUTION_RATIO;
+	crc_period = DEFAULT_DS18B20_CRC_PERIOD;
+	adaptive_rate = DEFAULT_ADAPTIVE_RATE;
+	alarm_band = DEFAULT_DS18B20_ALARM_BAND;
+	fault_stuck_count = DEFAULT_FAULT_STUCK_COUNT;
+	fault_rate = DEFAULT_FAULT_RATE;
+	fault_pair_delta = DEFAULT_FAULT_PAIR_DELTA;
 }
 
 void SensorsManager::writeSettings(char* buffer) {
 	setParameter(buffer, "SSrdt", getReadDataTime());
+	setParameter(buffer, "SSarr", getAutoResolutionRatio());
+	setParameter(buffer, "SScrc", getCrcPeriod());
+	setParameter(buffer, "SSadr", getAdaptiveRate());
+	setParameter(buffer, "SSab", getAlarmBand());
+	setParameter(buffer, "SSfs", getFaultStuckCount());
+	setParameter(buffer, "SSfr", getFaultRate());
+	setParameter(buffer, "SSfp", getFaultPairDelta());
+	setParameter(buffer, "SSflp", getFlowPort());
+	setParameter(buffer, "SSflk", getFlowPulses());
+	setParameter(buffer, "SSanw", analog.getWorkFlag());
+	setParameter(buffer, "SSant", analog.getType());
+	setParameter(buffer, "SSanc", analog.getPointsCount());
+
+	for (uint8_t i = 0;i < ANALOG_POINTS_COUNT;i++) {
+		setParameter(buffer, String("SSanr") + i, analog.getPointRaw(i));
+		setParameter(buffer, String("SSanv") + i, analog.getPointValue(i));
+	}
+
+	for (uint8_t bus = 0;bus < DS18B20_BUS_COUNT;bus++) {
+		setParameter(buffer, String("SSDSbp") + bus, getDS18B20BusPort(bus));
+	}
 
 	for (uint8_t i = 0;i < getDS18B20Count();i++) {
 		setParameter(buffer, String("SSDSn") + i, (const char*) getDS18B20Name(i));
 		setParameter(buffer, String("SSDSa") + i, getDS18B20Address(i), 8);
 		setParameter(buffer, String("SSDSr") + i, getDS18B20Resolution(i));
+		setParameter(buffer, String("SSDSau") + i, getDS18B20AutoResolutionFlag(i));
+		setParameter(buffer, String("SSDSt") + i, getDS18B20ReadTime(i));
+		setParameter(buffer, String("SSDSad") + i, getDS18B20AdaptiveFlag(i));
+		setParameter(buffer, String("SSDSb") + i, getDS18B20Bus(i));
 		setParameter(buffer, String("SSDSc") + i, getDS18B20Correction(i));
+		setParameter(buffer, String("SSDSfm") + i, getDS18B20FilterMedian(i));
+		setParameter(buffer, String("SSDSfe") + i, getDS18B20FilterEma(i));
+		setParameter(buffer, String("SSDSfs") + i, getDS18B20FilterSlew(i));
+		setParameter(buffer, String("SSDSp") + i, getDS18B20Pair(i));
   	}
 }
 
 void SensorsManager::readSettings(char* buffer) {
 	uint8_t ds18b20_index = 0;
 	char ds18b20_name[DS_NAME_SIZE];
+	uint8_t flow_port;
+	uint16_t flow_pulses;
+	bool analog_work_flag;
+	uint8_t analog_type;
+	uint8_t analog_points_count;
 
 	getParameter(buffer, "SSrdt", &read_data_time);
+	getParameter(buffer, "SSarr", &auto_resolution_ratio);
+	getParameter(buffer, "SScrc", &crc_period);
+	getParameter(buffer, "SSadr", &adaptive_rate);
+	getParameter(buffer, "SSab", &alarm_band);
+	getParameter(buffer, "SSfs", &fault_stuck_count);
+	getParameter(buffer, "SSfr", &fault_rate);
+	getParameter(buffer, "SSfp", &fault_pair_delta);
+
+	if (getParameter(buffer, "SSflk", &flow_pulses)) {
+		setFlowPulses(flow_pulses);
+	}
+
+	if (getParameter(buffer, "SSflp", &flow_port)) {
+		setFlowPort(flow_port);
+	}
+
+	if (getParameter(buffer, "SSanw", &analog_work_flag)) {
+		setAnalogWorkFlag(analog_work_flag);
+	}
+
+	if (getParameter(buffer, "SSant", &analog_type)) {
+		analog.setType(analog_type);
+	}
+
+	if (getParameter(buffer, "SSanc", &analog_points_count)) {
+		analog.setPointsCount(analog_points_count);
+	}
+
+	for (uint8_t i = 0;i < ANALOG_POINTS_COUNT;i++) {
+		uint16_t point_raw;
+		int32_t point_value;
+
+		if (getParameter(buffer, String("SSanr") + i, &point_raw) && getParameter(buffer, String("SSanv") + i, &point_value)) {
+			analog.setPoint(i, point_raw, point_value);
+		}
+	}
+
+	for (uint8_t bus = 0;bus < DS18B20_BUS_COUNT;bus++) {
+		uint8_t bus_port;
+
+		if (getParameter(buffer, String("SSDSbp") + bus, &bus_port)) {
+			setDS18B20BusPort(bus, bus_port);
+		}
+	}
 	
 	while (getParameter(buffer, String("SSDSn") + ds18b20_index, ds18b20_name, DS_NAME_SIZE)) {
 		if (addDS18B20()) {
 			uint8_t ds18b20_address[8];
 			uint8_t ds18b20_resolution;
+			bool ds18b20_auto_resolution_flag;
+			uint8_t ds18b20_read_time;
+			bool ds18b20_adaptive_flag;
+			uint8_t ds18b20_bus_index;
 			float ds18b20_correction;
+			uint8_t ds18b20_filter_median;
+			uint8_t ds18b20_filter_ema;
+			uint8_t ds18b20_filter_slew;
+			int8_t ds18b20_pair;
 			
 			setDS18B20Name(ds18b20_index, ds18b20_name);
 
@@ -76,15 +224,54 @@ void SensorsManager::readSettings(char* buffer) {
 				setDS18B20Resolution(ds18b20_index, ds18b20_resolution);
 			}
 
+			if (getParameter(buffer, String("SSDSau") + ds18b20_index, &ds18b20_auto_resolution_flag)) {
+				setDS18B20AutoResolutionFlag(ds18b20_index, ds18b20_auto_resolution_flag);
+			}
+
+			if (getParameter(buffer, String("SSDSt") + ds18b20_index, &ds18b20_read_time)) {
+				setDS18B20ReadTime(ds18b20_index, ds18b20_read_time);
+			}
+
+			if (getParameter(buffer, String("SSDSad") + ds18b20_index, &ds18b20_adaptive_flag)) {
+				setDS18B20AdaptiveFlag(ds18b20_index, ds18b20_adaptive_flag);
+			}
+
+			if (getParameter(buffer, String("SSDSb") + ds18b20_index, &ds18b20_bus_index)) {
+				setDS18B20Bus(ds18b20_index, ds18b20_bus_index);
+			}
+
 			if (getParameter(buffer, String("SSDSc") + ds18b20_index, &ds18b20_correction)) {
 				setDS18B20Correction(ds18b20_index, ds18b20_correction);
 			}
+
+			if (getParameter(buffer, String("SSDSfm") + ds18b20_index, &ds18b20_filter_median)) {
+				setDS18B20FilterMedian(ds18b20_index, ds18b20_filter_median);
+			}
+
+			if (getParameter(buffer, String("SSDSfe") + ds18b20_index, &ds18b20_filter_ema)) {
+				setDS18B20FilterEma(ds18b20_index, ds18b20_filter_ema);
+			}
+
+			if (getParameter(buffer, String("SSDSfs") + ds18b20_index, &ds18b20_filter_slew)) {
+				setDS18B20FilterSlew(ds18b20_index, ds18b20_filter_slew);
+			}
+
+			if (getParameter(buffer, String("SSDSp") + ds18b20_index, &ds18b20_pair)) {
+				setDS18B20Pair(ds18b20_index, ds18b20_pair);
+			}
 		}
 
 		ds18b20_index++;
 	}
 
 	setReadDataTime(read_data_time);
+	setAutoResolutionRatio(auto_resolution_ratio);
+	setCrcPeriod(crc_period);
+	setAdaptiveRate(adaptive_rate);
+	setAlarmBand(alarm_band);
+	setFaultStuckCount(fault_stuck_count);
+	setFaultRate(fault_rate);
+	setFaultPairDelta(fault_pair_delta);
 }
 
 #ifdef MODULE_MANAGER_BLYNK_SUPPORT
@@ -99,6 +286,12 @@ void SensorsManager::addBlynkElementCodes(DynamicArray<String>* array) {
 	for (uint8_t i = 0; i < ds18b20_data.size();i++) {
 		array->add(String("HSdst") + getDS18B20Name(i));
 	}
+
+	for (uint8_t source = SENSOR_SOURCE_DRIVERS;source < getSamplesCount();source++) {
+		if (getSample(source)->type != SENSOR_TYPE_NONE) {
+			array->add(String("HSsm") + source);
+		}
+	}
 }
 
 bool SensorsManager::blynkElementSend(BlynkWifi* Blynk, blynk_link_t* link) {
@@ -107,27 +300,36 @@ bool SensorsManager::blynkElementSend(BlynkWifi* Blynk, blynk_link_t* link) {
 	}
 
 	if (!strcmp(link->element_code, "HSt")) {
-		Blynk->virtualWrite(link->port, getAM2320T());
+		Blynk->virtualWrite(link->port, getSample(SENSOR_SOURCE_AM2320_T)->value / 100.0);
 		return true;
 	}
 	
 	if (!strcmp(link->element_code, "HSh")) {
-		Blynk->virtualWrite(link->port, getAM2320H());
+		Blynk->virtualWrite(link->port, getSample(SENSOR_SOURCE_AM2320_H)->value / 100.0);
 		return true;
 	}
 
 	for (uint8_t i = 0;i < getDS18B20Count();i++) {
-		if (!getDS18B20Status(i)) {
+		sensor_sample_t* sample = getSample(SENSOR_SOURCE_DS18B20 + i);
+
+		if (!sample->quality) {
 			char element_code[BLYNK_ELEMENT_CODE_SIZE] = "HSdst";
 			strcat(element_code, getDS18B20Name(i));
 
 			if (!strcmp(link->element_code, element_code)) {
-				Blynk->virtualWrite(link->port, getDS18B20T(i));
+				Blynk->virtualWrite(link->port, sample->value / 100.0);
 				return true;
 			}
 		}
 	}
 
+	for (uint8_t source = SENSOR_SOURCE_DRIVERS;source < getSamplesCount();source++) {
+		if (getSample(source)->type != SENSOR_TYPE_NONE && String(link->element_code) == String("HSsm") + source) {
+			Blynk->virtualWrite(link->port, getSample(source)->value / 100.0);
+			return true;
+		}
+	}
+
 	return false;
 }
 
@@ -139,9 +341,23 @@ bool SensorsManager::blynkElementParse(String code, const BlynkParam& param) {
 
 bool SensorsManager::addDS18B20() {
 	if (ds18b20_data.add()) {
+		ds18b20_data[ds18b20_data.size() - 1] = ds18b20_data_t();
+		ds18b20_pipeline[DEFAULT_DS18B20_BUS].state = DS18B20_STATE_IDLE;
+		ds18b20_transfer[DEFAULT_DS18B20_BUS].state = DS18B20_TRANSFER_IDLE;
+
 		setDS18B20Name(ds18b20_data.size() - 1, DEFAULT_DS18B20_NAME);
 		setDS18B20Resolution(ds18b20_data.size() - 1, DEFAULT_DS18B20_RESOLUTION);
-		ds18b20_data[ds18b20_data.size() - 1].status = UNSPECIFIED_STATUS;
+		setDS18B20AutoResolutionFlag(ds18b20_data.size() - 1, DEFAULT_DS18B20_AUTO_RESOLUTION_FLAG);
+		setDS18B20ReadTime(ds18b20_data.size() - 1, DEFAULT_DS18B20_READ_TIME);
+		setDS18B20AdaptiveFlag(ds18b20_data.size() - 1, DEFAULT_DS18B20_ADAPTIVE_FLAG);
+		setDS18B20Bus(ds18b20_data.size() - 1, DEFAULT_DS18B20_BUS);
+		setDS18B20FilterMedian(ds18b20_data.size() - 1, DEFAULT_DS18B20_FILTER_MEDIAN);
+		setDS18B20FilterEma(ds18b20_data.size() - 1, DEFAULT_DS18B20_FILTER_EMA);
+		setDS18B20FilterSlew(ds18b20_data.size() - 1, DEFAULT_DS18B20_FILTER_SLEW);
+		setDS18B20Pair(ds18b20_data.size() - 1, DEFAULT_DS18B20_PAIR);
+		resetDS18B20Filter(ds18b20_data.size() - 1);
+		memset(&ds18b20_fault[ds18b20_data.size() - 1], 0, sizeof(ds18b20_fault_t));
+		setSample(SENSOR_SOURCE_DS18B20 + ds18b20_data.size() - 1, SENSOR_TYPE_TEMPERATURE, 0, UNSPECIFIED_STATUS);
 
 		return true;
 	}
@@ -155,6 +371,37 @@ bool SensorsManager::deleteDS18B20(uint8_t index) {
 	}
 
 	if (ds18b20_data.del(index)) {
+		// sensor masks of every bus are shifted
+		for (uint8_t bus = 0;bus < DS18B20_BUS_COUNT;bus++) {
+			ds18b20_pipeline[bus].state = DS18B20_STATE_IDLE;
+			ds18b20_transfer[bus].state = DS18B20_TRANSFER_IDLE;
+		}
+		resetDS18B20Schedule();
+
+		// so are the samples, the source id follows the sensor index
+		for (uint8_t i = index;i < getDS18B20Count();i++) {
+			sensor_sample_t* sample = getSample(SENSOR_SOURCE_DS18B20 + i);
+
+			*sample = samples[SENSOR_SOURCE_DS18B20 + i + 1];
+			sample->source = SENSOR_SOURCE_DS18B20 + i;
+			ds18b20_filter[i] = ds18b20_filter[i + 1];
+			ds18b20_fault[i] = ds18b20_fault[i + 1];
+		}
+
+		for (uint8_t i = 0;i < getDS18B20Count();i++) {
+			if (getDS18B20Pair(i) == index) {
+				setDS18B20Pair(i, -1);
+			}
+			else if (getDS18B20Pair(i) > index) {
+				setDS18B20Pair(i, getDS18B20Pair(i) - 1);
+			}
+		}
+
+		memset(getSample(SENSOR_SOURCE_DS18B20 + getDS18B20Count()), 0, sizeof(sensor_sample_t));
+		getSample(SENSOR_SOURCE_DS18B20 + getDS18B20Count())->quality = UNSPECIFIED_STATUS;
+		getSample(SENSOR_SOURCE_DS18B20 + getDS18B20Count())->source = SENSOR_SOURCE_DS18B20 + getDS18B20Count();
+		samples_version++;
+
 		#ifdef MODULE_MANAGER_BLYNK_SUPPORT
 		system->deleteBlynkLink(String("HSdst") + getDS18B20Name(index));
 		#endif
@@ -166,239 +413,2020 @@ bool SensorsManager::deleteDS18B20(uint8_t index) {
 }
 
 void SensorsManager::updateSensorsData() {
-	am2320_data.status = am2320_sensor.read(&am2320_data.t, &am2320_data.h);
-	ds18b20_sensor.requestTemperatures();
-
-	for (uint8_t i = 0;i < getDS18B20Count();i++) {
-		ds18b20_data[i].t = ds18b20_sensor.getTempC(getDS18B20Address(i));
+	for (uint8_t i = 0;i < drivers_count;i++) {
+		drivers[i]->start();
+	}
 
-		if (getDS18B20T(i) < -100) {
-			ds18b20_data[i].status = 1;
-		}
-		else if (getDS18B20T(i) == 85) {
-			ds18b20_data[i].status = 2;
-		}
-		else {
-			ds18b20_data[i].status = 0;
-			ds18b20_data[i].t += getDS18B20Correction(i);
-		}
+	for (uint8_t bus = 0;bus < DS18B20_BUS_COUNT;bus++) {
+		requestDS18B20Conversion(bus, getDS18B20BusMask(bus));
 	}
 }
 
-
-uint8_t SensorsManager::makeDS18B20AddressList(DynamicArray<DeviceAddress>* array, DynamicArray<float>* t_array, DynamicArray<String>* string_array) {
-	if (array == NULL) {
-		return 0;
+bool SensorsManager::addDriver(SensorDriver* driver) {
+	if (driver == NULL || drivers_count >= SENSOR_DRIVERS_MAX_COUNT) {
+		return false;
 	}
 
-	uint8_t sensors_count = getGlobalDS18B20Count();
-	array->clear();
+	driver->begin(system);
+	drivers_timer[drivers_count] = 0;
+	drivers[drivers_count++] = driver;
 
-	if (t_array != NULL) {
-		t_array->clear();
-		ds18b20_sensor.requestTemperatures();
-	}
+	return true;
+}
 
-	if (string_array != NULL) {
-		string_array->clear();
-	}
+void SensorsManager::setSample(uint8_t source, uint8_t type, int32_t value, uint8_t quality, const char* name) {
+	sensor_sample_t* sample = getSample(source);
 
-	if (!sensors_count) {
-		return 0;
+	if (sample == NULL) {
+		return;
 	}
 
-	for (uint8_t i = 0;i < sensors_count;i++) {
-		DeviceAddress address;
+	sample->value = value;
+	sample->raw = value;
+	sample->time = millis();
+	sample->quality = quality;
+	sample->type = type;
+	sample->name = name;
+	samples_version++;
+}
 
-		ds18b20_sensor.getAddress(address, i);
-		array->add(&address);
+void SensorsManager::driversTick() {
+	// every driver makes one step per tick, the results are collected as soon as they are ready
+	for (uint8_t i = 0;i < drivers_count;i++) {
+		uint32_t period = drivers[i]->getPeriod() ? drivers[i]->getPeriod() : SEC_TO_MLS(getReadDataTime());
 
-		if (t_array != NULL) {
-			t_array->add(ds18b20_sensor.getTempC(address));
+		if (period && (!drivers_timer[i] || millis() - drivers_timer[i] >= period)) {
+			drivers_timer[i] = millis();
+			drivers[i]->start();
 		}
 
-		if (string_array != NULL) {
-			String string_address;
-
-			DS18B20AddressToString(address, &string_address);
-			string_array->add(string_address);
+		if (drivers[i]->poll()) {
+			drivers[i]->collect(this);
 		}
 	}
-
-	return sensors_count;
 }
 
-int8_t SensorsManager::scanDS18B20AddressIndex(DynamicArray<DeviceAddress>* array, uint8_t* address) {
-	if (array == NULL || address == NULL) {
-		return -1;
-	}
 
-	for (uint8_t i = 0; i < array->size();i++) {
-		if (!memcmp((*array)[i], address, 8)) {
-			return i;
-		}
+void SensorsManager::beginDS18B20Bus(uint8_t bus) {
+	ds18b20_pipeline[bus].state = DS18B20_STATE_IDLE;
+	ds18b20_transfer[bus].state = DS18B20_TRANSFER_IDLE;
+	ds18b20_search[bus].state = DS18B20_SEARCH_IDLE;
+	ds18b20_search[bus].devices.clear();
+	ds18b20_bus[bus].devices.clear();
+	ds18b20_bus[bus].valid_flag = false;
+
+	if (getDS18B20BusPort(bus) == DS18B20_BUS_OFF) {
+		return;
 	}
 
-	return -1;
-}
+	oneWire[bus].begin(getDS18B20BusPort(bus));
+	ds18b20_sensor[bus].setOneWire(&oneWire[bus]);
 
+	ds18b20_sensor[bus].setWaitForConversion(false);
 
-void SensorsManager::setSystemManager(SystemManager* system) {
-	this->system = system;
+	// the first round fills the bus cache and brings the power mode in the background
+	ds18b20_sensor[bus].setParasitePowerMode(false);
+	startDS18B20Search(bus);
 }
 
-void SensorsManager::setReadDataTime(uint8_t time) {
-	read_data_time = constrain(time, 0, 100);
-}
+void SensorsManager::ds18b20Tick(uint8_t bus) {
+	uint32_t convert_time = millis() - ds18b20_pipeline[bus].convert_timer;
+	bool parasite_flag = ds18b20_sensor[bus].isParasitePowerMode();
 
+	switch (ds18b20_pipeline[bus].state) {
+	case DS18B20_STATE_IDLE:
+		if (ds18b20_search[bus].state < DS18B20_SEARCH_PASS && !armDS18B20Alarm(bus)) {
+			syncDS18B20Config(bus);
+		}
 
-void SensorsManager::setDS18B20(uint8_t index, ds18b20_data_t* ds18b20) {
-	setDS18B20Name(index, ds18b20->name);
-	setDS18B20Address(index, ds18b20->address);
-	setDS18B20Resolution(index, ds18b20->resolution);
-	setDS18B20Correction(index, ds18b20->correction);
-}
+		break;
+	case DS18B20_STATE_CONVERT:
+		{
+		bool complete_flag = (convert_time >= ds18b20_pipeline[bus].convert_time);
 
-void SensorsManager::setDS18B20Name(uint8_t index, String name) {
-	if (!isCorrectDS18B20Index(index)) {
-		return;
-	}
-	
-	#ifdef MODULE_MANAGER_BLYNK_SUPPORT
-	system->modifyBlynkLinkElementCode(String("HSdst") + getDS18B20Name(index), String("HSdst") + name);
-	#endif
+		// the conversion flag is valid only until the first scratchpad read
+		if (!complete_flag && !parasite_flag && !(ds18b20_pipeline[bus].read_mask & ds18b20_pipeline[bus].cycle_mask) &&
+		    !ds18b20_pipeline[bus].retry_mask && ds18b20_transfer[bus].state != DS18B20_TRANSFER_BUSY) {
+			stats.onewire_transactions++;
+			complete_flag = ds18b20_sensor[bus].isConversionComplete();
+		}
 
-	name.toCharArray(ds18b20_data[index].name, 3);
-}
+		if (complete_flag) {
+			if (getAlarmBand()) {
+				startDS18B20AlarmSearch(bus);
+			}
+			else {
+				ds18b20_pipeline[bus].state = DS18B20_STATE_READ;
+			}
 
-void SensorsManager::setDS18B20Address(uint8_t index, uint8_t* address) {
-	if (!isCorrectDS18B20Index(index) || !*address) {
-		return;
-	}
+			break;
+		}
+
+		// in parasite mode the bus must stay idle until every group is converted,
+		// alarm flags are set only at the end of the conversion
+		if (!parasite_flag && !getAlarmBand()) {
+			readNextDS18B20(bus, getReadyResolution(convert_time));
+		}
+		}
 
-	memcpy(ds18b20_data[index].address, address, 8);
-	setDS18B20Resolution(index, getDS18B20Resolution(index, false));
+		break;
+	case DS18B20_STATE_ALARM:
+		alarmDS18B20(bus);
+		break;
+	case DS18B20_STATE_READ:
+		readNextDS18B20(bus, 12);
+		break;
+	case DS18B20_STATE_PUBLISH:
+		publishDS18B20Data(bus);
+		ds18b20_pipeline[bus].state = DS18B20_STATE_IDLE;
+
+		break;
+	}
 }
 
-void SensorsManager::setDS18B20Resolution(uint8_t index, uint8_t resolution) {
-	if (!isCorrectDS18B20Index(index)) {
+void SensorsManager::scheduleDS18B20(uint8_t bus) {
+	if (ds18b20_pipeline[bus].state != DS18B20_STATE_IDLE || getDS18B20BusPort(bus) == DS18B20_BUS_OFF) {
 		return;
 	}
 
-	if (*getDS18B20Address(index)) {
-		ds18b20_sensor.setResolution(getDS18B20Address(index), resolution);
-		ds18b20_data[index].resolution = ds18b20_sensor.getResolution(getDS18B20Address(index));
+	uint16_t mask = 0;
+	bool due_flag = false;
+
+	for (uint8_t i = 0;i < getDS18B20Count();i++) {
+		if (getDS18B20Bus(i) != bus) {
+			continue;
+		}
+
+		uint32_t interval = getDS18B20ReadInterval(i);
+		uint32_t read_time = millis() - ds18b20_schedule.read_timer[i];
+
+		if (!ds18b20_schedule.read_timer[i] || read_time >= interval) {
+			due_flag = true;
+		}
+
+		// sensors that are almost due share the conversion instead of starting their own
+		if (!ds18b20_schedule.read_timer[i] || read_time + interval / DS18B20_SCHEDULE_RATIO >= interval) {
+			mask |= (1 << i);
+		}
 	}
-	else {
-		ds18b20_data[index].resolution = resolution;
+
+	if (due_flag) {
+		requestDS18B20Conversion(bus, mask);
 	}
 }
 
-void SensorsManager::setDS18B20Correction(uint8_t index, float correction) {
-	if (!isCorrectDS18B20Index(index)) {
-		return;
+bool SensorsManager::requestDS18B20Conversion(uint8_t bus, uint16_t mask) {
+	if (bus >= DS18B20_BUS_COUNT || getDS18B20BusPort(bus) == DS18B20_BUS_OFF) {
+		return false;
 	}
 
-	ds18b20_data[index].correction = constrain(correction, -20.0, 20.0);
-}
+	mask &= getDS18B20BusMask(bus);
 
+	// a pass or a started transfer owns the bus
+	if (ds18b20_pipeline[bus].state != DS18B20_STATE_IDLE || ds18b20_search[bus].state >= DS18B20_SEARCH_PASS || ds18b20_transfer[bus].state == DS18B20_TRANSFER_BUSY || !mask) {
+		return false;
+	}
 
-DallasTemperature* SensorsManager::getDallasTemperature() {
-	return &ds18b20_sensor;
-}
+	uint8_t resolution = 9;
+	for (uint8_t i = 0;i < getDS18B20Count();i++) {
+		if (getDS18B20Bus(i) != bus) {
+			continue;
+		}
 
-uint8_t SensorsManager::getReadDataTime() {
-	return read_data_time;
-}
+		if (getDS18B20AutoResolutionFlag(i)) {
+			setDS18B20Resolution(i, getDS18B20AutoResolution(i));
+		}
 
+		// a device that is not configured yet still converts with its previous resolution
+		ds18b20_schedule.resolution[i] = ds18b20_data[i].dirty_flag ? 12 : ds18b20_data[i].resolution;
 
-float SensorsManager::getAM2320T() {
-	return am2320_data.t;
-}
+		if (mask & (1 << i)) {
+			resolution = max(resolution, ds18b20_schedule.resolution[i]);
+		}
+	}
 
-float SensorsManager::getAM2320H() {
-	return am2320_data.h;
-}
+	ds18b20_sensor[bus].requestTemperatures();
+	stats.onewire_transactions++;
 
-uint8_t SensorsManager::getAM2320Status() {
-	return am2320_data.status;
+	// sensors out of the cycle are converted by the broadcast, but never read
+	ds18b20_pipeline[bus].cycle++;
+	ds18b20_pipeline[bus].cycle_mask = mask;
+	ds18b20_pipeline[bus].read_mask = ~ds18b20_pipeline[bus].cycle_mask & ((1 << getDS18B20Count()) - 1);
+	ds18b20_pipeline[bus].retry_mask = 0;
+	ds18b20_pipeline[bus].alarm_mask = 0;
+	ds18b20_pipeline[bus].quiet_mask = 0;
+	ds18b20_pipeline[bus].convert_time = ds18b20_sensor[bus].millisToWaitForConversion(resolution);
+	ds18b20_pipeline[bus].convert_timer = millis();
+	ds18b20_pipeline[bus].state = DS18B20_STATE_CONVERT;
+
+	return true;
 }
 
+bool SensorsManager::readNextDS18B20(uint8_t bus, uint8_t max_resolution) {
+	// one scratchpad at a time, a part of it per tick, lower resolution groups are ready first
+	for (uint8_t i = 0;i < getDS18B20Count();i++) {
+		if (ds18b20_pipeline[bus].read_mask & (1 << i)) {
+			continue;
+		}
 
-uint8_t SensorsManager::getGlobalDS18B20Count() {
-	ds18b20_sensor.begin();
-	return ds18b20_sensor.getDS18Count();
-}
+		if (*getDS18B20Address(i) && ds18b20_schedule.resolution[i] > max_resolution) {
+			continue;
+		}
 
-float SensorsManager::getDS18B20TByAddress(uint8_t* address) {
-	ds18b20_sensor.requestTemperaturesByAddress(address);
-	return ds18b20_sensor.getTempC(address);
-}
+		uint8_t result = readDS18B20(bus, i);
 
-uint8_t SensorsManager::getDS18B20Count() {
-	return ds18b20_data.size();
-}
+		if (result == DS18B20_TRANSFER_BUSY) {
+			return true;
+		}
 
-ds18b20_data_t* SensorsManager::getDS18B20(uint8_t index) {
-	if (!isCorrectDS18B20Index(index)) {
-		return NULL;
-	}
+		// a failed read is repeated once
+		if (result == DS18B20_TRANSFER_FAILED && !(ds18b20_pipeline[bus].retry_mask & (1 << i))) {
+			ds18b20_pipeline[bus].retry_mask |= (1 << i);
+			return true;
+		}
 
-	return &ds18b20_data[index];
-}
+		ds18b20_pipeline[bus].read_mask |= (1 << i);
 
-char* SensorsManager::getDS18B20Name(uint8_t index) {
-	if (!isCorrectDS18B20Index(index)) {
-		return NULL;
+		if (ds18b20_pipeline[bus].read_mask == (1 << getDS18B20Count()) - 1) {
+			ds18b20_pipeline[bus].state = DS18B20_STATE_PUBLISH;
+		}
+
+		return true;
 	}
 
-	return ds18b20_data[index].name;
+	return false;
 }
 
-uint8_t* SensorsManager::getDS18B20Address(uint8_t index) {
-	if (!isCorrectDS18B20Index(index)) {
-		return NULL;
+uint8_t SensorsManager::readDS18B20(uint8_t bus, uint8_t index) {
+	uint8_t* address = getDS18B20Address(index);
+	uint8_t* scratchpad = ds18b20_transfer[bus].data;
+
+	if (ds18b20_transfer[bus].state != DS18B20_TRANSFER_BUSY) {
+		bool full_flag = true;
+
+		ds18b20_schedule.t[index] = DS18B20_DISCONNECTED_T;
+
+		if (!*address) {
+			return DS18B20_TRANSFER_DONE;
+		}
+
+		// the full scratchpad with crc is read every crc_period cycles, after an error and on retry
+		// in alarm mode the rare reads are full to check th/tl
+		if (getCrcPeriod() && ds18b20_pipeline[bus].cycle % getCrcPeriod() && !getDS18B20Status(index) && !(ds18b20_pipeline[bus].retry_mask & (1 << index)) && !getAlarmBand()) {
+			full_flag = false;
+		}
+
+		startDS18B20Transfer(bus, DS18B20_TRANSFER_READ, index, address, DS18B20_READ_SCRATCHPAD, NULL, 0, full_flag ? 9 : 2);
 	}
 
-	return ds18b20_data[index].address;
-}
+	uint8_t result = transferDS18B20(bus);
+	if (result != DS18B20_TRANSFER_DONE) {
+		return result;
+	}
 
-uint8_t SensorsManager::getDS18B20Resolution(uint8_t index, bool sync_flag) {
-	if (!isCorrectDS18B20Index(index)) {
-		return 0;
+	if (ds18b20_transfer[bus].read_length == 9) {
+		bool missing_flag = true;
+
+		for (uint8_t i = 0;i < 9;i++) {
+			if (scratchpad[i] != 0xFF) {
+				missing_flag = false;
+				break;
+			}
+		}
+
+		if (missing_flag) {
+			return DS18B20_TRANSFER_FAILED;
+		}
+
+		if (OneWire::crc8(scratchpad, 8) != scratchpad[8]) {
+			ds18b20_data[index].crc_errors++;
+			return DS18B20_TRANSFER_FAILED;
+		}
+
+		// a power-on reset restores th/tl from the eeprom
+		if (scratchpad[2] != (uint8_t) ds18b20_schedule.alarm_high[index] || scratchpad[3] != (uint8_t) ds18b20_schedule.alarm_low[index]) {
+			ds18b20_schedule.armed_mask &= ~(1 << index);
+		}
 	}
 
-	if (*getDS18B20Address(index) && sync_flag) {
-		ds18b20_data[index].resolution = ds18b20_sensor.getResolution(getDS18B20Address(index));
+	// a missing device leaves the bus high
+	else if (scratchpad[0] == 0xFF && scratchpad[1] == 0xFF) {
+		return DS18B20_TRANSFER_FAILED;
 	}
 
-	return ds18b20_data[index].resolution;
+	ds18b20_schedule.t[index] = convertDS18B20Raw(scratchpad, address[0], ds18b20_schedule.resolution[index]);
+	return DS18B20_TRANSFER_DONE;
 }
 
-float SensorsManager::getDS18B20Correction(uint8_t index) {
-	if (!isCorrectDS18B20Index(index)) {
-		return 0;
+int16_t SensorsManager::convertDS18B20Raw(uint8_t* scratchpad, uint8_t family, uint8_t resolution) {
+	int16_t raw = (((int16_t) scratchpad[1]) << 8) | scratchpad[0];
+
+	if (family == DS18S20MODEL) {
+		return raw * 50;
 	}
 
-	return ds18b20_data[index].correction;
+	// undefined low bits of 9-11 bit conversions, 1/16° -> c° with rounding
+	raw &= ~((1 << (12 - resolution)) - 1);
+	return ((int32_t) raw * 25 + 2) >> 2;
 }
 
-float SensorsManager::getDS18B20T(uint8_t index) {
-	if (!isCorrectDS18B20Index(index)) {
-		return 0;
+void SensorsManager::startDS18B20Transfer(uint8_t bus, uint8_t owner, uint8_t index, uint8_t* address, uint8_t command, const uint8_t* data, uint8_t write_length, uint8_t read_length) {
+	ds18b20_transfer_t* transfer = &ds18b20_transfer[bus];
+
+	if (address != NULL) {
+		memcpy(transfer->address, address, sizeof(DeviceAddress));
+	}
+	else {
+		memset(transfer->address, 0, sizeof(DeviceAddress));
+	}
+
+	if (data != NULL) {
+		memcpy(transfer->data, data, write_length);
 	}
 
-	return ds18b20_data[index].t;
+	transfer->owner = owner;
+	transfer->index = index;
+	transfer->command = command;
+	transfer->write_length = write_length;
+	transfer->read_length = read_length;
+	transfer->position = 0;
+	transfer->state = DS18B20_TRANSFER_BUSY;
 }
 
-uint8_t SensorsManager::getDS18B20Status(uint8_t index) {
-	if (!isCorrectDS18B20Index(index)) {
-		return UNSPECIFIED_STATUS;
+uint8_t SensorsManager::transferDS18B20(uint8_t bus) {
+	ds18b20_transfer_t* transfer = &ds18b20_transfer[bus];
+	uint8_t length = 10 + transfer->write_length + transfer->read_length;
+	uint8_t budget = DS18B20_TRANSFER_BYTES;
+
+	if (transfer->state != DS18B20_TRANSFER_BUSY) {
+		return DS18B20_TRANSFER_IDLE;
 	}
 
-	return ds18b20_data[index].status;
-}
+	if (!transfer->position) {
+		stats.onewire_transactions++;
+
+		if (!oneWire[bus].reset()) {
+			transfer->state = DS18B20_TRANSFER_IDLE;
+			return DS18B20_TRANSFER_FAILED;
+		}
+
+		transfer->position++;
+		budget -= 2;
+	}
 
+	// the master owns the slot timing, the devices wait between ticks
+	for (;budget && transfer->position <= length;budget--, transfer->position++) {
+		uint8_t byte = transfer->position - 1;
+
+		if (!byte) {
+			oneWire[bus].write(*transfer->address ? DS18B20_MATCH_ROM : DS18B20_SKIP_ROM);
+
+			// every device of the bus listens, no rom follows
+			if (!*transfer->address) {
+				transfer->position += sizeof(DeviceAddress);
+			}
+		}
+		else if (byte <= sizeof(DeviceAddress)) {
+			oneWire[bus].write(transfer->address[byte - 1]);
+		}
+		else if (byte == sizeof(DeviceAddress) + 1) {
+			// a parasite device takes the eeprom write current from the strong pullup
+			oneWire[bus].write(transfer->command, transfer->command == DS18B20_COPY_SCRATCHPAD && ds18b20_sensor[bus].isParasitePowerMode());
+		}
+		else if (byte < 10 + transfer->write_length) {
+			oneWire[bus].write(transfer->data[byte - 10]);
+		}
+		else {
+			transfer->data[byte - 10 - transfer->write_length] = oneWire[bus].read();
+		}
+	}
+
+	if (transfer->position <= length || budget < 2) {
+		return DS18B20_TRANSFER_BUSY;
+	}
+
+	// the bus stays idle until the eeprom is written
+	if (transfer->command == DS18B20_COPY_SCRATCHPAD) {
+		if (transfer->position == length + 1) {
+			transfer->position++;
+			transfer->copy_timer = millis();
+		}
+
+		if (millis() - transfer->copy_timer < DS18B20_COPY_TIME) {
+			return DS18B20_TRANSFER_BUSY;
+		}
+
+		oneWire[bus].depower();
+	}
+
+	// reset terminates a partial read
+	oneWire[bus].reset();
+	transfer->state = DS18B20_TRANSFER_IDLE;
+
+	return DS18B20_TRANSFER_DONE;
+}
+
+void SensorsManager::publishDS18B20Data(uint8_t bus) {
+	for (uint8_t i = 0;i < getDS18B20Count();i++) {
+		if (!(ds18b20_pipeline[bus].cycle_mask & (1 << i))) {
+			continue;
+		}
+
+		// no alarm, the value is still inside the band
+		if (ds18b20_pipeline[bus].quiet_mask & (1 << i)) {
+			ds18b20_schedule.read_timer[i] = ds18b20_pipeline[bus].convert_timer;
+			getSample(SENSOR_SOURCE_DS18B20 + i)->time = millis();
+
+			continue;
+		}
+
+		if (getDS18B20AdaptiveFlag(i)) {
+			adaptDS18B20Interval(i, ds18b20_schedule.t[i], ds18b20_pipeline[bus].convert_timer - ds18b20_schedule.read_timer[i]);
+		}
+
+		ds18b20_schedule.read_timer[i] = ds18b20_pipeline[bus].convert_timer;
+
+		if (ds18b20_schedule.t[i] <= DS18B20_DISCONNECTED_T) {
+			setSample(SENSOR_SOURCE_DS18B20 + i, SENSOR_TYPE_TEMPERATURE, ds18b20_schedule.t[i], DS18B20_STATUS_DISCONNECTED);
+		}
+		else if (ds18b20_schedule.t[i] == DS18B20_POWER_ON_T) {
+			setSample(SENSOR_SOURCE_DS18B20 + i, SENSOR_TYPE_TEMPERATURE, ds18b20_schedule.t[i], DS18B20_STATUS_POWER_ON);
+		}
+		else {
+			int16_t t = ds18b20_schedule.t[i] + ds18b20_data[i].correction;
+			uint8_t status = checkDS18B20Fault(i, t);
+
+			// a faulty value does not enter the filter
+			setSample(SENSOR_SOURCE_DS18B20 + i, SENSOR_TYPE_TEMPERATURE, status ? t : filterDS18B20(i, t), status);
+			getSample(SENSOR_SOURCE_DS18B20 + i)->raw = t;
+		}
+
+		updateDS18B20Alarm(i);
+	}
+}
+
+void SensorsManager::adaptDS18B20Interval(uint8_t index, int16_t t, uint32_t period) {
+	uint32_t base_interval = SEC_TO_MLS(getDS18B20ReadTime(index) ? getDS18B20ReadTime(index) : getReadDataTime());
+	uint32_t interval = getDS18B20ReadInterval(index);
+
+	// errors and the first sample restart from the configured time
+	if (!ds18b20_schedule.read_timer[index] || !period || getDS18B20Status(index) || t <= DS18B20_DISCONNECTED_T || t == DS18B20_POWER_ON_T) {
+		ds18b20_schedule.read_interval[index] = 0;
+		return;
+	}
+
+	// c°/min against 0.1°/min
+	uint32_t rate = (uint32_t) abs((t + ds18b20_data[index].correction) - getDS18B20RawTCenti(index)) * MIN_TO_MLS(1) / period;
+	uint32_t rate_limit = (uint32_t) getAdaptiveRate() * 10;
+
+	if (rate >= rate_limit) {
+		interval = max((uint32_t) DS18B20_ADAPTIVE_MIN_TIME, interval / 2);
+	}
+	else if (rate * 4 < rate_limit) {
+		interval = min(base_interval * DS18B20_ADAPTIVE_MAX_RATIO, interval + interval / 4);
+	}
+
+	ds18b20_schedule.read_interval[index] = interval;
+}
+
+int16_t SensorsManager::filterDS18B20(uint8_t index, int16_t t) {
+	ds18b20_filter_t* filter = &ds18b20_filter[index];
+	int16_t window[DS18B20_FILTER_MEDIAN_MAX];
+	uint8_t count;
+
+	// the ring keeps the last samples for the widest window
+	filter->history[filter->head] = t;
+	filter->head = (filter->head + 1) % DS18B20_FILTER_MEDIAN_MAX;
+	filter->count = min(filter->count + 1, DS18B20_FILTER_MEDIAN_MAX);
+	count = min(filter->count, getDS18B20FilterMedian(index));
+
+	// insertion sort of at most 5 values
+	for (uint8_t i = 0;i < count;i++) {
+		int16_t value = filter->history[(filter->head + DS18B20_FILTER_MEDIAN_MAX - 1 - i) % DS18B20_FILTER_MEDIAN_MAX];
+		uint8_t j = i;
+
+		for (;j && window[j - 1] > value;j--) {
+			window[j] = window[j - 1];
+		}
+
+		window[j] = value;
+	}
+	t = window[count / 2];
+
+	if (getDS18B20FilterSlew(index) && filter->time) {
+		// 0.1°/sec is 10 c° per 1000 mls
+		uint32_t period = min((uint32_t) (millis() - filter->time), (uint32_t) MIN_TO_MLS(1));
+		int32_t step = max((int32_t) (getDS18B20FilterSlew(index) * period / 100), (int32_t) 1);
+
+		t = constrain((int32_t) t, filter->output - step, filter->output + step);
+	}
+
+	if (getDS18B20FilterEma(index)) {
+		if (!filter->time) {
+			filter->ema = (int32_t) t * (1 << DS18B20_FILTER_EMA_SHIFT);
+		}
+		else {
+			filter->ema += ((int32_t) t * (1 << DS18B20_FILTER_EMA_SHIFT) - filter->ema) >> getDS18B20FilterEma(index);
+		}
+
+		t = (filter->ema + (1 << (DS18B20_FILTER_EMA_SHIFT - 1))) >> DS18B20_FILTER_EMA_SHIFT;
+	}
+
+	filter->output = t;
+	filter->time = millis();
+
+	return t;
+}
+
+void SensorsManager::resetDS18B20Filter(uint8_t index) {
+	memset(&ds18b20_filter[index], 0, sizeof(ds18b20_filter_t));
+}
+
+uint8_t SensorsManager::checkDS18B20Fault(uint8_t index, int16_t t) {
+	ds18b20_fault_t* fault = &ds18b20_fault[index];
+	uint8_t status = 0;
+
+	if (fault->time) {
+		uint32_t period = millis() - fault->time;
+
+		// c°/min against °/min
+		if (getFaultRate() && period && (uint32_t) abs(t - fault->t) * MIN_TO_MLS(1) / period > (uint32_t) getFaultRate() * 100) {
+			status = DS18B20_STATUS_RATE;
+		}
+
+		fault->same_count = (t == fault->t) ? min(fault->same_count + 1, 255) : 0;
+	}
+
+	// a live sensor always moves by a few lsb
+	if (!status && getFaultStuckCount() && fault->same_count >= getFaultStuckCount()) {
+		status = DS18B20_STATUS_STUCK;
+	}
+
+	// a stuck or jumping member is blamed by its own checks, a plain disagreement can not tell
+	// which one is wrong, both are flagged whatever the order of the readout
+	int8_t pair = getDS18B20Pair(index);
+	if (!status && getFaultPairDelta() && pair >= 0) {
+		sensor_sample_t* sample = getSample(SENSOR_SOURCE_DS18B20 + pair);
+
+		if ((!sample->quality || sample->quality == DS18B20_STATUS_PAIR) && millis() - sample->time < MIN_TO_MLS(DS18B20_FAULT_PAIR_AGE) && abs(t - sample->raw) > getFaultPairDelta() * 100) {
+			status = DS18B20_STATUS_PAIR;
+
+			if (!sample->quality) {
+				sample->quality = DS18B20_STATUS_PAIR;
+				samples_version++;
+			}
+		}
+	}
+
+	// a real step faults once and is accepted on the next sample
+	fault->t = t;
+	fault->time = millis();
+
+	return status;
+}
+
+void SensorsManager::resetDS18B20Schedule() {
+	memset(ds18b20_schedule.read_timer, 0, sizeof(ds18b20_schedule.read_timer));
+	memset(ds18b20_schedule.read_interval, 0, sizeof(ds18b20_schedule.read_interval));
+
+	ds18b20_schedule.armed_mask = 0;
+	ds18b20_schedule.arm_mask = 0;
+}
+
+uint8_t SensorsManager::getReadyResolution(uint32_t convert_time) {
+	for (uint8_t resolution = 12;resolution >= 9;resolution--) {
+		if (convert_time >= (uint32_t) ds18b20_sensor[0].millisToWaitForConversion(resolution)) {
+			return resolution;
+		}
+	}
+
+	return 0;
+}
+
+
+void SensorsManager::startDS18B20AlarmSearch(uint8_t bus) {
+	ds18b20_search_t* search = &ds18b20_alarm_search[bus];
+
+	memset(search->rom, 0, sizeof(DeviceAddress));
+	search->last_discrepancy = 0;
+	search->state = DS18B20_SEARCH_WAIT;
+
+	ds18b20_pipeline[bus].alarm_mask = 0;
+	ds18b20_pipeline[bus].state = DS18B20_STATE_ALARM;
+
+	// nothing to filter, every sensor of the cycle is read
+	if (!(ds18b20_pipeline[bus].cycle_mask & ds18b20_schedule.armed_mask)) {
+		finishDS18B20AlarmSearch(bus, false);
+	}
+}
+
+void SensorsManager::alarmDS18B20(uint8_t bus) {
+	ds18b20_search_t* search = &ds18b20_alarm_search[bus];
+
+	if (search->state == DS18B20_SEARCH_WAIT) {
+		stats.onewire_transactions++;
+
+		if (!oneWire[bus].reset()) {
+			finishDS18B20AlarmSearch(bus, false);
+			return;
+		}
+
+		oneWire[bus].write(DS18B20_ALARM_SEARCH);
+
+		search->bit = 0;
+		search->last_zero = 0;
+		search->state = DS18B20_SEARCH_PASS;
+
+		// the bits follow on the next tick
+		return;
+	}
+
+	for (uint8_t i = 0;i < DS18B20_SEARCH_BITS;i++) {
+		if (!searchDS18B20Bit(bus, true)) {
+			// nobody answers the first bit when no device is in alarm
+			finishDS18B20AlarmSearch(bus, !search->bit && !search->last_discrepancy);
+			return;
+		}
+
+		if (search->bit < 64) {
+			continue;
+		}
+
+		if (OneWire::crc8(search->rom, 7) != search->rom[7]) {
+			finishDS18B20AlarmSearch(bus, false);
+			return;
+		}
+
+		for (uint8_t j = 0;j < getDS18B20Count();j++) {
+			if (getDS18B20Bus(j) == bus && !memcmp(getDS18B20Address(j), search->rom, sizeof(DeviceAddress))) {
+				ds18b20_pipeline[bus].alarm_mask |= (1 << j);
+			}
+		}
+
+		search->last_discrepancy = search->last_zero;
+		search->state = DS18B20_SEARCH_WAIT;
+
+		if (!search->last_discrepancy) {
+			finishDS18B20AlarmSearch(bus, true);
+		}
+
+		return;
+	}
+}
+
+void SensorsManager::finishDS18B20AlarmSearch(uint8_t bus, bool complete_flag) {
+	ds18b20_pipeline_t* pipeline = &ds18b20_pipeline[bus];
+	uint16_t quiet_mask = 0;
+
+	ds18b20_alarm_search[bus].state = DS18B20_SEARCH_IDLE;
+
+	// an interrupted search reads the whole cycle
+	if (complete_flag) {
+		quiet_mask = pipeline->cycle_mask & ds18b20_schedule.armed_mask & ~pipeline->alarm_mask;
+
+		// one quiet sensor per cycle is still read, round-robin
+		for (uint8_t i = 1;i <= getDS18B20Count();i++) {
+			uint8_t index = (pipeline->refresh_index + i) % getDS18B20Count();
+
+			if (quiet_mask & (1 << index)) {
+				quiet_mask &= ~(1 << index);
+				pipeline->refresh_index = index;
+
+				break;
+			}
+		}
+	}
+
+	pipeline->quiet_mask = quiet_mask;
+	pipeline->read_mask |= quiet_mask;
+	pipeline->state = (pipeline->read_mask == (1 << getDS18B20Count()) - 1) ? DS18B20_STATE_PUBLISH : DS18B20_STATE_READ;
+}
+
+void SensorsManager::updateDS18B20Alarm(uint8_t index) {
+	uint16_t mask = 1 << index;
+
+	if (!getAlarmBand() || getDS18B20Status(index)) {
+		ds18b20_schedule.armed_mask &= ~mask;
+		ds18b20_schedule.arm_mask &= ~mask;
+
+		return;
+	}
+
+	// the device compares the integer part of the raw value
+	int16_t t = ds18b20_schedule.t[index] / 100;
+	if (ds18b20_schedule.t[index] < 0 && ds18b20_schedule.t[index] % 100) {
+		t--;
+	}
+
+	int8_t high = constrain(t + getAlarmBand(), DS18B20_ALARM_LOW, DS18B20_ALARM_HIGH);
+	int8_t low = constrain(t - getAlarmBand(), DS18B20_ALARM_LOW, DS18B20_ALARM_HIGH);
+
+	if ((ds18b20_schedule.armed_mask & mask) && ds18b20_schedule.alarm_high[index] == high && ds18b20_schedule.alarm_low[index] == low) {
+		return;
+	}
+
+	ds18b20_schedule.armed_mask &= ~mask;
+	ds18b20_schedule.arm_mask |= mask;
+	ds18b20_schedule.alarm_high[index] = high;
+	ds18b20_schedule.alarm_low[index] = low;
+}
+
+bool SensorsManager::armDS18B20Alarm(uint8_t bus) {
+	ds18b20_transfer_t* transfer = &ds18b20_transfer[bus];
+
+	if (transfer->state == DS18B20_TRANSFER_BUSY) {
+		if (transfer->owner != DS18B20_TRANSFER_ARM) {
+			return false;
+		}
+
+		if (transferDS18B20(bus) == DS18B20_TRANSFER_DONE) {
+			ds18b20_schedule.armed_mask |= (1 << transfer->index);
+		}
+
+		return true;
+	}
+
+	for (uint8_t i = 0;i < getDS18B20Count();i++) {
+		// a pending resolution is written first
+		if (getDS18B20Bus(i) != bus || !(ds18b20_schedule.arm_mask & (1 << i)) || ds18b20_data[i].dirty_flag) {
+			continue;
+		}
+		ds18b20_schedule.arm_mask &= ~(1 << i);
+
+		uint8_t* address = getDS18B20Address(i);
+		if (!*address) {
+			continue;
+		}
+
+		// scratchpad only, the band moves too often for the eeprom
+		uint8_t data[3] = {(uint8_t) ds18b20_schedule.alarm_high[i], (uint8_t) ds18b20_schedule.alarm_low[i], (uint8_t) (((getDS18B20Resolution(i) - 9) << 5) | 0x1F)};
+
+		startDS18B20Transfer(bus, DS18B20_TRANSFER_ARM, i, address, DS18B20_WRITE_SCRATCHPAD, data, (*address != DS18S20MODEL) ? 3 : 2, 0);
+		transferDS18B20(bus);
+
+		return true;
+	}
+
+	return false;
+}
+
+void SensorsManager::rescanDS18B20Bus() {
+	for (uint8_t bus = 0;bus < DS18B20_BUS_COUNT;bus++) {
+		startDS18B20Search(bus);
+	}
+}
+
+void SensorsManager::invalidateDS18B20Bus() {
+	for (uint8_t bus = 0;bus < DS18B20_BUS_COUNT;bus++) {
+		ds18b20_bus[bus].valid_flag = false;
+	}
+}
+
+void SensorsManager::verifyDS18B20Config() {
+	ds18b20_schedule.verify_mask = (1 << getDS18B20Count()) - 1;
+	ds18b20_schedule.config_verify_timer = millis();
+}
+
+void SensorsManager::saveDS18B20Config() {
+	// the automatic resolution is never copied
+	for (uint8_t i = 0;i < getDS18B20Count();i++) {
+		if (!getDS18B20AutoResolutionFlag(i)) {
+			ds18b20_schedule.save_mask |= ds18b20_schedule.unsaved_mask & (1 << i);
+		}
+	}
+}
+
+
+uint8_t SensorsManager::makeDS18B20AddressList(DynamicArray<DeviceAddress>* array, DynamicArray<int16_t>* t_array, DynamicArray<String>* string_array) {
+	if (array == NULL) {
+		return 0;
+	}
+
+	uint8_t sensors_count = getGlobalDS18B20Count();
+	array->clear();
+
+	if (t_array != NULL) {
+		t_array->clear();
+	}
+
+	if (string_array != NULL) {
+		string_array->clear();
+	}
+
+	if (!sensors_count) {
+		return 0;
+	}
+
+	for (uint8_t i = 0;i < sensors_count;i++) {
+		uint8_t* address = getGlobalDS18B20(i)->address;
+		array->add((DeviceAddress*) address);
+
+		if (t_array != NULL) {
+			t_array->add(getGlobalDS18B20(i)->t);
+		}
+
+		if (string_array != NULL) {
+			String string_address;
+
+			DS18B20AddressToString(address, &string_address);
+			string_array->add(String("B") + getGlobalDS18B20(i)->bus + " " + string_address);
+		}
+	}
+
+	return sensors_count;
+}
+
+int8_t SensorsManager::scanDS18B20AddressIndex(DynamicArray<DeviceAddress>* array, uint8_t* address) {
+	if (array == NULL || address == NULL) {
+		return -1;
+	}
+
+	for (uint8_t i = 0; i < array->size();i++) {
+		if (!memcmp((*array)[i], address, 8)) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+void SensorsManager::resetStats() {
+	memset(&stats, 0, sizeof(sensors_stats_t));
+	am2320.resetStats();
+}
+
+
+void SensorsManager::setSystemManager(SystemManager* system) {
+	this->system = system;
+}
+
+void SensorsManager::setReadDataTime(uint8_t time) {
+	read_data_time = constrain(time, 0, 100);
+	resetDS18B20Schedule();
+}
+
+void SensorsManager::setAutoResolutionRatio(uint8_t ratio) {
+	auto_resolution_ratio = constrain(ratio, 1, 100);
+}
+
+void SensorsManager::setCrcPeriod(uint8_t period) {
+	crc_period = constrain(period, 0, 100);
+}
+
+void SensorsManager::setAdaptiveRate(uint8_t rate) {
+	adaptive_rate = constrain(rate, 1, 250);
+}
+
+void SensorsManager::setAlarmBand(uint8_t band) {
+	band = constrain(band, 0, DS18B20_ALARM_BAND_MAX);
+
+	// the bands are programmed again after the next read
+	if (alarm_band != band) {
+		alarm_band = band;
+		ds18b20_schedule.armed_mask = 0;
+	}
+}
+
+void SensorsManager::setFaultStuckCount(uint8_t count) {
+	fault_stuck_count = constrain(count, 0, DS18B20_FAULT_STUCK_MAX);
+}
+
+void SensorsManager::setFaultRate(uint8_t rate) {
+	fault_rate = constrain(rate, 0, DS18B20_FAULT_RATE_MAX);
+}
+
+void SensorsManager::setFaultPairDelta(uint8_t delta) {
+	fault_pair_delta = constrain(delta, 0, DS18B20_FAULT_PAIR_MAX);
+}
+
+void SensorsManager::setDS18B20BusPort(uint8_t bus, uint8_t port) {
+	if (bus >= DS18B20_BUS_COUNT) {
+		return;
+	}
+
+	// esp8266 gpio 0 - 16
+	if (port > 16) {
+		port = DS18B20_BUS_OFF;
+	}
+
+	if (ds18b20_bus[bus].port != port) {
+		ds18b20_bus[bus].port = port;
+		beginDS18B20Bus(bus);
+	}
+}
+
+
+void SensorsManager::setFlowPort(uint8_t port) {
+	if (flow.getPort() == port) {
+		return;
+	}
+
+	flow.setPort(port);
+
+	// a disabled meter leaves the sample table
+	if (flow.getPort() == FLOW_PORT_OFF) {
+		setSample(SENSOR_SOURCE_FLOW, SENSOR_TYPE_NONE, 0, UNSPECIFIED_STATUS);
+		setSample(SENSOR_SOURCE_FLOW_VOLUME, SENSOR_TYPE_NONE, 0, UNSPECIFIED_STATUS);
+	}
+}
+
+void SensorsManager::setFlowPulses(uint16_t pulses) {
+	flow.setPulses(pulses);
+}
+
+void SensorsManager::setAnalogWorkFlag(bool work_flag) {
+	analog.setWorkFlag(work_flag);
+
+	if (!work_flag) {
+		setSample(SENSOR_SOURCE_ANALOG, SENSOR_TYPE_NONE, 0, UNSPECIFIED_STATUS);
+	}
+}
+
+
+void SensorsManager::setDS18B20(uint8_t index, ds18b20_data_t* ds18b20) {
+	setDS18B20Name(index, ds18b20->name);
+	// the bus of a scanned address wins over the edited one
+	setDS18B20Bus(index, ds18b20->bus);
+	setDS18B20Address(index, ds18b20->address);
+	setDS18B20Resolution(index, ds18b20->resolution);
+	setDS18B20AutoResolutionFlag(index, ds18b20->auto_resolution_flag);
+	setDS18B20ReadTime(index, ds18b20->read_time);
+	setDS18B20AdaptiveFlag(index, ds18b20->adaptive_flag);
+	setDS18B20CorrectionCenti(index, ds18b20->correction);
+	setDS18B20FilterMedian(index, ds18b20->filter_median);
+	setDS18B20FilterEma(index, ds18b20->filter_ema);
+	setDS18B20FilterSlew(index, ds18b20->filter_slew);
+	setDS18B20Pair(index, ds18b20->pair);
+}
+
+void SensorsManager::setDS18B20Name(uint8_t index, String name) {
+	if (!isCorrectDS18B20Index(index)) {
+		return;
+	}
+	
+	#ifdef MODULE_MANAGER_BLYNK_SUPPORT
+	system->modifyBlynkLinkElementCode(String("HSdst") + getDS18B20Name(index), String("HSdst") + name);
+	#endif
+
+	name.toCharArray(ds18b20_data[index].name, 3);
+}
+
+void SensorsManager::setDS18B20Address(uint8_t index, uint8_t* address) {
+	if (!isCorrectDS18B20Index(index) || !*address) {
+		return;
+	}
+
+	if (memcmp(ds18b20_data[index].address, address, 8)) {
+		memcpy(ds18b20_data[index].address, address, 8);
+		ds18b20_data[index].dirty_flag = true;
+		ds18b20_schedule.armed_mask &= ~(1 << index);
+		resetDS18B20Filter(index);
+	}
+
+	// a scanned device brings its bus with it
+	int8_t bus = findDS18B20Bus(address);
+	if (bus >= 0) {
+		setDS18B20Bus(index, bus);
+	}
+}
+
+void SensorsManager::setDS18B20Resolution(uint8_t index, uint8_t resolution) {
+	if (!isCorrectDS18B20Index(index)) {
+		return;
+	}
+
+	resolution = constrain(resolution, 9, 12);
+
+	// written to the device by syncDS18B20Config() from tick()
+	if (ds18b20_data[index].resolution != resolution) {
+		ds18b20_data[index].resolution = resolution;
+		ds18b20_data[index].dirty_flag = true;
+	}
+}
+
+void SensorsManager::setDS18B20AutoResolutionFlag(uint8_t index, bool auto_resolution_flag) {
+	if (!isCorrectDS18B20Index(index)) {
+		return;
+	}
+
+	ds18b20_data[index].auto_resolution_flag = auto_resolution_flag;
+}
+
+void SensorsManager::setDS18B20ReadTime(uint8_t index, uint8_t time) {
+	if (!isCorrectDS18B20Index(index)) {
+		return;
+	}
+
+	time = constrain(time, 0, 250);
+
+	if (ds18b20_data[index].read_time != time) {
+		ds18b20_data[index].read_time = time;
+		ds18b20_schedule.read_interval[index] = 0;
+	}
+}
+
+void SensorsManager::setDS18B20AdaptiveFlag(uint8_t index, bool adaptive_flag) {
+	if (!isCorrectDS18B20Index(index)) {
+		return;
+	}
+
+	ds18b20_data[index].adaptive_flag = adaptive_flag;
+	ds18b20_schedule.read_interval[index] = 0;
+}
+
+void SensorsManager::setDS18B20Bus(uint8_t index, uint8_t bus) {
+	if (!isCorrectDS18B20Index(index) || bus >= DS18B20_BUS_COUNT) {
+		return;
+	}
+
+	if (ds18b20_data[index].bus != bus) {
+		// the sensor may be in the middle of a cycle of the old bus
+		ds18b20_pipeline[ds18b20_data[index].bus].state = DS18B20_STATE_IDLE;
+
+		ds18b20_data[index].bus = bus;
+		ds18b20_data[index].dirty_flag = true;
+		ds18b20_schedule.read_timer[index] = 0;
+		ds18b20_schedule.armed_mask &= ~(1 << index);
+	}
+}
+
+void SensorsManager::setDS18B20Correction(uint8_t index, float correction) {
+	if (!isCorrectDS18B20Index(index)) {
+		return;
+	}
+
+	setDS18B20CorrectionCenti(index, (correction < 0) ? correction * 100 - 0.5 : correction * 100 + 0.5);
+}
+
+void SensorsManager::setDS18B20CorrectionCenti(uint8_t index, int16_t correction) {
+	if (!isCorrectDS18B20Index(index)) {
+		return;
+	}
+
+	ds18b20_data[index].correction = constrain(correction, -DS18B20_CORRECTION_MAX, DS18B20_CORRECTION_MAX);
+}
+
+void SensorsManager::setDS18B20FilterMedian(uint8_t index, uint8_t median) {
+	if (!isCorrectDS18B20Index(index)) {
+		return;
+	}
+
+	// odd windows only: 1, 3, 5
+	median = constrain(median | 1, 1, DS18B20_FILTER_MEDIAN_MAX);
+
+	if (ds18b20_data[index].filter_median != median) {
+		ds18b20_data[index].filter_median = median;
+		resetDS18B20Filter(index);
+	}
+}
+
+void SensorsManager::setDS18B20FilterEma(uint8_t index, uint8_t ema) {
+	if (!isCorrectDS18B20Index(index)) {
+		return;
+	}
+
+	ema = constrain(ema, 0, DS18B20_FILTER_EMA_MAX);
+
+	if (ds18b20_data[index].filter_ema != ema) {
+		ds18b20_data[index].filter_ema = ema;
+		resetDS18B20Filter(index);
+	}
+}
+
+void SensorsManager::setDS18B20FilterSlew(uint8_t index, uint8_t slew) {
+	if (!isCorrectDS18B20Index(index)) {
+		return;
+	}
+
+	ds18b20_data[index].filter_slew = constrain(slew, 0, DS18B20_FILTER_SLEW_MAX);
+}
+
+void SensorsManager::setDS18B20Pair(uint8_t index, int8_t pair) {
+	if (!isCorrectDS18B20Index(index)) {
+		return;
+	}
+
+	// a sensor is not paired with itself
+	ds18b20_data[index].pair = (pair == index) ? -1 : constrain(pair, -1, DS_SENSORS_MAX_COUNT - 1);
+}
+
+
+DallasTemperature* SensorsManager::getDallasTemperature(uint8_t bus) {
+	if (bus >= DS18B20_BUS_COUNT) {
+		return NULL;
+	}
+
+	return &ds18b20_sensor[bus];
+}
+
+uint8_t SensorsManager::getReadDataTime() {
+	return read_data_time;
+}
+
+uint8_t SensorsManager::getAutoResolutionRatio() {
+	return auto_resolution_ratio;
+}
+
+uint8_t SensorsManager::getCrcPeriod() {
+	return crc_period;
+}
+
+uint8_t SensorsManager::getAdaptiveRate() {
+	return adaptive_rate;
+}
+
+uint8_t SensorsManager::getAlarmBand() {
+	return alarm_band;
+}
+
+uint8_t SensorsManager::getFaultStuckCount() {
+	return fault_stuck_count;
+}
+
+uint8_t SensorsManager::getFaultRate() {
+	return fault_rate;
+}
+
+uint8_t SensorsManager::getFaultPairDelta() {
+	return fault_pair_delta;
+}
+
+uint8_t SensorsManager::getDS18B20BusCount() {
+	return DS18B20_BUS_COUNT;
+}
+
+uint8_t SensorsManager::getFlowPort() {
+	return flow.getPort();
+}
+
+uint16_t SensorsManager::getFlowPulses() {
+	return flow.getPulses();
+}
+
+uint32_t SensorsManager::getFlowVolume() {
+	return flow.getVolume();
+}
+
+AnalogDriver* SensorsManager::getAnalogDriver() {
+	return &analog;
+}
+
+uint8_t SensorsManager::getDS18B20BusPort(uint8_t bus) {
+	if (bus >= DS18B20_BUS_COUNT) {
+		return DS18B20_BUS_OFF;
+	}
+
+	return ds18b20_bus[bus].port;
+}
+
+
+float SensorsManager::getAM2320T() {
+	return getAM2320TCenti() / 100.0;
+}
+
+float SensorsManager::getAM2320H() {
+	return getAM2320HCenti() / 100.0;
+}
+
+int16_t SensorsManager::getAM2320TCenti() {
+	return getSample(SENSOR_SOURCE_AM2320_T)->value;
+}
+
+int16_t SensorsManager::getAM2320HCenti() {
+	return getSample(SENSOR_SOURCE_AM2320_H)->value;
+}
+
+uint8_t SensorsManager::getAM2320Status() {
+	return getSample(SENSOR_SOURCE_AM2320_T)->quality;
+}
+
+uint16_t SensorsManager::getAM2320CrcErrors() {
+	return am2320.getCrcErrors();
+}
+
+uint16_t SensorsManager::getAM2320Timeouts() {
+	return am2320.getTimeouts();
+}
+
+
+uint32_t SensorsManager::getTickTime() {
+	return stats.tick_time;
+}
+
+uint32_t SensorsManager::getTickTimeAverage() {
+	return stats.tick_time_average;
+}
+
+uint32_t SensorsManager::getTickTimeMax() {
+	return stats.tick_time_max;
+}
+
+uint32_t SensorsManager::getOneWireTransactions() {
+	return stats.onewire_transactions;
+}
+
+uint32_t SensorsManager::getI2cTransactions() {
+	return am2320.getTransactions();
+}
+
+
+uint8_t SensorsManager::getSamplesCount() {
+	return SENSOR_SAMPLES_COUNT;
+}
+
+uint32_t SensorsManager::getSamplesVersion() {
+	return samples_version;
+}
+
+sensor_sample_t* SensorsManager::getSample(uint8_t source) {
+	if (source >= SENSOR_SAMPLES_COUNT) {
+		return NULL;
+	}
+
+	return &samples[source];
+}
+
+
+uint8_t SensorsManager::getGlobalDS18B20Count() {
+	uint8_t count = 0;
+
+	for (uint8_t bus = 0;bus < DS18B20_BUS_COUNT;bus++) {
+		count += ds18b20_bus[bus].devices.size();
+	}
+
+	return count;
+}
+
+ds18b20_bus_device_t* SensorsManager::getGlobalDS18B20(uint8_t index) {
+	// devices of all buses in one list, bus by bus
+	for (uint8_t bus = 0;bus < DS18B20_BUS_COUNT;bus++) {
+		if (index < ds18b20_bus[bus].devices.size()) {
+			return &ds18b20_bus[bus].devices[index];
+		}
+
+		index -= ds18b20_bus[bus].devices.size();
+	}
+
+	return NULL;
+}
+
+uint32_t SensorsManager::getDS18B20BusScanTime(uint8_t bus) {
+	if (bus >= DS18B20_BUS_COUNT) {
+		return 0;
+	}
+
+	return ds18b20_bus[bus].scan_timer;
+}
+
+bool SensorsManager::getDS18B20BusScanFlag() {
+	for (uint8_t bus = 0;bus < DS18B20_BUS_COUNT;bus++) {
+		if (ds18b20_search[bus].state != DS18B20_SEARCH_IDLE) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+uint16_t SensorsManager::getDS18B20BusVersion() {
+	return ds18b20_bus_log.version;
+}
+
+uint8_t SensorsManager::getDS18B20BusEventsCount() {
+	return ds18b20_bus_log.events_count;
+}
+
+ds18b20_bus_event_t* SensorsManager::getDS18B20BusEvent(uint8_t index) {
+	if (index >= ds18b20_bus_log.events_count) {
+		return NULL;
+	}
+
+	// 0 - the newest event
+	return &ds18b20_bus_log.events[(ds18b20_bus_log.events_head + DS18B20_BUS_EVENTS_COUNT - 1 - index) % DS18B20_BUS_EVENTS_COUNT];
+}
+
+// cached values only, the screens call it from the main loop
+int16_t SensorsManager::getDS18B20TByAddress(uint8_t* address) {
+	for (uint8_t i = 0;i < getDS18B20Count();i++) {
+		if (!memcmp(getDS18B20Address(i), address, sizeof(DeviceAddress))) {
+			return getDS18B20Status(i) ? DS18B20_DISCONNECTED_T : getDS18B20TCenti(i);
+		}
+	}
+
+	// a device that is not configured yet keeps the value of the last discovery
+	for (uint8_t bus = 0;bus < DS18B20_BUS_COUNT;bus++) {
+		for (uint8_t i = 0;i < ds18b20_bus[bus].devices.size();i++) {
+			if (!memcmp(ds18b20_bus[bus].devices[i].address, address, sizeof(DeviceAddress))) {
+				return ds18b20_bus[bus].devices[i].t;
+			}
+		}
+	}
+
+	return DS18B20_DISCONNECTED_T;
+}
+
+uint8_t SensorsManager::getDS18B20Count() {
+	return ds18b20_data.size();
+}
+
+ds18b20_data_t* SensorsManager::getDS18B20(uint8_t index) {
+	if (!isCorrectDS18B20Index(index)) {
+		return NULL;
+	}
+
+	return &ds18b20_data[index];
+}
+
+char* SensorsManager::getDS18B20Name(uint8_t index) {
+	if (!isCorrectDS18B20Index(index)) {
+		return NULL;
+	}
+
+	return ds18b20_data[index].name;
+}
+
+uint8_t* SensorsManager::getDS18B20Address(uint8_t index) {
+	if (!isCorrectDS18B20Index(index)) {
+		return NULL;
+	}
+
+	return ds18b20_data[index].address;
+}
+
+uint8_t SensorsManager::getDS18B20Resolution(uint8_t index) {
+	if (!isCorrectDS18B20Index(index)) {
+		return 0;
+	}
+
+	return ds18b20_data[index].resolution;
+}
+
+bool SensorsManager::getDS18B20AutoResolutionFlag(uint8_t index) {
+	if (!isCorrectDS18B20Index(index)) {
+		return false;
+	}
+
+	return ds18b20_data[index].auto_resolution_flag;
+}
+
+uint8_t SensorsManager::getDS18B20AutoResolution(uint8_t index) {
+	SolarSystemManager* solar = system->getSolarSystemManager();
+
+	if (!isCorrectDS18B20Index(index)) {
+		return 0;
+	}
+
+	uint8_t hysteresis = solar->getSensorHysteresis(index);
+
+	// sensors that are not used for control are read with the fastest conversion
+	if (!hysteresis) {
+		return 9;
+	}
+
+	// quantization step of 9 bit is 0.5°, every next bit halves it
+	uint16_t step_limit = (uint16_t) hysteresis * getAutoResolutionRatio() * 10; // m°
+	uint16_t step = 500;
+
+	for (uint8_t resolution = 9;resolution < 12;resolution++) {
+		if (step <= step_limit) {
+			return resolution;
+		}
+
+		step /= 2;
+	}
+
+	return 12;
+}
+
+uint8_t SensorsManager::getDS18B20ReadTime(uint8_t index) {
+	if (!isCorrectDS18B20Index(index)) {
+		return 0;
+	}
+
+	return ds18b20_data[index].read_time;
+}
+
+bool SensorsManager::getDS18B20AdaptiveFlag(uint8_t index) {
+	if (!isCorrectDS18B20Index(index)) {
+		return false;
+	}
+
+	return ds18b20_data[index].adaptive_flag;
+}
+
+uint8_t SensorsManager::getDS18B20Bus(uint8_t index) {
+	if (!isCorrectDS18B20Index(index)) {
+		return 0;
+	}
+
+	return ds18b20_data[index].bus;
+}
+
+uint32_t SensorsManager::getDS18B20ReadInterval(uint8_t index) {
+	if (!isCorrectDS18B20Index(index)) {
+		return 0;
+	}
+
+	if (ds18b20_schedule.read_interval[index]) {
+		return ds18b20_schedule.read_interval[index];
+	}
+
+	return SEC_TO_MLS(getDS18B20ReadTime(index) ? getDS18B20ReadTime(index) : getReadDataTime());
+}
+
+// the longest time between two samples of a sensor, an adaptive one at its widest
+uint32_t SensorsManager::getDS18B20ReadIntervalMax() {
+	uint32_t interval = SEC_TO_MLS(getReadDataTime());
+
+	for (uint8_t i = 0;i < getDS18B20Count();i++) {
+		uint32_t base_interval = SEC_TO_MLS(getDS18B20ReadTime(i) ? getDS18B20ReadTime(i) : getReadDataTime());
+
+		interval = max(interval, getDS18B20AdaptiveFlag(i) ? base_interval * DS18B20_ADAPTIVE_MAX_RATIO : base_interval);
+	}
+
+	return interval;
+}
+
+float SensorsManager::getDS18B20Correction(uint8_t index) {
+	if (!isCorrectDS18B20Index(index)) {
+		return 0;
+	}
+
+	return ds18b20_data[index].correction / 100.0;
+}
+
+uint8_t SensorsManager::getDS18B20FilterMedian(uint8_t index) {
+	if (!isCorrectDS18B20Index(index)) {
+		return 1;
+	}
+
+	return ds18b20_data[index].filter_median;
+}
+
+uint8_t SensorsManager::getDS18B20FilterEma(uint8_t index) {
+	if (!isCorrectDS18B20Index(index)) {
+		return 0;
+	}
+
+	return ds18b20_data[index].filter_ema;
+}
+
+uint8_t SensorsManager::getDS18B20FilterSlew(uint8_t index) {
+	if (!isCorrectDS18B20Index(index)) {
+		return 0;
+	}
+
+	return ds18b20_data[index].filter_slew;
+}
+
+int8_t SensorsManager::getDS18B20Pair(uint8_t index) {
+	if (!isCorrectDS18B20Index(index)) {
+		return -1;
+	}
+
+	return ds18b20_data[index].pair;
+}
+
+float SensorsManager::getDS18B20T(uint8_t index) {
+	return getDS18B20TCenti(index) / 100.0;
+}
+
+int16_t SensorsManager::getDS18B20TCenti(uint8_t index) {
+	if (!isCorrectDS18B20Index(index)) {
+		return 0;
+	}
+
+	return getSample(SENSOR_SOURCE_DS18B20 + index)->value;
+}
+
+int16_t SensorsManager::getDS18B20RawTCenti(uint8_t index) {
+	if (!isCorrectDS18B20Index(index)) {
+		return 0;
+	}
+
+	return getSample(SENSOR_SOURCE_DS18B20 + index)->raw;
+}
+
+uint8_t SensorsManager::getDS18B20Status(uint8_t index) {
+	if (!isCorrectDS18B20Index(index)) {
+		return UNSPECIFIED_STATUS;
+	}
+
+	return getSample(SENSOR_SOURCE_DS18B20 + index)->quality;
+}
+
+String SensorsManager::getDS18B20StatusString(uint8_t index) {
+	switch (getDS18B20Status(index)) {
+	case 0:
+		return String("ok");
+	case DS18B20_STATUS_DISCONNECTED:
+		return String("disconnected");
+	case DS18B20_STATUS_POWER_ON:
+		return String("power on");
+	case DS18B20_STATUS_STUCK:
+		return String("stuck");
+	case DS18B20_STATUS_RATE:
+		return String("rate");
+	case DS18B20_STATUS_PAIR:
+		return String("pair");
+	default:
+		return String("-");
+	}
+}
+
+uint16_t SensorsManager::getDS18B20CrcErrors(uint8_t index) {
+	if (!isCorrectDS18B20Index(index)) {
+		return 0;
+	}
+
+	return ds18b20_data[index].crc_errors;
+}
+
+
+void SensorsManager::startDS18B20Search(uint8_t bus) {
+	if (ds18b20_search[bus].state != DS18B20_SEARCH_IDLE || getDS18B20BusPort(bus) == DS18B20_BUS_OFF) {
+		return;
+	}
+
+	ds18b20_search[bus].devices.clear();
+	memset(ds18b20_search[bus].rom, 0, sizeof(DeviceAddress));
+	ds18b20_search[bus].last_discrepancy = 0;
+	ds18b20_search[bus].state = DS18B20_SEARCH_WAIT;
+}
+
+bool SensorsManager::isDS18B20SearchTick(uint8_t bus) {
+	if (ds18b20_search[bus].state == DS18B20_SEARCH_WAIT) {
+		return ds18b20_pipeline[bus].state == DS18B20_STATE_IDLE && ds18b20_transfer[bus].state != DS18B20_TRANSFER_BUSY;
+	}
+
+	return ds18b20_search[bus].state != DS18B20_SEARCH_IDLE;
+}
+
+void SensorsManager::discoverDS18B20(uint8_t bus) {
+	if (ds18b20_search[bus].state == DS18B20_SEARCH_IDLE) {
+		return;
+	}
+
+	// the power supply of a new device, then its scratchpad
+	if (ds18b20_search[bus].state == DS18B20_SEARCH_POWER) {
+		ds18b20_transfer_t* transfer = &ds18b20_transfer[bus];
+		uint8_t result = transferDS18B20(bus);
+
+		if (result == DS18B20_TRANSFER_BUSY) {
+			return;
+		}
+
+		// a parasite device pulls the read slots low
+		ds18b20_bus_device_t* device = ds18b20_search[bus].devices.get(transfer->index);
+		if (result == DS18B20_TRANSFER_DONE && device != NULL) {
+			device->parasite_flag = !(transfer->data[0] & 0x01);
+		}
+
+		startDS18B20Transfer(bus, DS18B20_TRANSFER_PEEK, transfer->index, ds18b20_search[bus].rom, DS18B20_READ_SCRATCHPAD, NULL, 0, 5);
+		ds18b20_search[bus].state = DS18B20_SEARCH_READ;
+
+		return;
+	}
+
+	// the scratchpad of the found device, then the next pass
+	if (ds18b20_search[bus].state == DS18B20_SEARCH_READ) {
+		ds18b20_transfer_t* transfer = &ds18b20_transfer[bus];
+		uint8_t result = transferDS18B20(bus);
+
+		if (result == DS18B20_TRANSFER_BUSY) {
+			return;
+		}
+
+		ds18b20_bus_device_t* device = ds18b20_search[bus].devices.get(transfer->index);
+		if (result == DS18B20_TRANSFER_DONE && device != NULL && (transfer->data[0] != 0xFF || transfer->data[1] != 0xFF)) {
+			device->t = convertDS18B20Raw(transfer->data, device->family, ((transfer->data[4] >> 5) & 0x03) + 9);
+		}
+
+		endDS18B20SearchPass(bus);
+		return;
+	}
+
+	// a pass owns the bus from the search command to the last rom bit
+	if (ds18b20_search[bus].state == DS18B20_SEARCH_WAIT) {
+
+		stats.onewire_transactions++;
+
+		if (!oneWire[bus].reset()) {
+			finishDS18B20Search(bus, true);
+			return;
+		}
+
+		oneWire[bus].write(DS18B20_SEARCH_ROM);
+
+		ds18b20_search[bus].bit = 0;
+		ds18b20_search[bus].last_zero = 0;
+		ds18b20_search[bus].state = DS18B20_SEARCH_PASS;
+
+		// the bits follow on the next tick
+		return;
+	}
+
+	for (uint8_t i = 0;i < DS18B20_SEARCH_BITS;i++) {
+		if (!searchDS18B20Bit(bus)) {
+			finishDS18B20Search(bus, false);
+			return;
+		}
+
+		if (ds18b20_search[bus].bit < 64) {
+			continue;
+		}
+
+		// a broken rom means a broken path, the result of the round is not reliable
+		if (OneWire::crc8(ds18b20_search[bus].rom, 7) != ds18b20_search[bus].rom[7]) {
+			finishDS18B20Search(bus, false);
+			return;
+		}
+
+		if (ds18b20_search[bus].rom[0] == DS18B20_SEARCH_FAMILY && addDS18B20SearchResult(bus)) {
+			return;
+		}
+
+		endDS18B20SearchPass(bus);
+		return;
+	}
+}
+
+void SensorsManager::endDS18B20SearchPass(uint8_t bus) {
+	ds18b20_search[bus].last_discrepancy = ds18b20_search[bus].last_zero;
+	ds18b20_search[bus].state = DS18B20_SEARCH_WAIT;
+
+	if (!ds18b20_search[bus].last_discrepancy) {
+		finishDS18B20Search(bus, true);
+	}
+}
+
+bool SensorsManager::searchDS18B20Bit(uint8_t bus, bool alarm_flag) {
+	ds18b20_search_t* search = alarm_flag ? &ds18b20_alarm_search[bus] : &ds18b20_search[bus];
+	uint8_t number = search->bit + 1;
+	uint8_t* rom_byte = &search->rom[search->bit / 8];
+	uint8_t mask = 1 << (search->bit % 8);
+	uint8_t id_bit = oneWire[bus].read_bit();
+	uint8_t cmp_id_bit = oneWire[bus].read_bit();
+	bool direction;
+
+	// nobody answered, a device has left the bus during the pass
+	if (id_bit && cmp_id_bit) {
+		return false;
+	}
+
+	if (id_bit != cmp_id_bit) {
+		direction = id_bit;
+	}
+	else {
+		// repeat the previous path before the last discrepancy, take 1 at it and 0 after it
+		if (number < search->last_discrepancy) {
+			direction = *rom_byte & mask;
+		}
+		else {
+			direction = (number == search->last_discrepancy);
+		}
+
+		if (!direction) {
+			search->last_zero = number;
+		}
+	}
+
+	if (direction) {
+		*rom_byte |= mask;
+	}
+	else {
+		*rom_byte &= ~mask;
+	}
+
+	oneWire[bus].write_bit(direction);
+	search->bit++;
+
+	return true;
+}
+
+bool SensorsManager::addDS18B20SearchResult(uint8_t bus) {
+	bool known_flag = false;
+
+	if (!ds18b20_search[bus].devices.add()) {
+		return false;
+	}
+
+	ds18b20_bus_device_t* device = &ds18b20_search[bus].devices[ds18b20_search[bus].devices.size() - 1];
+
+	memcpy(device->address, ds18b20_search[bus].rom, sizeof(DeviceAddress));
+	device->bus = bus;
+	device->family = ds18b20_search[bus].rom[0];
+	device->parasite_flag = false;
+	device->t = DS18B20_DISCONNECTED_T;
+
+	// the power mode of a known device does not change
+	for (uint8_t i = 0;i < ds18b20_bus[bus].devices.size();i++) {
+		if (!memcmp(ds18b20_bus[bus].devices[i].address, device->address, sizeof(DeviceAddress))) {
+			device->parasite_flag = ds18b20_bus[bus].devices[i].parasite_flag;
+			known_flag = true;
+
+			break;
+		}
+	}
+
+	// the exchanges of the found device are read over the next ticks
+	if (!known_flag) {
+		startDS18B20Transfer(bus, DS18B20_TRANSFER_POWER, ds18b20_search[bus].devices.size() - 1, device->address, DS18B20_READ_POWER_SUPPLY, NULL, 0, 1);
+		ds18b20_search[bus].state = DS18B20_SEARCH_POWER;
+
+		return true;
+	}
+
+	// the scratchpad keeps the last broadcast conversion
+	startDS18B20Transfer(bus, DS18B20_TRANSFER_PEEK, ds18b20_search[bus].devices.size() - 1, device->address, DS18B20_READ_SCRATCHPAD, NULL, 0, 5);
+	ds18b20_search[bus].state = DS18B20_SEARCH_READ;
+
+	return true;
+}
+
+void SensorsManager::finishDS18B20Search(uint8_t bus, bool complete_flag) {
+	bool parasite_flag = false;
+	bool changed_flag = false;
+	bool known_flag = ds18b20_bus[bus].valid_flag;
+
+	ds18b20_search[bus].state = DS18B20_SEARCH_IDLE;
+	ds18b20_bus[bus].scan_timer = millis();
+
+	// an interrupted round keeps the previous result, an invalid cache is scanned again
+	if (!complete_flag) {
+		ds18b20_search[bus].devices.clear();
+		return;
+	}
+
+	ds18b20_bus[bus].valid_flag = true;
+
+	if (known_flag) {
+		for (uint8_t i = 0;i < ds18b20_bus[bus].devices.size();i++) {
+			bool found_flag = false;
+
+			for (uint8_t j = 0;j < ds18b20_search[bus].devices.size();j++) {
+				if (!memcmp(ds18b20_bus[bus].devices[i].address, ds18b20_search[bus].devices[j].address, sizeof(DeviceAddress))) {
+					found_flag = true;
+					break;
+				}
+			}
+
+			if (!found_flag) {
+				addDS18B20BusEvent(bus, ds18b20_bus[bus].devices[i].address, DS18B20_BUS_EVENT_MISSING);
+				changed_flag = true;
+			}
+		}
+
+		for (uint8_t i = 0;i < ds18b20_search[bus].devices.size();i++) {
+			bool found_flag = false;
+
+			for (uint8_t j = 0;j < ds18b20_bus[bus].devices.size();j++) {
+				if (!memcmp(ds18b20_search[bus].devices[i].address, ds18b20_bus[bus].devices[j].address, sizeof(DeviceAddress))) {
+					found_flag = true;
+					break;
+				}
+			}
+
+			if (!found_flag) {
+				addDS18B20BusEvent(bus, ds18b20_search[bus].devices[i].address, DS18B20_BUS_EVENT_APPEARED);
+				changed_flag = true;
+			}
+		}
+	}
+	else {
+		changed_flag = true;
+	}
+
+	ds18b20_bus[bus].devices.clear();
+
+	for (uint8_t i = 0;i < ds18b20_search[bus].devices.size();i++) {
+		if (!ds18b20_bus[bus].devices.add()) {
+			break;
+		}
+
+		ds18b20_bus[bus].devices[ds18b20_bus[bus].devices.size() - 1] = ds18b20_search[bus].devices[i];
+		parasite_flag |= ds18b20_search[bus].devices[i].parasite_flag;
+	}
+	ds18b20_search[bus].devices.clear();
+
+	// DallasTemperature keeps its own parasite flag for the strong pullup
+	ds18b20_sensor[bus].setParasitePowerMode(parasite_flag);
+
+	if (changed_flag) {
+		ds18b20_bus_log.version++;
+		verifyDS18B20Config();
+	}
+}
+
+void SensorsManager::addDS18B20BusEvent(uint8_t bus, uint8_t* address, uint8_t type) {
+	ds18b20_bus_event_t* event = &ds18b20_bus_log.events[ds18b20_bus_log.events_head];
+
+	memcpy(event->address, address, sizeof(DeviceAddress));
+	event->bus = bus;
+	event->type = type;
+	event->time = millis();
+
+	ds18b20_bus_log.events_head = (ds18b20_bus_log.events_head + 1) % DS18B20_BUS_EVENTS_COUNT;
+	ds18b20_bus_log.events_count = min(ds18b20_bus_log.events_count + 1, DS18B20_BUS_EVENTS_COUNT);
+
+	// a sensor that comes back may have lost its configuration
+	if (type == DS18B20_BUS_EVENT_APPEARED) {
+		for (uint8_t i = 0;i < getDS18B20Count();i++) {
+			if (!memcmp(getDS18B20Address(i), address, sizeof(DeviceAddress))) {
+				ds18b20_data[i].dirty_flag = true;
+				ds18b20_schedule.armed_mask &= ~(1 << i);
+			}
+		}
+	}
+}
+
+void SensorsManager::checkDS18B20Bus(uint8_t bus) {
+	if (!ds18b20_bus[bus].valid_flag || millis() - ds18b20_bus[bus].scan_timer >= MIN_TO_MLS(DS18B20_SEARCH_TIME)) {
+		startDS18B20Search(bus);
+	}
+}
+
+void SensorsManager::syncDS18B20Config(uint8_t bus) {
+	ds18b20_transfer_t* transfer = &ds18b20_transfer[bus];
+
+	// a started exchange is finished first, an orphaned read is only let to end
+	if (transfer->state == DS18B20_TRANSFER_BUSY) {
+		if (transferDS18B20(bus) == DS18B20_TRANSFER_DONE) {
+			finishDS18B20Config(bus);
+		}
+
+		return;
+	}
+
+	if (millis() - ds18b20_pipeline[bus].config_sync_timer < DS18B20_CONFIG_SYNC_TIME) {
+		return;
+	}
+	ds18b20_pipeline[bus].config_sync_timer = millis();
+
+	if (millis() - ds18b20_schedule.config_verify_timer >= MIN_TO_MLS(DS18B20_CONFIG_VERIFY_TIME)) {
+		verifyDS18B20Config();
+	}
+
+	uint8_t dirty_count = 0;
+	uint8_t addressed_count = 0;
+	uint8_t bus_count = 0;
+	int8_t first_index = -1;
+	int8_t dirty_index = -1;
+	bool same_resolution_flag = true;
+
+	for (uint8_t i = 0;i < getDS18B20Count();i++) {
+		if (getDS18B20Bus(i) != bus) {
+			continue;
+		}
+		bus_count++;
+
+		if (!*getDS18B20Address(i)) {
+			continue;
+		}
+
+		first_index = (first_index < 0) ? i : first_index;
+
+		if (ds18b20_data[i].resolution != ds18b20_data[first_index].resolution) {
+			same_resolution_flag = false;
+		}
+
+		if (ds18b20_data[i].dirty_flag) {
+			dirty_count++;
+			dirty_index = (dirty_index < 0) ? i : dirty_index;
+		}
+
+		addressed_count++;
+	}
+
+	// the writes go to the scratchpad only, the eeprom is written by a user save
+	// one SKIP ROM write configures the whole bus, but would overwrite the alarm bands
+	if (dirty_count > 1 && same_resolution_flag && addressed_count == bus_count && !getAlarmBand()) {
+		uint8_t data[3] = {DS18B20_ALARM_HIGH, (uint8_t) DS18B20_ALARM_LOW, (uint8_t) (((getDS18B20Resolution(first_index) - 9) << 5) | 0x1F)};
+
+		startDS18B20Transfer(bus, DS18B20_TRANSFER_CONFIG, first_index, NULL, DS18B20_WRITE_SCRATCHPAD, data, 3, 0);
+		transferDS18B20(bus);
+
+		return;
+	}
+
+	if (dirty_index >= 0) {
+		uint8_t* address = getDS18B20Address(dirty_index);
+		bool armed_flag = ds18b20_schedule.armed_mask & (1 << dirty_index);
+
+		// a DS18S20 has no configuration register
+		if (*address == DS18S20MODEL) {
+			ds18b20_data[dirty_index].dirty_flag = false;
+			return;
+		}
+
+		// an armed band is kept
+		uint8_t data[3] = {(uint8_t) (armed_flag ? ds18b20_schedule.alarm_high[dirty_index] : DS18B20_ALARM_HIGH),
+			(uint8_t) (armed_flag ? ds18b20_schedule.alarm_low[dirty_index] : DS18B20_ALARM_LOW), (uint8_t) (((getDS18B20Resolution(dirty_index) - 9) << 5) | 0x1F)};
+
+		startDS18B20Transfer(bus, DS18B20_TRANSFER_CONFIG, dirty_index, address, DS18B20_WRITE_SCRATCHPAD, data, 3, 0);
+		transferDS18B20(bus);
+
+		return;
+	}
+
+	// eeprom copies and the background verify, one device per step
+	for (uint8_t i = 0;i < getDS18B20Count();i++) {
+		if (getDS18B20Bus(i) != bus || !(ds18b20_schedule.save_mask & (1 << i))) {
+			continue;
+		}
+		ds18b20_schedule.save_mask &= ~(1 << i);
+
+		if (!*getDS18B20Address(i)) {
+			continue;
+		}
+
+		startDS18B20Transfer(bus, DS18B20_TRANSFER_CONFIG, i, getDS18B20Address(i), DS18B20_COPY_SCRATCHPAD, NULL, 0, 0);
+		transferDS18B20(bus);
+
+		return;
+	}
+
+	for (uint8_t i = 0;i < getDS18B20Count();i++) {
+		if (getDS18B20Bus(i) != bus || !(ds18b20_schedule.verify_mask & (1 << i))) {
+			continue;
+		}
+		ds18b20_schedule.verify_mask &= ~(1 << i);
+
+		// a DS18S20 has no configuration register
+		if (!*getDS18B20Address(i) || *getDS18B20Address(i) == DS18S20MODEL) {
+			continue;
+		}
+
+		startDS18B20Transfer(bus, DS18B20_TRANSFER_VERIFY, i, getDS18B20Address(i), DS18B20_READ_SCRATCHPAD, NULL, 0, 9);
+		transferDS18B20(bus);
+
+		return;
+	}
+}
+
+void SensorsManager::finishDS18B20Config(uint8_t bus) {
+	ds18b20_transfer_t* transfer = &ds18b20_transfer[bus];
+	uint16_t mask = *transfer->address ? (1 << transfer->index) : getDS18B20BusMask(bus);
+
+	if (transfer->owner == DS18B20_TRANSFER_VERIFY) {
+		if (OneWire::crc8(transfer->data, 8) == transfer->data[8] && ((transfer->data[4] >> 5) & 0x03) + 9 != getDS18B20Resolution(transfer->index)) {
+			ds18b20_data[transfer->index].dirty_flag = true;
+		}
+
+		return;
+	}
+
+	if (transfer->owner != DS18B20_TRANSFER_CONFIG) {
+		return;
+	}
+
+	for (uint8_t i = 0;i < getDS18B20Count();i++) {
+		if (!(mask & (1 << i))) {
+			continue;
+		}
+
+		if (transfer->command == DS18B20_COPY_SCRATCHPAD) {
+			ds18b20_schedule.unsaved_mask &= ~(1 << i);
+			continue;
+		}
+
+		// a resolution changed during the write is written again
+		if (((transfer->data[2] >> 5) & 0x03) + 9 != getDS18B20Resolution(i)) {
+			continue;
+		}
+
+		ds18b20_data[i].dirty_flag = false;
+
+		// the automatic resolution follows the control, it never wears the eeprom
+		if (!getDS18B20AutoResolutionFlag(i) && *getDS18B20Address(i) != DS18S20MODEL) {
+			ds18b20_schedule.unsaved_mask |= (1 << i);
+		}
+	}
+}
+
+uint16_t SensorsManager::getDS18B20BusMask(uint8_t bus) {
+	uint16_t mask = 0;
+
+	for (uint8_t i = 0;i < getDS18B20Count();i++) {
+		if (getDS18B20Bus(i) == bus) {
+			mask |= (1 << i);
+		}
+	}
+
+	return mask;
+}
+
+int8_t SensorsManager::findDS18B20Bus(uint8_t* address) {
+	for (uint8_t bus = 0;bus < DS18B20_BUS_COUNT;bus++) {
+		for (uint8_t i = 0;i < ds18b20_bus[bus].devices.size();i++) {
+			if (!memcmp(ds18b20_bus[bus].devices[i].address, address, sizeof(DeviceAddress))) {
+				return bus;
+			}
+		}
+	}
+
+	return -1;
+}
 
 bool SensorsManager::isCorrectDS18B20Index(uint8_t index) {
 	if (index >= getDS18B20Count()) {
@@ -14,77 +14,254 @@ SolarSystemManager::SolarSystemManager() {
 }
 
 void SolarSystemManager::begin() {
-	pinMode(RELE_PORT, OUTPUT);
-	setReleFlag(false);
+	for (uint8_t i = 0;i < SOLAR_CHANNELS_COUNT;i++) {
+		rele[i].begin(system, i ? RELE_PORT_OFF : RELE_PORT, i);
+	}
+
+	energy.begin(system);
 }
 
 
 void SolarSystemManager::tick() {
-	releTick();
+	SensorsManager* sensors = system->getSensorsManager();
+	solar_snapshot_t next;
+	int8_t rule_actions[SOLAR_CHANNELS_COUNT];
 
-	if (!work_flag) {
-		return;
-	}
-	
-	if (getStatus()) {
-		if (getErrorOnFlag()) {
-			setReleFlag(true);
+	// the minimum on and off times expire without a new sample, so do the relay states
+	for (uint8_t i = 0;i < SOLAR_CHANNELS_COUNT;i++) {
+		rele[i].tick();
+
+		if (rele[i].getState() != snapshot.channels[i].rele_flag) {
+			update_flag = true;
 		}
-		
-		return;
 	}
 
-	float delta_now = getBatteryT() - getBoilerT();
+	// and the no flow timeout
+	if (readFlowStatus() != snapshot.flow_status) {
+		update_flag = true;
+	}
 
-	if (delta_now >= delta) {
-		setReleFlag(true);
+	// the inputs change only with a new sample or a setting
+	if (!update_flag && samples_version == sensors->getSamplesVersion()) {
+		return;
 	}
-	else if (delta_now <= delta - 2) {
-		setReleFlag(false);
+
+	samples_version = sensors->getSamplesVersion();
+	update_flag = false;
+	flowTick();
+	buildSnapshot(&next);
+	rulesTick(&next, rule_actions);
+
+	// all channels in one pass over the same samples
+	for (uint8_t i = 0;i < getChannelsCount();i++) {
+		channelTick(i, &next, rule_actions[i]);
 	}
+
+	// consumers never see a half built snapshot
+	next.rele_flag = next.channels[0].rele_flag;
+	next.reason = next.channels[0].reason;
+
+	// a flow meter, when there is one, replaces the nominal pump flow
+	sensor_sample_t* flow_sample = sensors->getSample(SENSOR_SOURCE_FLOW);
+	energy.tick(&next, (flow_sample->type != SENSOR_TYPE_NONE && !flow_sample->quality) ? flow_sample->value : energy.getFlow());
+
+	next.sequence = snapshot.sequence + 1;
+	snapshot = next;
 }
 
 void SolarSystemManager::makeDefault() {
 	system = NULL;
 
 	work_flag = DEFAULT_SOLAR_WORK_FLAG;
-	error_on_flag = DEFAULT_SOLAR_ERROR_ON_FLAG;
-	rele_invert_flag = DEFAULT_SOLAR_RELE_INVERT_FLAG;
-	delta = DEFAULT_SOLAR_DELTA;
-
-	battery_sensor_index = -1;
-	boiler_sensor_index = -1;
+	channels_count = DEFAULT_SOLAR_CHANNELS_COUNT;
 	exit_sensor_index = -1;
 
-	rele_flag = false;
+	for (uint8_t i = 0;i < SOLAR_CHANNELS_COUNT;i++) {
+		channels[i].source = -1;
+		channels[i].sink = -1;
+		channels[i].on_delta = DEFAULT_SOLAR_DELTA;
+		channels[i].off_delta = DEFAULT_SOLAR_DELTA - SOLAR_HYSTERESIS;
+		channels[i].error_policy = DEFAULT_SOLAR_ERROR_ON_FLAG ? SOLAR_ERROR_ON : SOLAR_ERROR_HOLD;
+
+		rele[i].makeDefault();
+	}
+
+	energy.makeDefault();
+
+	for (uint8_t i = 0;i < SOLAR_RULES_COUNT;i++) {
+		rules[i].clear();
+		rules_channel[i] = 0;
+		rules_action[i] = SOLAR_RULE_OFF;
+	}
+
+	flow_timer = 0;
+	flow_lock_timer = 0;
+	flow_lock_flag = false;
+	flow_retry_count = 0;
+	samples_version = 0;
+	update_flag = true;
+
+	memset(&snapshot, 0, sizeof(solar_snapshot_t));
+	snapshot.battery_status = 1;
+	snapshot.boiler_status = 1;
+	snapshot.exit_status = 1;
+	snapshot.status = 1;
 }
 
 void SolarSystemManager::writeSettings(char* buffer) {
 	setParameter(buffer, "SSSs", getWorkFlag());
-	setParameter(buffer, "SSSeo", getErrorOnFlag());
-	setParameter(buffer, "SSSri", getReleInvertFlag());
-	setParameter(buffer, "SSSd", getDelta());
-	setParameter(buffer, "SSSba", getBatterySensor());
-	setParameter(buffer, "SSSbo", getBoilerSensor());
 	setParameter(buffer, "SSSex", getExitSensor());
+	setParameter(buffer, "SSSCc", getChannelsCount());
+
+	setParameter(buffer, "SSSrn", rele[0].getMinOnTime());
+	setParameter(buffer, "SSSrf", rele[0].getMinOffTime());
+	setParameter(buffer, "SSSrr", rele[0].getMaxRate());
+	setParameter(buffer, "SSSro", rele[0].getOverrideTime());
+
+	setParameter(buffer, "SSEw", energy.getWorkFlag());
+	setParameter(buffer, "SSEf", energy.getFlow());
+	setParameter(buffer, "SSEc", energy.getCapacity());
+	setParameter(buffer, "SSEd", energy.getDay());
+	setParameter(buffer, "SSEm", energy.getMonth());
+	setParameter(buffer, "SSEl", energy.getLifetime());
+	setParameter(buffer, "SSEdt", energy.getDate());
+
+	for (uint8_t i = 0;i < getChannelsCount();i++) {
+		setParameter(buffer, String("SSSCs") + i, getChannelSource(i));
+		setParameter(buffer, String("SSSCk") + i, getChannelSink(i));
+		setParameter(buffer, String("SSSCn") + i, getChannelOnDelta(i));
+		setParameter(buffer, String("SSSCf") + i, getChannelOffDelta(i));
+		setParameter(buffer, String("SSSCe") + i, getChannelErrorPolicy(i));
+		setParameter(buffer, String("SSSCp") + i, rele[i].getPort());
+		setParameter(buffer, String("SSSCv") + i, rele[i].getInvertFlag());
+		setParameter(buffer, String("SSSCrc") + i, rele[i].getCycles());
+		setParameter(buffer, String("SSSCrt") + i, rele[i].getOnTime());
+		setParameter(buffer, String("SSSCrl") + i, rele[i].getChangeTime());
+	}
+
+	for (uint8_t i = 0;i < SOLAR_RULES_COUNT;i++) {
+		if (!*rules[i].getText()) {
+			continue;
+		}
+
+		setParameter(buffer, String("SSSRt") + i, rules[i].getText());
+		setParameter(buffer, String("SSSRc") + i, getRuleChannel(i));
+		setParameter(buffer, String("SSSRa") + i, getRuleAction(i));
+	}
 }
 
 void SolarSystemManager::readSettings(char* buffer) {
+	uint8_t channels_count = getChannelsCount();
+	uint16_t rele_min_on_time = rele[0].getMinOnTime();
+	uint16_t rele_min_off_time = rele[0].getMinOffTime();
+	uint8_t rele_max_rate = rele[0].getMaxRate();
+	uint8_t rele_override_time = rele[0].getOverrideTime();
+	bool energy_work_flag = energy.getWorkFlag();
+	uint16_t energy_flow = energy.getFlow();
+	uint16_t energy_capacity = energy.getCapacity();
+	uint32_t energy_day = 0;
+	uint32_t energy_month = 0;
+	uint32_t energy_lifetime = 0;
+	uint32_t energy_date = 0;
+
 	getParameter(buffer, "SSSs", &work_flag);
-	getParameter(buffer, "SSSeo", &error_on_flag);
-	getParameter(buffer, "SSSri", &rele_invert_flag);
-	getParameter(buffer, "SSSd", &delta);
-	getParameter(buffer, "SSSba", &battery_sensor_index);
-	getParameter(buffer, "SSSbo", &boiler_sensor_index);
 	getParameter(buffer, "SSSex", &exit_sensor_index);
+	getParameter(buffer, "SSSCc", &channels_count);
+	getParameter(buffer, "SSSrn", &rele_min_on_time);
+	getParameter(buffer, "SSSrf", &rele_min_off_time);
+	getParameter(buffer, "SSSrr", &rele_max_rate);
+	getParameter(buffer, "SSSro", &rele_override_time);
+	getParameter(buffer, "SSEw", &energy_work_flag);
+	getParameter(buffer, "SSEf", &energy_flow);
+	getParameter(buffer, "SSEc", &energy_capacity);
+	getParameter(buffer, "SSEd", &energy_day);
+	getParameter(buffer, "SSEm", &energy_month);
+	getParameter(buffer, "SSEl", &energy_lifetime);
+	getParameter(buffer, "SSEdt", &energy_date);
 
 	setWorkFlag(work_flag);
-	setErrorOnFlag(error_on_flag);
-	setReleInvertFlag(rele_invert_flag);
-	setDelta(delta);
-	setBatterySensor(battery_sensor_index);
-	setBoilerSensor(boiler_sensor_index);
 	setExitSensor(exit_sensor_index);
+	setChannelsCount(channels_count);
+
+	energy.setWorkFlag(energy_work_flag);
+	energy.setFlow(energy_flow);
+	energy.setCapacity(energy_capacity);
+	energy.loadStats(energy_day, energy_month, energy_lifetime, energy_date);
+
+	for (uint8_t i = 0;i < SOLAR_CHANNELS_COUNT;i++) {
+		int8_t source = getChannelSource(i);
+		int8_t sink = getChannelSink(i);
+		uint8_t on_delta = getChannelOnDelta(i);
+		uint8_t off_delta = getChannelOffDelta(i);
+		uint8_t error_policy = getChannelErrorPolicy(i);
+		uint8_t port = rele[i].getPort();
+		bool invert_flag = rele[i].getInvertFlag();
+		uint32_t cycles = 0;
+		uint32_t on_time = 0;
+		uint32_t change_time = 0;
+
+		// channel 0 kept the single pump keys before the channel table
+		if (!i) {
+			bool error_on_flag;
+			uint8_t delta;
+
+			if (getParameter(buffer, "SSSeo", &error_on_flag)) {
+				error_policy = error_on_flag ? SOLAR_ERROR_ON : SOLAR_ERROR_HOLD;
+			}
+			if (getParameter(buffer, "SSSd", &delta)) {
+				on_delta = delta;
+				off_delta = delta - SOLAR_HYSTERESIS;
+			}
+
+			getParameter(buffer, "SSSri", &invert_flag);
+			getParameter(buffer, "SSSba", &source);
+			getParameter(buffer, "SSSbo", &sink);
+			getParameter(buffer, "SSSrc", &cycles);
+			getParameter(buffer, "SSSrt", &on_time);
+			getParameter(buffer, "SSSrl", &change_time);
+		}
+
+		getParameter(buffer, String("SSSCs") + i, &source);
+		getParameter(buffer, String("SSSCk") + i, &sink);
+		getParameter(buffer, String("SSSCn") + i, &on_delta);
+		getParameter(buffer, String("SSSCf") + i, &off_delta);
+		getParameter(buffer, String("SSSCe") + i, &error_policy);
+		getParameter(buffer, String("SSSCp") + i, &port);
+		getParameter(buffer, String("SSSCv") + i, &invert_flag);
+		getParameter(buffer, String("SSSCrc") + i, &cycles);
+		getParameter(buffer, String("SSSCrt") + i, &on_time);
+		getParameter(buffer, String("SSSCrl") + i, &change_time);
+
+		setChannelSource(i, source);
+		setChannelSink(i, sink);
+		setChannelOnDelta(i, on_delta);
+		setChannelOffDelta(i, off_delta);
+		setChannelErrorPolicy(i, error_policy);
+
+		rele[i].setPort(port);
+		rele[i].setInvertFlag(invert_flag);
+		rele[i].setMinOnTime(rele_min_on_time);
+		rele[i].setMinOffTime(rele_min_off_time);
+		rele[i].setMaxRate(rele_max_rate);
+		rele[i].setOverrideTime(rele_override_time);
+		rele[i].loadStats(cycles, on_time, change_time);
+	}
+
+	for (uint8_t i = 0;i < SOLAR_RULES_COUNT;i++) {
+		char rule_text[RULE_TEXT_SIZE] = "";
+		uint8_t rule_channel = getRuleChannel(i);
+		uint8_t rule_action = getRuleAction(i);
+
+		// the rules are compiled once here, not on every sample
+		if (getParameter(buffer, String("SSSRt") + i, rule_text, RULE_TEXT_SIZE)) {
+			getParameter(buffer, String("SSSRc") + i, &rule_channel);
+			getParameter(buffer, String("SSSRa") + i, &rule_action);
+
+			setRule(i, rule_text);
+			setRuleChannel(i, rule_channel);
+			setRuleAction(i, rule_action);
+		}
+	}
 }
 
 #ifdef SOLAR_SYSTEM_MANAGER_BLYNK_SUPPORT
@@ -95,6 +272,18 @@ void SolarSystemManager::addBlynkElementCodes(DynamicArray<String>* array) {
 
 	array->add(String("SSSs"));
 	array->add(String("HSSpu"));
+	array->add(String("HSEd"));
+	array->add(String("HSEm"));
+	array->add(String("HSEl"));
+
+	for (uint8_t i = 1;i < getChannelsCount();i++) {
+		array->add(String("HSSpu") + i);
+	}
+
+	for (uint8_t i = 0;i < getChannelsCount();i++) {
+		array->add(String("SSSCn") + i);
+		array->add(String("SSSCf") + i);
+	}
 }
 
 bool SolarSystemManager::blynkElementSend(BlynkWifi* Blynk, blynk_link_t* link) {
@@ -112,6 +301,39 @@ bool SolarSystemManager::blynkElementSend(BlynkWifi* Blynk, blynk_link_t* link)
 		return true;
 	}
 
+	// kWh
+	if (!strcmp(link->element_code, "HSEd")) {
+		Blynk->virtualWrite(link->port, energy.getDay() / 1000.0);
+		return true;
+	}
+
+	if (!strcmp(link->element_code, "HSEm")) {
+		Blynk->virtualWrite(link->port, energy.getMonth() / 1000.0);
+		return true;
+	}
+
+	if (!strcmp(link->element_code, "HSEl")) {
+		Blynk->virtualWrite(link->port, energy.getLifetime() / 1000.0);
+		return true;
+	}
+
+	for (uint8_t i = 0;i < getChannelsCount();i++) {
+		if (i && String(link->element_code) == String("HSSpu") + i) {
+			Blynk->virtualWrite(link->port, rele[i].getState());
+			return true;
+		}
+
+		if (String(link->element_code) == String("SSSCn") + i) {
+			Blynk->virtualWrite(link->port, getChannelOnDelta(i));
+			return true;
+		}
+
+		if (String(link->element_code) == String("SSSCf") + i) {
+			Blynk->virtualWrite(link->port, getChannelOffDelta(i));
+			return true;
+		}
+	}
+
 	return false;
 }
 
@@ -126,6 +348,23 @@ bool SolarSystemManager::blynkElementParse(String code, const BlynkParam& param)
 		return true;
 	}
 
+	for (uint8_t i = 0;i < getChannelsCount();i++) {
+		if (i && code == String("HSSpu") + i) {
+			setChannelReleFlag(i, param.asInt());
+			return true;
+		}
+
+		if (code == String("SSSCn") + i) {
+			setChannelOnDelta(i, param.asInt());
+			return true;
+		}
+
+		if (code == String("SSSCf") + i) {
+			setChannelOffDelta(i, param.asInt());
+			return true;
+		}
+	}
+
 	return false;
 }
 #endif
@@ -137,27 +376,135 @@ void SolarSystemManager::setSystemManager(SystemManager* system) {
 
 
 void SolarSystemManager::setReleFlag(bool rele_flag) {
-	this->rele_flag = rele_flag;
-	releTick();
+	setChannelReleFlag(0, rele_flag);
 }
 
 void SolarSystemManager::setWorkFlag(bool work_flag) {
 	this->work_flag = work_flag;
-	tick();
+	update_flag = true;
 }
 
 void SolarSystemManager::setErrorOnFlag(bool error_on_flag) {
-	this->error_on_flag = error_on_flag;
-	tick();
+	setChannelErrorPolicy(0, error_on_flag ? SOLAR_ERROR_ON : SOLAR_ERROR_HOLD);
 }
 
 void SolarSystemManager::setReleInvertFlag(bool rele_invert_flag) {
-	this->rele_invert_flag = rele_invert_flag;
+	rele[0].setInvertFlag(rele_invert_flag);
 }
 
 void SolarSystemManager::setDelta(uint8_t delta) {
-	this->delta = constrain(delta, SOLAR_DELTA_MIN, SOLAR_DELTA_MAX);
-	tick();
+	// the single pump setting keeps the fixed hysteresis
+	setChannelOnDelta(0, delta);
+	setChannelOffDelta(0, getChannelOnDelta(0) - SOLAR_HYSTERESIS);
+}
+
+
+void SolarSystemManager::setChannelsCount(uint8_t count) {
+	channels_count = constrain(count, 1, SOLAR_CHANNELS_COUNT);
+	update_flag = true;
+
+	// a removed channel switches its relay off
+	for (uint8_t i = channels_count;i < SOLAR_CHANNELS_COUNT;i++) {
+		rele[i].release();
+	}
+}
+
+void SolarSystemManager::setChannelSource(uint8_t channel, int8_t ds18b20_index) {
+	SensorsManager* sensors = system->getSensorsManager();
+
+	if (channel >= SOLAR_CHANNELS_COUNT) {
+		return;
+	}
+
+	channels[channel].source = constrain(ds18b20_index, -1, sensors->getDS18B20Count() - 1);
+	update_flag = true;
+}
+
+void SolarSystemManager::setChannelSink(uint8_t channel, int8_t ds18b20_index) {
+	SensorsManager* sensors = system->getSensorsManager();
+
+	if (channel >= SOLAR_CHANNELS_COUNT) {
+		return;
+	}
+
+	channels[channel].sink = constrain(ds18b20_index, -1, sensors->getDS18B20Count() - 1);
+	update_flag = true;
+}
+
+void SolarSystemManager::setChannelOnDelta(uint8_t channel, uint8_t delta) {
+	if (channel >= SOLAR_CHANNELS_COUNT) {
+		return;
+	}
+
+	channels[channel].on_delta = constrain(delta, SOLAR_DELTA_MIN, SOLAR_DELTA_MAX);
+	setChannelOffDelta(channel, getChannelOffDelta(channel));
+}
+
+void SolarSystemManager::setChannelOffDelta(uint8_t channel, uint8_t delta) {
+	if (channel >= SOLAR_CHANNELS_COUNT) {
+		return;
+	}
+
+	// the off delta stays below the on delta
+	channels[channel].off_delta = min(delta, (uint8_t) (getChannelOnDelta(channel) - 1));
+	update_flag = true;
+}
+
+void SolarSystemManager::setChannelErrorPolicy(uint8_t channel, uint8_t policy) {
+	if (channel >= SOLAR_CHANNELS_COUNT) {
+		return;
+	}
+
+	channels[channel].error_policy = (policy > SOLAR_ERROR_OFF) ? SOLAR_ERROR_HOLD : policy;
+	update_flag = true;
+}
+
+void SolarSystemManager::setChannelReleFlag(uint8_t channel, bool rele_flag) {
+	if (channel >= SOLAR_CHANNELS_COUNT) {
+		return;
+	}
+
+	// a manual switch holds against the control for the override time
+	rele[channel].override(rele_flag);
+}
+
+
+void SolarSystemManager::setRule(uint8_t index, const char* text) {
+	if (index >= SOLAR_RULES_COUNT) {
+		return;
+	}
+
+	while (*text == ' ') {
+		text++;
+	}
+
+	// an empty text removes the rule, a wrong one is kept to be fixed
+	if (!*text) {
+		rules[index].clear();
+	}
+	else {
+		rules[index].compile(text);
+	}
+
+	update_flag = true;
+}
+
+void SolarSystemManager::setRuleChannel(uint8_t index, uint8_t channel) {
+	if (index >= SOLAR_RULES_COUNT) {
+		return;
+	}
+
+	rules_channel[index] = min(channel, (uint8_t) (SOLAR_CHANNELS_COUNT - 1));
+	update_flag = true;
+}
+
+void SolarSystemManager::setRuleAction(uint8_t index, uint8_t action) {
+	if (index >= SOLAR_RULES_COUNT) {
+		return;
+	}
+
+	rules_action[index] = (action == SOLAR_RULE_ON) ? SOLAR_RULE_ON : SOLAR_RULE_OFF;
+	update_flag = true;
 }
 
 
@@ -176,24 +523,18 @@ void SolarSystemManager::setSensor(uint8_t solar_sensor, int8_t ds18b20_index) {
 }
 
 void SolarSystemManager::setBatterySensor(int8_t ds18b20_index) {
-	SensorsManager* sensors = system->getSensorsManager();
-
-	battery_sensor_index = constrain(ds18b20_index, -1, sensors->getDS18B20Count() - 1);
-	tick();
+	setChannelSource(0, ds18b20_index);
 }
 
 void SolarSystemManager::setBoilerSensor(int8_t ds18b20_index) {
-	SensorsManager* sensors = system->getSensorsManager();
-
-	boiler_sensor_index = constrain(ds18b20_index, -1, sensors->getDS18B20Count() - 1);
-	tick();
+	setChannelSink(0, ds18b20_index);
 }
 
 void SolarSystemManager::setExitSensor(int8_t ds18b20_index) {
 	SensorsManager* sensors = system->getSensorsManager();
 
 	exit_sensor_index = constrain(ds18b20_index, -1, sensors->getDS18B20Count() - 1);
-	tick();
+	update_flag = true;
 }
 
 
@@ -202,17 +543,43 @@ SystemManager* SolarSystemManager::getSystemManager() {
 }
 
 uint8_t SolarSystemManager::getStatus() {
-	if (!getWorkFlag()) return 1;
-	if (getBatterySensorStatus()) return 2;
-	if (getBoilerSensorStatus()) return 3;
-	if (getExitSensorStatus()) return 4;
+	return snapshot.status;
+}
 
-	return 0;
+const solar_snapshot_t* SolarSystemManager::getSnapshot() {
+	return &snapshot;
+}
+
+String SolarSystemManager::getReasonString(uint8_t channel) {
+	if (channel >= SOLAR_CHANNELS_COUNT) {
+		return String("-");
+	}
+
+	switch (snapshot.channels[channel].reason) {
+	case SOLAR_REASON_OFF:
+		return String("off");
+	case SOLAR_REASON_ERROR:
+		return String("error");
+	case SOLAR_REASON_DELTA_ON:
+		return String("delta on");
+	case SOLAR_REASON_DELTA_OFF:
+		return String("delta off");
+	case SOLAR_REASON_HYSTERESIS:
+		return String("hysteresis");
+	case SOLAR_REASON_MANUAL:
+		return String("manual");
+	case SOLAR_REASON_RULE:
+		return String("rule");
+	case SOLAR_REASON_NO_FLOW:
+		return String("no flow");
+	default:
+		return String("-");
+	}
 }
 
 
 bool SolarSystemManager::getReleFlag() {
-	return rele_flag;
+	return rele[0].getState();
 }
 
 bool SolarSystemManager::getWorkFlag() {
@@ -220,43 +587,116 @@ bool SolarSystemManager::getWorkFlag() {
 }
 
 bool SolarSystemManager::getErrorOnFlag() {
-  	return error_on_flag;
+  	return getChannelErrorPolicy(0) == SOLAR_ERROR_ON;
 }
 
 bool SolarSystemManager::getReleInvertFlag() {
-	return rele_invert_flag;
+	return rele[0].getInvertFlag();
 }
 
 uint8_t SolarSystemManager::getDelta() {
-  	return delta;
+  	return getChannelOnDelta(0);
+}
+
+uint8_t SolarSystemManager::getHysteresis() {
+	return getChannelOnDelta(0) - getChannelOffDelta(0);
 }
 
+ReleDriver* SolarSystemManager::getReleDriver(uint8_t channel) {
+	return &rele[(channel < SOLAR_CHANNELS_COUNT) ? channel : 0];
+}
 
-uint8_t SolarSystemManager::getBatterySensorStatus() {
-	SensorsManager* sensors = system->getSensorsManager();
+EnergyMeter* SolarSystemManager::getEnergyMeter() {
+	return &energy;
+}
 
-	if (getBatterySensor() >= sensors->getDS18B20Count() || getBatterySensor() < 0) return 1;
-	if (sensors->getDS18B20Status(getBatterySensor()) ) return 2;
 
-	return 0;
+uint8_t SolarSystemManager::getChannelsCount() {
+	return channels_count;
 }
 
-uint8_t SolarSystemManager::getBoilerSensorStatus() {
-	SensorsManager* sensors = system->getSensorsManager();
+int8_t SolarSystemManager::getChannelSource(uint8_t channel) {
+	return (channel < SOLAR_CHANNELS_COUNT) ? channels[channel].source : -1;
+}
 
-	if (getBoilerSensor() >= sensors->getDS18B20Count() || getBoilerSensor() < 0) return 1;
-	if (sensors->getDS18B20Status(getBoilerSensor()) ) return 2;
+int8_t SolarSystemManager::getChannelSink(uint8_t channel) {
+	return (channel < SOLAR_CHANNELS_COUNT) ? channels[channel].sink : -1;
+}
 
-	return 0;
+uint8_t SolarSystemManager::getChannelOnDelta(uint8_t channel) {
+	return (channel < SOLAR_CHANNELS_COUNT) ? channels[channel].on_delta : 0;
 }
 
-uint8_t SolarSystemManager::getExitSensorStatus() {
-	SensorsManager* sensors = system->getSensorsManager();
+uint8_t SolarSystemManager::getChannelOffDelta(uint8_t channel) {
+	return (channel < SOLAR_CHANNELS_COUNT) ? channels[channel].off_delta : 0;
+}
 
-	if (getExitSensor() >= sensors->getDS18B20Count() || getExitSensor() < 0) return 1;
-	if (sensors->getDS18B20Status(getExitSensor()) ) return 2;
+uint8_t SolarSystemManager::getChannelErrorPolicy(uint8_t channel) {
+	return (channel < SOLAR_CHANNELS_COUNT) ? channels[channel].error_policy : SOLAR_ERROR_HOLD;
+}
 
-	return 0;
+uint8_t SolarSystemManager::getSensorHysteresis(int8_t ds18b20_index) {
+	uint8_t hysteresis = 0;
+
+	// the finest step among the channels that compare this sensor, 0 - unused
+	for (uint8_t i = 0;i < getChannelsCount();i++) {
+		if (channels[i].source != ds18b20_index && channels[i].sink != ds18b20_index) {
+			continue;
+		}
+
+		uint8_t step = min(channels[i].on_delta, (uint8_t) (channels[i].on_delta - channels[i].off_delta));
+
+		if (!hysteresis || step < hysteresis) {
+			hysteresis = step;
+		}
+	}
+
+	return hysteresis;
+}
+
+
+RuleEngine* SolarSystemManager::getRule(uint8_t index) {
+	return &rules[(index < SOLAR_RULES_COUNT) ? index : 0];
+}
+
+uint8_t SolarSystemManager::getRuleChannel(uint8_t index) {
+	return (index < SOLAR_RULES_COUNT) ? rules_channel[index] : 0;
+}
+
+uint8_t SolarSystemManager::getRuleAction(uint8_t index) {
+	return (index < SOLAR_RULES_COUNT) ? rules_action[index] : SOLAR_RULE_OFF;
+}
+
+String SolarSystemManager::getRuleStatusString(uint8_t index) {
+	RuleEngine* rule = getRule(index);
+
+	if (index >= SOLAR_RULES_COUNT || !*rule->getText()) {
+		return String("-");
+	}
+
+	if (!rule->isCompiled()) {
+		return String("error at ") + rule->getError();
+	}
+
+	// the code size and the last evaluation cost
+	return String(rule->getLength()) + " ops / " + rule->getTime() + " mcs";
+}
+
+
+uint8_t SolarSystemManager::getBatterySensorStatus() {
+	return snapshot.battery_status;
+}
+
+uint8_t SolarSystemManager::getBoilerSensorStatus() {
+	return snapshot.boiler_status;
+}
+
+uint8_t SolarSystemManager::getExitSensorStatus() {
+	return snapshot.exit_status;
+}
+
+uint8_t SolarSystemManager::getFlowStatus() {
+	return snapshot.flow_status;
 }
 
 
@@ -277,11 +717,11 @@ int8_t SolarSystemManager::getSensor(uint8_t index) {
 }
 
 int8_t SolarSystemManager::getBatterySensor() {
-  	return battery_sensor_index;
+  	return getChannelSource(0);
 }
 
 int8_t SolarSystemManager::getBoilerSensor() {
-  	return boiler_sensor_index;
+  	return getChannelSink(0);
 }
 
 int8_t SolarSystemManager::getExitSensor() {
@@ -290,36 +730,192 @@ int8_t SolarSystemManager::getExitSensor() {
 
 
 float SolarSystemManager::getBatteryT() {
+	return getBatteryTCenti() / 100.0;
+}
+
+float SolarSystemManager::getBoilerT() {
+	return getBoilerTCenti() / 100.0;
+}
+
+float SolarSystemManager::getExitT() {
+	return getExitTCenti() / 100.0;
+}
+
+int16_t SolarSystemManager::getBatteryTCenti() {
+	return snapshot.battery_t;
+}
+
+int16_t SolarSystemManager::getBoilerTCenti() {
+	return snapshot.boiler_t;
+}
+
+int16_t SolarSystemManager::getExitTCenti() {
+	return snapshot.exit_t;
+}
+
+
+void SolarSystemManager::flowTick() {
 	SensorsManager* sensors = system->getSensorsManager();
+	bool flow_flag = sensors->getSample(SENSOR_SOURCE_FLOW)->value > 0;
+
+	if (flow_flag) {
+		flow_retry_count = 0;
+	}
 
-	if (getBatterySensorStatus()) {
-		return 0;
+	// the pump may run dry only for a while after it is switched on
+	if (!getReleFlag() || flow_flag) {
+		flow_timer = millis();
 	}
 
-	return sensors->getDS18B20T(getBatterySensor());
+	if (flow_lock_flag && millis() - flow_lock_timer >= getFlowRetryTime()) {
+		flow_lock_flag = false;
+	}
+
+	// a dry run stops the pump until the next retry, every next one waits twice as long
+	if (!flow_lock_flag && readFlowStatus()) {
+		flow_lock_flag = true;
+		flow_lock_timer = millis();
+		flow_retry_count = min(flow_retry_count + 1, 8);
+	}
 }
 
-float SolarSystemManager::getBoilerT() {
-	SensorsManager* sensors = system->getSensorsManager();
+void SolarSystemManager::channelTick(uint8_t channel, solar_snapshot_t* next, int8_t rule_action) {
+	solar_channel_state_t* state = &next->channels[channel];
+	ReleDriver* driver = &rele[channel];
 
-	if (getBoilerSensorStatus()) {
-		return 0;
+	if (!getWorkFlag()) {
+		state->reason = SOLAR_REASON_OFF;
 	}
+	else if (!channel && next->flow_status) {
+		// a dry pump is stopped whatever the error policy, the rules or an override say
+		driver->stop();
+		state->reason = SOLAR_REASON_NO_FLOW;
+	}
+	else if (rule_action >= 0) {
+		driver->request(rule_action == SOLAR_RULE_ON);
+		state->reason = SOLAR_REASON_RULE;
+	}
+	else if (state->status) {
+		switch (getChannelErrorPolicy(channel)) {
+		case SOLAR_ERROR_ON:
+			driver->request(true);
+			break;
+		case SOLAR_ERROR_OFF:
+			driver->request(false);
+			break;
+		}
 
-	return sensors->getDS18B20T(getBoilerSensor());
+		state->reason = SOLAR_REASON_ERROR;
+	}
+	else if (state->delta >= getChannelOnDelta(channel) * 100) {
+		driver->request(true);
+		state->reason = SOLAR_REASON_DELTA_ON;
+	}
+	else if (state->delta <= getChannelOffDelta(channel) * 100) {
+		driver->request(false);
+		state->reason = SOLAR_REASON_DELTA_OFF;
+	}
+	else {
+		state->reason = SOLAR_REASON_HYSTERESIS;
+	}
+
+	if (driver->getOverrideFlag()) {
+		state->reason = SOLAR_REASON_MANUAL;
+	}
+
+	state->rele_flag = driver->getState();
 }
 
-float SolarSystemManager::getExitT() {
-	SensorsManager* sensors = system->getSensorsManager();
+void SolarSystemManager::rulesTick(solar_snapshot_t* next, int8_t* actions) {
+	TimeManager* time = system->getTimeManager();
+	rule_context_t context = {system->getSensorsManager(), next, time->hour(), time->minute(), !time->getStatus()};
+
+	for (uint8_t i = 0;i < SOLAR_CHANNELS_COUNT;i++) {
+		actions[i] = -1;
+	}
+
+	// the first firing rule of a channel wins
+	for (uint8_t i = 0;i < SOLAR_RULES_COUNT;i++) {
+		int32_t result;
+		uint8_t channel = getRuleChannel(i);
+
+		if (channel >= getChannelsCount() || actions[channel] >= 0) {
+			continue;
+		}
+
+		if (rules[i].evaluate(&context, &result) && result) {
+			actions[channel] = getRuleAction(i);
+		}
+	}
+}
+
+void SolarSystemManager::buildSnapshot(solar_snapshot_t* next) {
+	next->battery_status = readSensorStatus(getBatterySensor());
+	next->boiler_status = readSensorStatus(getBoilerSensor());
+	next->exit_status = readSensorStatus(getExitSensor());
+	next->flow_status = readFlowStatus();
+
+	next->battery_t = next->battery_status ? 0 : readSensorTCenti(getBatterySensor());
+	next->boiler_t = next->boiler_status ? 0 : readSensorTCenti(getBoilerSensor());
+	next->exit_t = next->exit_status ? 0 : readSensorTCenti(getExitSensor());
+	next->delta = next->battery_t - next->boiler_t;
+
+	if (!getWorkFlag()) next->status = 1;
+	else if (next->battery_status) next->status = (next->battery_status == 3) ? 5 : 2;
+	else if (next->boiler_status) next->status = (next->boiler_status == 3) ? 6 : 3;
+	else if (next->exit_status) next->status = (next->exit_status == 3) ? 7 : 4;
+	else if (next->flow_status) next->status = 8;
+	else next->status = 0;
+
+	next->channels_count = getChannelsCount();
+
+	for (uint8_t i = 0;i < SOLAR_CHANNELS_COUNT;i++) {
+		solar_channel_state_t* state = &next->channels[i];
+		uint8_t source_status = readSensorStatus(getChannelSource(i));
+		uint8_t sink_status = readSensorStatus(getChannelSink(i));
+
+		state->delta = (source_status || sink_status) ? 0 : readSensorTCenti(getChannelSource(i)) - readSensorTCenti(getChannelSink(i));
+		state->rele_flag = rele[i].getState();
+		state->reason = SOLAR_REASON_OFF;
 
-	if (getExitSensorStatus()) {
-		return 0;
+		if (!getWorkFlag() || i >= getChannelsCount()) state->status = 1;
+		else if (source_status) state->status = (source_status == 3) ? 5 : 2;
+		else if (sink_status) state->status = (sink_status == 3) ? 6 : 3;
+		else state->status = 0;
 	}
 
-	return sensors->getDS18B20T(getExitSensor());
+	// the exit sensor and the flow meter watch the channel 0 pump
+	next->channels[0].status = next->status;
 }
 
+uint8_t SolarSystemManager::readSensorStatus(int8_t ds18b20_index) {
+	SensorsManager* sensors = system->getSensorsManager();
+
+	if (ds18b20_index >= sensors->getDS18B20Count() || ds18b20_index < 0) return 1;
+	if (IS_DS18B20_FAULT(sensors->getSample(SENSOR_SOURCE_DS18B20 + ds18b20_index)->quality)) return 3;
+	if (sensors->getSample(SENSOR_SOURCE_DS18B20 + ds18b20_index)->quality) return 2;
+
+	return 0;
+}
+
+int16_t SolarSystemManager::readSensorTCenti(int8_t ds18b20_index) {
+	SensorsManager* sensors = system->getSensorsManager();
+
+	return sensors->getSample(SENSOR_SOURCE_DS18B20 + ds18b20_index)->value;
+}
+
+uint8_t SolarSystemManager::readFlowStatus() {
+	SensorsManager* sensors = system->getSensorsManager();
+	sensor_sample_t* sample = sensors->getSample(SENSOR_SOURCE_FLOW);
+
+	// without a flow meter there is nothing to check
+	if (sample->type == SENSOR_TYPE_NONE || sample->quality) return 0;
+	if (flow_lock_flag && millis() - flow_lock_timer < getFlowRetryTime()) return 1;
+	if (getReleFlag() && millis() - flow_timer >= SEC_TO_MLS(SOLAR_NO_FLOW_TIME)) return 1;
+
+	return 0;
+}
 
-void SolarSystemManager::releTick() {
-	digitalWrite(RELE_PORT, getReleInvertFlag() ? !getReleFlag() : getReleFlag());
+uint32_t SolarSystemManager::getFlowRetryTime() {
+	return SEC_TO_MLS(min((uint32_t) SOLAR_NO_FLOW_RETRY_TIME << (flow_retry_count ? flow_retry_count - 1 : 0), (uint32_t) SOLAR_NO_FLOW_RETRY_MAX));
 }
\ No newline at end of file
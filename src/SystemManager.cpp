@@ -24,6 +24,7 @@ void SystemManager::begin() {
 	blynk.setSystemManager(this);
 
 	LittleFS.begin();
+	i2c.begin();
 	time.begin();
 	sensors.begin();
 	solar.begin();
@@ -48,6 +49,7 @@ void SystemManager::tick() {
 	// uint32_t tick = millis();
 
   	yield();
+	i2c.tick();
 	// if (enc.isLeft()) {
 	// 	Serial.println(String(millis()) + " left");
 	// }
@@ -248,6 +250,10 @@ BlynkManager* SystemManager::getBlynkManager() {
 	return &blynk;
 }
 
+I2CManager* SystemManager::getI2CManager() {
+	return &i2c;
+}
+
 Encoder* SystemManager::getEncoder() {
 	return &enc;
 }
@@ -265,23 +271,48 @@ void SystemManager::saveSettings(bool ignore_flag) {
 	}
 	Serial.println("save");
 
-	File file = LittleFS.open("/config.nztr", "w");
-	char buffer[SETTINGS_BUFFER_SIZE + 1] = "";
+	// every manager has its worst case reserved, one that writes more is not saved
+	static char buffer[SETTINGS_BUFFER_SIZE + 1];
+	uint16_t length = 0;
+	bool size_flag = true;
 
+	*buffer = 0;
 	setParameter(buffer, "SSb", getBuzzerFlag());
+	size_flag &= checkSettingsSize(buffer, &length, SYSTEM_SETTINGS_SIZE);
 
 	time.writeSettings(buffer);
+	size_flag &= checkSettingsSize(buffer, &length, TIME_SETTINGS_SIZE);
 	sensors.writeSettings(buffer);
+	size_flag &= checkSettingsSize(buffer, &length, SENSORS_SETTINGS_SIZE);
 	solar.writeSettings(buffer);
+	size_flag &= checkSettingsSize(buffer, &length, SOLAR_SETTINGS_SIZE);
 	display.writeSettings(buffer);
+	size_flag &= checkSettingsSize(buffer, &length, DISPLAY_SETTINGS_SIZE);
 	network.writeSettings(buffer);
+	size_flag &= checkSettingsSize(buffer, &length, NETWORK_SETTINGS_SIZE);
 	blynk.writeSettings(buffer);
+	size_flag &= checkSettingsSize(buffer, &length, BLYNK_SETTINGS_SIZE);
 
-	file.write(buffer, strlen(buffer));
+	save_settings_timer = millis();
+
+	// the old file stays, the request is repeated
+	if (!size_flag) {
+		Serial.println("settings overflow");
+		return;
+	}
+
+	File file = LittleFS.open("/config.nztr", "w");
+	file.write(buffer, length);
   	file.close();
 
 	save_settings_request = false;
-	save_settings_timer = millis();
+}
+
+bool SystemManager::checkSettingsSize(char* buffer, uint16_t* length, uint16_t size) {
+	uint16_t previous_length = *length;
+
+	*length = strlen(buffer);
+	return *length - previous_length <= size;
 }
 
 void SystemManager::readSettings() {
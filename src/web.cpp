@@ -17,11 +17,12 @@ void NetworkManager::endBegin() {
 	updateWebBlynkBlock();
 	updateWebSensorsBlock();
 
-	web_update_codes = "HSt,HSh,";
-	web_update_codes += "HSSbat,HSSboi,HSSext,HSSpu,";
+	web_update_codes = "HSt,HSh,HStt,HSow,HSi2c,";
+	web_update_codes += "HSSbat,HSSboi,HSSext,HSSfl,HSSpu,HSSrs,";
 	web_update_codes += "SNm,SNWs,SNAs,SNAp,SBs,SBsdt,SBa,";
-	web_update_codes += "STg,STns,SSrdt,";
-	web_update_codes += "SDar,SDbot,SDf,SSSs,SSSeo,SSSri,SSSd,SSSba,SSSbo,SSSex,SSb";
+	web_update_codes += "STg,STns,SSrdt,SSarr,SScrc,SSadr,SSab,SSfs,SSfr,SSfp,SSflp,SSflk,SSanw,SSant,SSanc,SSanrw,";
+	web_update_codes += "SDar,SDbot,SDf,SSSs,SSSeo,SSSri,SSSd,SSSba,SSSbo,SSSex,SSSrn,SSSrf,SSSrr,SSSro,SSSCc,SSb,";
+	web_update_codes += "HSrc,HSrt,HSrl,HSEp,HSEd,HSEm,HSEl,SSEw,SSEf,SSEc";
 }
 
 
@@ -36,7 +37,60 @@ void NetworkManager::uiBuild() {
 	DisplayManager* display = system->getDisplayManager();
 	NetworkManager* network = system->getNetworkManager();
 	BlynkManager* blynk = system->getBlynkManager();
+	I2CManager* i2c = system->getI2CManager();
+	AnalogDriver* analog = sensors->getAnalogDriver();
+	ReleDriver* rele = solar->getReleDriver();
+	const solar_snapshot_t* snapshot = solar->getSnapshot();
+	EnergyMeter* energy = solar->getEnergyMeter();
 	String update_codes = web_update_codes;
+
+	// the background discovery has changed the bus since the last build
+	if (web_sensors.bus_version != sensors->getDS18B20BusVersion()) {
+		updateWebSensorsBlock();
+	}
+
+	for (uint8_t bus = 0;bus < sensors->getDS18B20BusCount();bus++) {
+		update_codes += "SSDSbp";
+		update_codes += bus;
+		update_codes += ",";
+	}
+
+	for (uint8_t i = 0;i < ANALOG_POINTS_COUNT;i++) {
+		update_codes += "SSanr";
+		update_codes += i;
+		update_codes += ",";
+		update_codes += "SSanv";
+		update_codes += i;
+		update_codes += ",";
+	}
+
+	for (uint8_t i = 0;i < solar->getChannelsCount();i++) {
+		const char* codes[] = {"SSSCs", "SSSCk", "SSSCn", "SSSCf", "SSSCp", "SSSCv", "SSSCe", "HSSCs"};
+
+		for (uint8_t j = 0;j < sizeof(codes) / sizeof(codes[0]);j++) {
+			update_codes += codes[j];
+			update_codes += i;
+			update_codes += ",";
+		}
+	}
+
+	for (uint8_t i = 0;i < SOLAR_RULES_COUNT;i++) {
+		const char* codes[] = {"SSSRt", "SSSRc", "SSSRa", "HSSRs"};
+
+		for (uint8_t j = 0;j < sizeof(codes) / sizeof(codes[0]);j++) {
+			update_codes += codes[j];
+			update_codes += i;
+			update_codes += ",";
+		}
+	}
+
+	for (uint8_t source = SENSOR_SOURCE_DRIVERS;source < sensors->getSamplesCount();source++) {
+		if (sensors->getSample(source)->type != SENSOR_TYPE_NONE) {
+			update_codes += "HSsm";
+			update_codes += source;
+			update_codes += ",";
+		}
+	}
 	
 	for (byte i = 0;i < sensors->getDS18B20Count();i++) {
 		update_codes += "HSdsn";
@@ -55,9 +109,45 @@ void NetworkManager::uiBuild() {
 		update_codes += "SSDSr";
 		update_codes += i;
 		update_codes += ",";
+		update_codes += "SSDSau";
+		update_codes += i;
+		update_codes += ",";
+		update_codes += "SSDSt";
+		update_codes += i;
+		update_codes += ",";
+		update_codes += "SSDSad";
+		update_codes += i;
+		update_codes += ",";
+		update_codes += "SSDSb";
+		update_codes += i;
+		update_codes += ",";
+		update_codes += "SSDSi";
+		update_codes += i;
+		update_codes += ",";
 		update_codes += "SSDSc";
 		update_codes += i;
 		update_codes += ",";
+		update_codes += "SSDSfm";
+		update_codes += i;
+		update_codes += ",";
+		update_codes += "SSDSfe";
+		update_codes += i;
+		update_codes += ",";
+		update_codes += "SSDSfs";
+		update_codes += i;
+		update_codes += ",";
+		update_codes += "SSDSrw";
+		update_codes += i;
+		update_codes += ",";
+		update_codes += "SSDSp";
+		update_codes += i;
+		update_codes += ",";
+	}
+
+	for (uint8_t i = 0;i < i2c->getDevicesCount();i++) {
+		update_codes += "HIi2d";
+		update_codes += i;
+		update_codes += ",";
 	}
 
 	for (uint8_t i = 0;i < blynk->getLinksCount();i++) {
@@ -83,6 +173,54 @@ void NetworkManager::uiBuild() {
 	if (ui.uri("/")) {
 		M_SPOILER("Info", GP_ORANGE,
 			GP.SYSTEM_INFO("1.3.1");
+
+			M_BLOCK(GP_THIN,
+				GP.LABEL("Sensors timing");
+
+				M_BOX(GP_LEFT,
+					GP.LABEL("Tick:");
+					GP.PLAIN(String(sensors->getTickTimeAverage()) + " / " + sensors->getTickTimeMax() + " mcs", "HStt");
+				);
+				M_BOX(GP_LEFT,
+					GP.LABEL("OneWire:");
+					GP.PLAIN(String(sensors->getOneWireTransactions()), "HSow");
+				);
+				M_BOX(GP_LEFT,
+					GP.LABEL("I2C:");
+					GP.PLAIN(String(sensors->getI2cTransactions()), "HSi2c");
+				);
+
+				// transactions / naks / errors / last (max) latency
+				for (uint8_t i = 0;i < i2c->getDevicesCount();i++) {
+					i2c_device_t* device = i2c->getDevice(i);
+
+					M_BOX(GP_LEFT,
+						GP.LABEL(String("0x") + String(device->address, HEX) + ":");
+						GP.PLAIN(String(device->transactions) + " / " + device->naks + " / " + device->errors + " / " + device->latency + " (" + device->latency_max + ") mcs", String("HIi2d") + i);
+					);
+				}
+
+				GP.BUTTON("HSsr", "Reset", "", GP_ORANGE, "45%", false, true);
+			);
+
+			M_BLOCK(GP_THIN,
+				GP.LABEL("Pump rele");
+
+				M_BOX(GP_LEFT,
+					GP.LABEL("Cycles:");
+					GP.PLAIN(String(rele->getCycles()), "HSrc");
+				);
+				M_BOX(GP_LEFT,
+					GP.LABEL("On time:");
+					GP.PLAIN(String(rele->getOnTime() / 3600) + " h " + (rele->getOnTime() / 60 % 60) + " min", "HSrt");
+				);
+				M_BOX(GP_LEFT,
+					GP.LABEL("Last change:");
+					GP.PLAIN(rele->getChangeTime() ? String((time->getUnix() - rele->getChangeTime()) / 60) + " min ago" : String("-"), "HSrl");
+				);
+
+				GP.BUTTON("HSrr", "Reset", "", GP_ORANGE, "45%", false, true);
+			);
 		);
 		
 		M_BLOCK(GP_THIN,
@@ -92,7 +230,7 @@ void NetworkManager::uiBuild() {
 				GP.LABEL("T:");
 
 				if (!sensors->getAM2320Status()) {
-					GP.PLAIN(String(sensors->getAM2320T(), 1) + "°", "HSt");
+					GP.PLAIN(centiToString(sensors->getAM2320TCenti(), 1) + "°", "HSt");
 				}
 				else {
 					GP.PLAIN("err", "HSt");
@@ -102,7 +240,7 @@ void NetworkManager::uiBuild() {
 				GP.LABEL("H:");
 
 				if (!sensors->getAM2320Status()) {
-					GP.PLAIN(String(sensors->getAM2320H(), 1) + "%", "HSh");
+					GP.PLAIN(centiToString(sensors->getAM2320HCenti(), 1) + "%", "HSh");
 				}
 				else {
 					GP.PLAIN("err", "HSh");
@@ -115,10 +253,31 @@ void NetworkManager::uiBuild() {
 					GP.LABEL(":");
 					
 					if (!sensors->getDS18B20Status(i)) {
-						GP.PLAIN(String(sensors->getDS18B20T(i), 1) + "°", String("HSdst") + i);
+						GP.PLAIN(centiToString(sensors->getDS18B20TCenti(i), 1) + "°", String("HSdst") + i);
 					}
 					else {
-						GP.PLAIN("err", String("HSdst") + i);
+						GP.PLAIN(sensors->getDS18B20StatusString(i), String("HSdst") + i);
+					}
+				);
+			}
+
+			// samples of the added drivers
+			for (uint8_t source = SENSOR_SOURCE_DRIVERS;source < sensors->getSamplesCount();source++) {
+				sensor_sample_t* sample = sensors->getSample(source);
+
+				if (sample->type == SENSOR_TYPE_NONE) {
+					continue;
+				}
+
+				M_BOX(GP_LEFT,
+					GP.LABEL(sample->name != NULL ? String(sample->name) : String("S") + source);
+					GP.LABEL(":");
+
+					if (!sample->quality) {
+						GP.PLAIN(centiToString(sample->value, 1) + sensorTypeUnit(sample->type), String("HSsm") + source);
+					}
+					else {
+						GP.PLAIN("err", String("HSsm") + source);
 					}
 				);
 			}
@@ -130,8 +289,8 @@ void NetworkManager::uiBuild() {
 			M_BOX(GP_LEFT,
 				GP.LABEL("Battery:");
 
-				if (!solar->getBatterySensorStatus()) {
-					GP.PLAIN(String(solar->getBatteryT(), 1) + "°", "HSSbat");
+				if (!snapshot->battery_status) {
+					GP.PLAIN(centiToString(snapshot->battery_t, 1) + "°", "HSSbat");
 				}
 				else {
 					GP.PLAIN("err", "HSSbat");
@@ -140,8 +299,8 @@ void NetworkManager::uiBuild() {
 			M_BOX(GP_LEFT,
 				GP.LABEL("Boiler:");
 
-				if (!solar->getBoilerSensorStatus()) {
-					GP.PLAIN(String(solar->getBoilerT(), 1) + "°", "HSSboi");
+				if (!snapshot->boiler_status) {
+					GP.PLAIN(centiToString(snapshot->boiler_t, 1) + "°", "HSSboi");
 				}
 				else {
 					GP.PLAIN("err", "HSSboi");
@@ -150,17 +309,53 @@ void NetworkManager::uiBuild() {
 			M_BOX(GP_LEFT,
 				GP.LABEL("Exit:");
 
-				if (!solar->getExitSensorStatus()) {
-					GP.PLAIN(String(solar->getExitT(), 1) + "°", "HSSext");
+				if (!snapshot->exit_status) {
+					GP.PLAIN(centiToString(snapshot->exit_t, 1) + "°", "HSSext");
 				}
 				else {
 					GP.PLAIN("err", "HSSext");
 				}
 			);
+			if (sensors->getFlowPort() != FLOW_PORT_OFF) {
+				M_BOX(GP_LEFT,
+					GP.LABEL("Flow:");
+					GP.PLAIN(!snapshot->flow_status ? centiToString(sensors->getSample(SENSOR_SOURCE_FLOW)->value, 1) + " l/min" : String("no flow"), "HSSfl");
+				);
+			}
 			M_BOX(GP_LEFT,
 				GP.LABEL("Pump:");
-				GP.SWITCH("HSSpu", solar->getReleFlag());
+				GP.SWITCH("HSSpu", snapshot->rele_flag);
 			);
+			M_BOX(GP_LEFT,
+				GP.LABEL("Control:");
+				GP.PLAIN(solar->getReasonString(), "HSSrs");
+			);
+			if (energy->getWorkFlag()) {
+				M_BOX(GP_LEFT,
+					GP.LABEL("Power:");
+					GP.PLAIN(String(energy->getPower()) + " W", "HSEp");
+				);
+				M_BOX(GP_LEFT,
+					GP.LABEL("Today:");
+					GP.PLAIN(centiToString(energy->getDay() / 10, 2) + " kWh", "HSEd");
+				);
+				M_BOX(GP_LEFT,
+					GP.LABEL("Month:");
+					GP.PLAIN(centiToString(energy->getMonth() / 10, 2) + " kWh", "HSEm");
+				);
+				M_BOX(GP_LEFT,
+					GP.LABEL("Total:");
+					GP.PLAIN(centiToString(energy->getLifetime() / 10, 2) + " kWh", "HSEl");
+				);
+			}
+
+			// channel 0 is the pump above
+			for (uint8_t i = 1;i < snapshot->channels_count;i++) {
+				M_BOX(GP_LEFT,
+					GP.LABEL(String("Channel ") + i + ":");
+					GP.PLAIN(String(snapshot->channels[i].rele_flag ? "on" : "off") + " / " + solar->getReasonString(i), String("HSSCs") + i);
+				);
+			}
 		);
 
 		GP.HR();
@@ -254,11 +449,107 @@ void NetworkManager::uiBuild() {
 				GP.NUMBER("SSrdt", "time", sensors->getReadDataTime(), "25%");
 				GP.PLAIN("sec");
 			);
+			M_BOX(GP_LEFT,
+				GP.LABEL("Auto resolution ratio:");
+				GP.NUMBER("SSarr", "ratio", sensors->getAutoResolutionRatio(), "25%");
+				GP.PLAIN("%");
+			);
+			M_BOX(GP_LEFT,
+				GP.LABEL("Full crc read every:");
+				GP.NUMBER("SScrc", "cycles", sensors->getCrcPeriod(), "25%");
+				GP.PLAIN("cycles");
+			);
+			M_BOX(GP_LEFT,
+				GP.LABEL("Adaptive rate:");
+				GP.NUMBER("SSadr", "rate", sensors->getAdaptiveRate(), "25%");
+				GP.PLAIN("0.1°/min");
+			);
+			M_BOX(GP_LEFT,
+				GP.LABEL("Alarm band:");
+				GP.NUMBER("SSab", "0 - off", sensors->getAlarmBand(), "25%");
+				GP.PLAIN("°");
+			);
+			M_BOX(GP_LEFT,
+				GP.LABEL("Flow port:");
+				GP.NUMBER("SSflp", "255 - off", sensors->getFlowPort(), "25%");
+			);
+			M_BOX(GP_LEFT,
+				GP.LABEL("Flow pulses:");
+				GP.NUMBER("SSflk", "per liter", sensors->getFlowPulses(), "25%");
+				GP.PLAIN("1/l");
+			);
+			M_BOX(GP_LEFT,
+				GP.LABEL("A0:");
+				GP.SWITCH("SSanw", analog->getWorkFlag());
+			);
+			M_BOX(GP_LEFT,
+				GP.LABEL("A0 type:");
+				GP.SELECT("SSant", "pressure,irradiance", (analog->getType() == SENSOR_TYPE_IRRADIANCE) ? 1 : 0);
+			);
+			M_BOX(GP_LEFT,
+				GP.LABEL("A0 points:");
+				GP.NUMBER("SSanc", "2 - linear", analog->getPointsCount(), "25%");
+			);
+
+			for (uint8_t i = 0;i < ANALOG_POINTS_COUNT;i++) {
+				M_BOX(GP_LEFT,
+					GP.LABEL(String("Point ") + i + ":");
+					GP.NUMBER(String("SSanr") + i, "raw", analog->getPointRaw(i), "25%");
+					GP.NUMBER_F(String("SSanv") + i, "value", analog->getPointValue(i) / 100.0, 2, "25%");
+				);
+			}
+
+			M_BOX(GP_LEFT,
+				GP.LABEL("A0 raw:");
+				GP.PLAIN(String(analog->getRaw()) + " / " + centiToString(analog->getValue(), 2) + sensorTypeUnit(analog->getType()), "SSanrw");
+			);
+			M_BOX(GP_LEFT,
+				GP.LABEL("Stuck after:");
+				GP.NUMBER("SSfs", "0 - off", sensors->getFaultStuckCount(), "25%");
+				GP.PLAIN("repeats");
+			);
+			M_BOX(GP_LEFT,
+				GP.LABEL("Rate limit:");
+				GP.NUMBER("SSfr", "0 - off", sensors->getFaultRate(), "25%");
+				GP.PLAIN("°/min");
+			);
+			M_BOX(GP_LEFT,
+				GP.LABEL("Pair delta:");
+				GP.NUMBER("SSfp", "0 - off", sensors->getFaultPairDelta(), "25%");
+				GP.PLAIN("°");
+			);
+
+			for (uint8_t bus = 0;bus < sensors->getDS18B20BusCount();bus++) {
+				M_BOX(GP_LEFT,
+					GP.LABEL(String("Bus ") + bus + " port:");
+					GP.NUMBER(String("SSDSbp") + bus, "255 - off", sensors->getDS18B20BusPort(bus), "25%");
+					GP.PLAIN("gpio");
+				);
+			}
+
+			M_BOX(GP_LEFT,
+				GP.LABEL("AM2320 crc errors:");
+				GP.PLAIN(String(sensors->getAM2320CrcErrors()));
+				GP.LABEL("timeouts:");
+				GP.PLAIN(String(sensors->getAM2320Timeouts()));
+			);
 
 			M_BLOCK(GP_THIN,
 				GP.TITLE("DS18B20");
 				GP.BUTTON("SSDSs", "Scan", "", GP_ORANGE, "45%", false, true);
 
+				for (uint8_t i = 0;i < sensors->getDS18B20BusEventsCount();i++) {
+					ds18b20_bus_event_t* event = sensors->getDS18B20BusEvent(i);
+					String event_address;
+
+					sensors->DS18B20AddressToString(event->address, &event_address);
+
+					M_BOX(GP_LEFT,
+						GP.LABEL((event->type == DS18B20_BUS_EVENT_APPEARED) ? "Appeared:" : "Missing:");
+						GP.PLAIN(String("B") + event->bus + " " + event_address + " " + (millis() - event->time) / MIN_TO_MLS(1) + " min ago");
+					);
+				}
+
 				for (byte i = 0;i < sensors->getDS18B20Count();i++) {
 					M_BLOCK(GP_THIN, 
 						M_BOX(GP_CENTER,
@@ -272,6 +563,11 @@ void NetworkManager::uiBuild() {
 							GP.LABEL("Address:");
 							GP.SELECT(String("SSDSa") + i, web_sensors.ds18b20_addresses_string, index);
 						);
+
+						M_BOX(GP_LEFT,
+							GP.LABEL("Bus:");
+							GP.NUMBER(String("SSDSb") + i, "", sensors->getDS18B20Bus(i), "25%");
+						);
 						
 						M_BOX(GP_LEFT,
 							GP.LABEL("Resolution:");
@@ -279,12 +575,66 @@ void NetworkManager::uiBuild() {
 							GP.PLAIN("bit");
 						);
 
+						M_BOX(GP_LEFT,
+							GP.LABEL("Auto resolution:");
+							GP.SWITCH(String("SSDSau") + i, sensors->getDS18B20AutoResolutionFlag(i));
+						);
+
+						M_BOX(GP_LEFT,
+							GP.LABEL("Read time:");
+							GP.NUMBER(String("SSDSt") + i, "0 - common", sensors->getDS18B20ReadTime(i), "25%");
+							GP.PLAIN("sec");
+						);
+
+						M_BOX(GP_LEFT,
+							GP.LABEL("Adaptive:");
+							GP.SWITCH(String("SSDSad") + i, sensors->getDS18B20AdaptiveFlag(i));
+						);
+
+						M_BOX(GP_LEFT,
+							GP.LABEL("Interval:");
+							GP.PLAIN(centiToString(sensors->getDS18B20ReadInterval(i) / 10, 1) + " sec", String("SSDSi") + i);
+						);
+
 						M_BOX(GP_LEFT,
 							GP.LABEL("Correction:");
 							GP.NUMBER_F(String("SSDSc") + i, "", sensors->getDS18B20Correction(i), 2, "25%");
 							GP.PLAIN("°");
 						);
 
+						M_BOX(GP_LEFT,
+							GP.LABEL("Median:");
+							GP.NUMBER(String("SSDSfm") + i, "1 - off", sensors->getDS18B20FilterMedian(i), "25%");
+							GP.PLAIN("samples");
+						);
+
+						M_BOX(GP_LEFT,
+							GP.LABEL("Ema:");
+							GP.NUMBER(String("SSDSfe") + i, "0 - off", sensors->getDS18B20FilterEma(i), "25%");
+							GP.PLAIN("1/2^n");
+						);
+
+						M_BOX(GP_LEFT,
+							GP.LABEL("Slew:");
+							GP.NUMBER(String("SSDSfs") + i, "0 - off", sensors->getDS18B20FilterSlew(i), "25%");
+							GP.PLAIN("0.1°/sec");
+						);
+
+						M_BOX(GP_LEFT,
+							GP.LABEL("Pair:");
+							GP.NUMBER(String("SSDSp") + i, "-1 - none", sensors->getDS18B20Pair(i), "25%");
+						);
+
+						M_BOX(GP_LEFT,
+							GP.LABEL("Raw / filtered:");
+							GP.PLAIN(centiToString(sensors->getDS18B20RawTCenti(i), 2) + " / " + centiToString(sensors->getDS18B20TCenti(i), 2) + "°", String("SSDSrw") + i);
+						);
+
+						M_BOX(GP_LEFT,
+							GP.LABEL("Crc errors:");
+							GP.PLAIN(String(sensors->getDS18B20CrcErrors(i)));
+						);
+
 						GP.BUTTON(String("SSDSd") + i, "Delete", "", GP_ORANGE, "20%", false, true);
 					);
 				}
@@ -340,6 +690,21 @@ void NetworkManager::uiBuild() {
 				GP.NUMBER("SSSd", "delta", solar->getDelta(), "25%");
 				GP.PLAIN("°");
 			);
+			M_BOX(GP_LEFT,
+				GP.LABEL("Min on / off:");
+				GP.NUMBER("SSSrn", "sec", rele->getMinOnTime(), "20%");
+				GP.NUMBER("SSSrf", "sec", rele->getMinOffTime(), "20%");
+			);
+			M_BOX(GP_LEFT,
+				GP.LABEL("Max starts:");
+				GP.NUMBER("SSSrr", "0 - off", rele->getMaxRate(), "25%");
+				GP.PLAIN("/ h");
+			);
+			M_BOX(GP_LEFT,
+				GP.LABEL("Manual hold:");
+				GP.NUMBER("SSSro", "0 - hold", rele->getOverrideTime(), "25%");
+				GP.PLAIN("min");
+			);
 			M_BOX(GP_LEFT,
 				GP.LABEL("Battery:");
 				GP.SELECT("SSSba", select_array, solar->getBatterySensor() + 1);
@@ -352,6 +717,81 @@ void NetworkManager::uiBuild() {
 				GP.LABEL("Exit:");
 				GP.SELECT("SSSex", select_array, solar->getExitSensor() + 1);
 			);
+			M_BOX(GP_LEFT,
+				GP.LABEL("Channels:");
+				GP.NUMBER("SSSCc", "count", solar->getChannelsCount(), "25%");
+			);
+
+			for (uint8_t i = 0;i < solar->getChannelsCount();i++) {
+				ReleDriver* channel_rele = solar->getReleDriver(i);
+
+				M_BLOCK(GP_THIN,
+					GP.TITLE(String("Channel ") + i);
+
+					M_BOX(GP_LEFT,
+						GP.LABEL("Source:");
+						GP.SELECT(String("SSSCs") + i, select_array, solar->getChannelSource(i) + 1);
+					);
+					M_BOX(GP_LEFT,
+						GP.LABEL("Sink:");
+						GP.SELECT(String("SSSCk") + i, select_array, solar->getChannelSink(i) + 1);
+					);
+					M_BOX(GP_LEFT,
+						GP.LABEL("On / off:");
+						GP.NUMBER(String("SSSCn") + i, "on", solar->getChannelOnDelta(i), "20%");
+						GP.NUMBER(String("SSSCf") + i, "off", solar->getChannelOffDelta(i), "20%");
+						GP.PLAIN("°");
+					);
+					M_BOX(GP_LEFT,
+						GP.LABEL("Port:");
+						GP.NUMBER(String("SSSCp") + i, "255 - off", channel_rele->getPort(), "25%");
+					);
+					M_BOX(GP_LEFT,
+						GP.LABEL("Invert:");
+						GP.SWITCH(String("SSSCv") + i, channel_rele->getInvertFlag());
+					);
+					M_BOX(GP_LEFT,
+						GP.LABEL("On error:");
+						GP.SELECT(String("SSSCe") + i, "hold,on,off", solar->getChannelErrorPolicy(i));
+					);
+				);
+			}
+
+			// ds<n>, sm<n>, rele<n>, hour, minute; + - * / < <= > >= == != && || ! ( )
+			M_BLOCK(GP_THIN,
+				GP.TITLE("Rules");
+
+				for (uint8_t i = 0;i < SOLAR_RULES_COUNT;i++) {
+					M_BOX(GP_LEFT,
+						GP.TEXT(String("SSSRt") + i, "ds1 > 85", solar->getRule(i)->getText(), "100%", RULE_TEXT_SIZE - 1);
+					);
+					M_BOX(GP_LEFT,
+						GP.NUMBER(String("SSSRc") + i, "channel", solar->getRuleChannel(i), "20%");
+						GP.SELECT(String("SSSRa") + i, "off,on", solar->getRuleAction(i));
+						GP.PLAIN(solar->getRuleStatusString(i), String("HSSRs") + i);
+					);
+				}
+			);
+
+			// heat moved by the channel 0 pump, exit - boiler
+			M_BLOCK(GP_THIN,
+				GP.TITLE("Energy");
+
+				M_BOX(GP_LEFT,
+					GP.LABEL("Status:");
+					GP.SWITCH("SSEw", energy->getWorkFlag());
+				);
+				M_BOX(GP_LEFT,
+					GP.LABEL("Nominal flow:");
+					GP.NUMBER_F("SSEf", "l/min", energy->getFlow() / 100.0, 2, "25%");
+				);
+				M_BOX(GP_LEFT,
+					GP.LABEL("Heat capacity:");
+					GP.NUMBER("SSEc", "J/(l·K)", energy->getCapacity(), "25%");
+				);
+
+				GP.BUTTON("HSEr", "Reset", "", GP_ORANGE, "45%", false, true);
+			);
 		);
 		GP.BREAK();
 
@@ -390,17 +830,43 @@ void NetworkManager::uiAction() {
 	DisplayManager* display = system->getDisplayManager();
 	NetworkManager* network = system->getNetworkManager();
 	BlynkManager* blynk = system->getBlynkManager();
+	I2CManager* i2c = system->getI2CManager();
+	AnalogDriver* analog = sensors->getAnalogDriver();
+	ReleDriver* rele = solar->getReleDriver();
+	const solar_snapshot_t* snapshot = solar->getSnapshot();
+	EnergyMeter* energy = solar->getEnergyMeter();
 
 	/* --- Home --- */
 	// update
 	if (ui.update("HSt")) {
-		ui.answer(!sensors->getAM2320Status() ? String(sensors->getAM2320T(), 1) + "°" : String("err"));
+		ui.answer(!sensors->getAM2320Status() ? centiToString(sensors->getAM2320TCenti(), 1) + "°" : String("err"));
 		return;
 	}
 	if (ui.update("HSh")) {
-		ui.answer(!sensors->getAM2320Status() ? String(sensors->getAM2320H(), 1) + "%" : String("err"));
+		ui.answer(!sensors->getAM2320Status() ? centiToString(sensors->getAM2320HCenti(), 1) + "%" : String("err"));
+		return;
+	}
+	if (ui.update("HStt")) {
+		ui.answer(String(sensors->getTickTimeAverage()) + " / " + sensors->getTickTimeMax() + " mcs");
+		return;
+	}
+	if (ui.update("HSow")) {
+		ui.answer(String(sensors->getOneWireTransactions()));
 		return;
 	}
+	if (ui.update("HSi2c")) {
+		ui.answer(String(sensors->getI2cTransactions()));
+		return;
+	}
+
+	for (uint8_t i = 0;i < i2c->getDevicesCount();i++) {
+		if (ui.update(String("HIi2d") + i)) {
+			i2c_device_t* device = i2c->getDevice(i);
+
+			ui.answer(String(device->transactions) + " / " + device->naks + " / " + device->errors + " / " + device->latency + " (" + device->latency_max + ") mcs");
+			return;
+		}
+	}
 	
 	for (byte i = 0;i < sensors->getDS18B20Count();i++) {
 		if (ui.update(String("HSdsn") + i)) {
@@ -409,25 +875,77 @@ void NetworkManager::uiAction() {
 			return;
 		}
 		if (ui.update(String("HSdst") + i)) {
-			ui.answer(!sensors->getDS18B20Status(i) ? String(sensors->getDS18B20T(i), 1) + "°" : String("err"));
+			ui.answer(!sensors->getDS18B20Status(i) ? centiToString(sensors->getDS18B20TCenti(i), 1) + "°" : sensors->getDS18B20StatusString(i));
+			return;
+		}
+	}
+
+	for (uint8_t source = SENSOR_SOURCE_DRIVERS;source < sensors->getSamplesCount();source++) {
+		if (ui.update(String("HSsm") + source)) {
+			sensor_sample_t* sample = sensors->getSample(source);
+
+			ui.answer(!sample->quality ? centiToString(sample->value, 1) + sensorTypeUnit(sample->type) : String("err"));
 			return;
 		}
 	}
 
 	if (ui.update("HSSbat")) {
-		ui.answer(!solar->getBatterySensorStatus() ? String(solar->getBatteryT(), 1) + "°" : String("err"));
+		ui.answer(!snapshot->battery_status ? centiToString(snapshot->battery_t, 1) + "°" : String("err"));
 		return;
 	}
 	if (ui.update("HSSboi")) {
-		ui.answer(!solar->getBoilerSensorStatus() ? String(solar->getBoilerT(), 1) + "°" : String("err"));
+		ui.answer(!snapshot->boiler_status ? centiToString(snapshot->boiler_t, 1) + "°" : String("err"));
 		return;
 	}
 	if (ui.update("HSSext")) {
-		ui.answer(!solar->getExitSensorStatus() ? String(solar->getExitT(), 1) + "°" : String("err"));
+		ui.answer(!snapshot->exit_status ? centiToString(snapshot->exit_t, 1) + "°" : String("err"));
+		return;
+	}
+	if (ui.update("HSSfl")) {
+		ui.answer(!snapshot->flow_status ? centiToString(sensors->getSample(SENSOR_SOURCE_FLOW)->value, 1) + " l/min" : String("no flow"));
 		return;
 	}
 	if (ui.update("HSSpu")) {
-		ui.answer(solar->getReleFlag());
+		ui.answer(snapshot->rele_flag);
+		return;
+	}
+	if (ui.update("HSSrs")) {
+		ui.answer(solar->getReasonString());
+		return;
+	}
+
+	for (uint8_t i = 1;i < snapshot->channels_count;i++) {
+		if (ui.update(String("HSSCs") + i)) {
+			ui.answer(String(snapshot->channels[i].rele_flag ? "on" : "off") + " / " + solar->getReasonString(i));
+			return;
+		}
+	}
+	if (ui.update("HSrc")) {
+		ui.answer(String(rele->getCycles()));
+		return;
+	}
+	if (ui.update("HSrt")) {
+		ui.answer(String(rele->getOnTime() / 3600) + " h " + (rele->getOnTime() / 60 % 60) + " min");
+		return;
+	}
+	if (ui.update("HSEp")) {
+		ui.answer(String(energy->getPower()) + " W");
+		return;
+	}
+	if (ui.update("HSEd")) {
+		ui.answer(centiToString(energy->getDay() / 10, 2) + " kWh");
+		return;
+	}
+	if (ui.update("HSEm")) {
+		ui.answer(centiToString(energy->getMonth() / 10, 2) + " kWh");
+		return;
+	}
+	if (ui.update("HSEl")) {
+		ui.answer(centiToString(energy->getLifetime() / 10, 2) + " kWh");
+		return;
+	}
+	if (ui.update("HSrl")) {
+		ui.answer(rele->getChangeTime() ? String((time->getUnix() - rele->getChangeTime()) / 60) + " min ago" : String("-"));
 		return;
 	}
 
@@ -438,10 +956,24 @@ void NetworkManager::uiAction() {
 		
 		return;
 	}
+	if (ui.click("HSsr")) {
+		sensors->resetStats();
+		i2c->resetStats();
+		return;
+	}
+	if (ui.click("HSrr")) {
+		rele->resetStats();
+		return;
+	}
+	if (ui.click("HSEr")) {
+		energy->resetStats();
+		return;
+	}
 	/* --- Home --- */
 
 	if (ui.clickSub("S") || ui.formSub("/S")) {
 		system->saveSettingsRequest();
+		sensors->saveDS18B20Config();
 	}
 
 	/* --- NetworkManager --- */
@@ -612,6 +1144,65 @@ void NetworkManager::uiAction() {
 		ui.answer(sensors->getReadDataTime());
 		return;
 	}
+	if (ui.update("SSarr")) {
+		ui.answer(sensors->getAutoResolutionRatio());
+		return;
+	}
+	if (ui.update("SScrc")) {
+		ui.answer(sensors->getCrcPeriod());
+		return;
+	}
+	if (ui.update("SSadr")) {
+		ui.answer(sensors->getAdaptiveRate());
+		return;
+	}
+	if (ui.update("SSab")) {
+		ui.answer(sensors->getAlarmBand());
+		return;
+	}
+	if (ui.update("SSflp")) {
+		ui.answer(sensors->getFlowPort());
+		return;
+	}
+	if (ui.update("SSflk")) {
+		ui.answer(sensors->getFlowPulses());
+		return;
+	}
+	if (ui.update("SSanw")) {
+		ui.answer(analog->getWorkFlag());
+		return;
+	}
+	if (ui.update("SSant")) {
+		ui.answer((analog->getType() == SENSOR_TYPE_IRRADIANCE) ? 1 : 0);
+		return;
+	}
+	if (ui.update("SSanc")) {
+		ui.answer(analog->getPointsCount());
+		return;
+	}
+	if (ui.update("SSanrw")) {
+		ui.answer(String(analog->getRaw()) + " / " + centiToString(analog->getValue(), 2) + sensorTypeUnit(analog->getType()));
+		return;
+	}
+	if (ui.update("SSfs")) {
+		ui.answer(sensors->getFaultStuckCount());
+		return;
+	}
+	if (ui.update("SSfr")) {
+		ui.answer(sensors->getFaultRate());
+		return;
+	}
+	if (ui.update("SSfp")) {
+		ui.answer(sensors->getFaultPairDelta());
+		return;
+	}
+
+	for (uint8_t bus = 0;bus < sensors->getDS18B20BusCount();bus++) {
+		if (ui.update(String("SSDSbp") + bus)) {
+			ui.answer(sensors->getDS18B20BusPort(bus));
+			return;
+		}
+	}
 
 	for (byte i = 0;i < sensors->getDS18B20Count();i++) {
 		if (ui.update(String("SSDSn") + i)) {
@@ -633,11 +1224,61 @@ void NetworkManager::uiAction() {
 			return;
 		}
 
+		if (ui.update(String("SSDSau") + i)) {
+			ui.answer(sensors->getDS18B20AutoResolutionFlag(i));
+			return;
+		}
+
+		if (ui.update(String("SSDSt") + i)) {
+			ui.answer(sensors->getDS18B20ReadTime(i));
+			return;
+		}
+
+		if (ui.update(String("SSDSad") + i)) {
+			ui.answer(sensors->getDS18B20AdaptiveFlag(i));
+			return;
+		}
+
+		if (ui.update(String("SSDSb") + i)) {
+			ui.answer(sensors->getDS18B20Bus(i));
+			return;
+		}
+
+		if (ui.update(String("SSDSi") + i)) {
+			ui.answer(centiToString(sensors->getDS18B20ReadInterval(i) / 10, 1) + " sec");
+			return;
+		}
+
 		if (ui.update(String("SSDSc") + i)) {
 			ui.answer(sensors->getDS18B20Correction(i), 1);
 			return;
 		}
 
+		if (ui.update(String("SSDSfm") + i)) {
+			ui.answer(sensors->getDS18B20FilterMedian(i));
+			return;
+		}
+
+		if (ui.update(String("SSDSfe") + i)) {
+			ui.answer(sensors->getDS18B20FilterEma(i));
+			return;
+		}
+
+		if (ui.update(String("SSDSfs") + i)) {
+			ui.answer(sensors->getDS18B20FilterSlew(i));
+			return;
+		}
+
+		if (ui.update(String("SSDSp") + i)) {
+			ui.answer(sensors->getDS18B20Pair(i));
+			return;
+		}
+
+		if (ui.update(String("SSDSrw") + i)) {
+			ui.answer(centiToString(sensors->getDS18B20RawTCenti(i), 2) + " / " + centiToString(sensors->getDS18B20TCenti(i), 2) + "°");
+			return;
+		}
+
 	}
 
 	// parse
@@ -645,7 +1286,78 @@ void NetworkManager::uiAction() {
 		sensors->setReadDataTime(ui.getInt());
 		return;
 	}
+	if (ui.click("SSarr")) {
+		sensors->setAutoResolutionRatio(ui.getInt());
+		return;
+	}
+	if (ui.click("SScrc")) {
+		sensors->setCrcPeriod(ui.getInt());
+		return;
+	}
+	if (ui.click("SSadr")) {
+		sensors->setAdaptiveRate(ui.getInt());
+		return;
+	}
+	if (ui.click("SSab")) {
+		sensors->setAlarmBand(ui.getInt());
+		return;
+	}
+	if (ui.click("SSflp")) {
+		sensors->setFlowPort(ui.getInt());
+		return;
+	}
+	if (ui.click("SSflk")) {
+		sensors->setFlowPulses(ui.getInt());
+		return;
+	}
+	if (ui.click("SSanw")) {
+		sensors->setAnalogWorkFlag(ui.getBool());
+		return;
+	}
+	if (ui.click("SSant")) {
+		analog->setType(ui.getInt() ? SENSOR_TYPE_IRRADIANCE : SENSOR_TYPE_PRESSURE);
+		return;
+	}
+	if (ui.click("SSanc")) {
+		analog->setPointsCount(ui.getInt());
+		return;
+	}
+
+	for (uint8_t i = 0;i < ANALOG_POINTS_COUNT;i++) {
+		if (ui.click(String("SSanr") + i)) {
+			analog->setPoint(i, ui.getInt(), analog->getPointValue(i));
+			return;
+		}
+		if (ui.click(String("SSanv") + i)) {
+			float value = ui.getFloat();
+
+			analog->setPoint(i, analog->getPointRaw(i), (value < 0) ? value * 100 - 0.5 : value * 100 + 0.5);
+			return;
+		}
+	}
+
+	if (ui.click("SSfs")) {
+		sensors->setFaultStuckCount(ui.getInt());
+		return;
+	}
+	if (ui.click("SSfr")) {
+		sensors->setFaultRate(ui.getInt());
+		return;
+	}
+	if (ui.click("SSfp")) {
+		sensors->setFaultPairDelta(ui.getInt());
+		return;
+	}
+
+	for (uint8_t bus = 0;bus < sensors->getDS18B20BusCount();bus++) {
+		if (ui.click(String("SSDSbp") + bus)) {
+			sensors->setDS18B20BusPort(bus, ui.getInt());
+			updateWebSensorsBlock();
+			return;
+		}
+	}
 	if (ui.click("SSDSs")) {
+		sensors->rescanDS18B20Bus();
 		updateWebSensorsBlock();
 		return;
 	}
@@ -676,11 +1388,51 @@ void NetworkManager::uiAction() {
 			return;
 		}
 
+		if (ui.click(String("SSDSau") + i)) {
+			sensors->setDS18B20AutoResolutionFlag(i, ui.getBool());
+			return;
+		}
+
+		if (ui.click(String("SSDSt") + i)) {
+			sensors->setDS18B20ReadTime(i, ui.getInt());
+			return;
+		}
+
+		if (ui.click(String("SSDSad") + i)) {
+			sensors->setDS18B20AdaptiveFlag(i, ui.getBool());
+			return;
+		}
+
+		if (ui.click(String("SSDSb") + i)) {
+			sensors->setDS18B20Bus(i, ui.getInt());
+			return;
+		}
+
 		if (ui.click(String("SSDSc") + i)) {
 			sensors->setDS18B20Correction(i, ui.getFloat());
 			return;
 		}
 
+		if (ui.click(String("SSDSfm") + i)) {
+			sensors->setDS18B20FilterMedian(i, ui.getInt());
+			return;
+		}
+
+		if (ui.click(String("SSDSfe") + i)) {
+			sensors->setDS18B20FilterEma(i, ui.getInt());
+			return;
+		}
+
+		if (ui.click(String("SSDSfs") + i)) {
+			sensors->setDS18B20FilterSlew(i, ui.getInt());
+			return;
+		}
+
+		if (ui.click(String("SSDSp") + i)) {
+			sensors->setDS18B20Pair(i, ui.getInt());
+			return;
+		}
+
 		if (ui.click(String("SSDSd") + i)) {
 			sensors->deleteDS18B20(i);
 			return;
@@ -737,6 +1489,88 @@ void NetworkManager::uiAction() {
 		ui.answer(solar->getDelta());
 		return;
 	}
+	if (ui.update("SSSrn")) {
+		ui.answer(rele->getMinOnTime());
+		return;
+	}
+	if (ui.update("SSSrf")) {
+		ui.answer(rele->getMinOffTime());
+		return;
+	}
+	if (ui.update("SSSrr")) {
+		ui.answer(rele->getMaxRate());
+		return;
+	}
+	if (ui.update("SSSro")) {
+		ui.answer(rele->getOverrideTime());
+		return;
+	}
+	if (ui.update("SSSCc")) {
+		ui.answer(solar->getChannelsCount());
+		return;
+	}
+	if (ui.update("SSEw")) {
+		ui.answer(energy->getWorkFlag());
+		return;
+	}
+	if (ui.update("SSEf")) {
+		ui.answer(energy->getFlow() / 100.0, 2);
+		return;
+	}
+	if (ui.update("SSEc")) {
+		ui.answer(energy->getCapacity());
+		return;
+	}
+
+	for (uint8_t i = 0;i < SOLAR_RULES_COUNT;i++) {
+		if (ui.update(String("SSSRt") + i)) {
+			ui.answer(solar->getRule(i)->getText());
+			return;
+		}
+		if (ui.update(String("SSSRc") + i)) {
+			ui.answer(solar->getRuleChannel(i));
+			return;
+		}
+		if (ui.update(String("SSSRa") + i)) {
+			ui.answer(solar->getRuleAction(i));
+			return;
+		}
+		if (ui.update(String("HSSRs") + i)) {
+			ui.answer(solar->getRuleStatusString(i));
+			return;
+		}
+	}
+
+	for (uint8_t i = 0;i < solar->getChannelsCount();i++) {
+		if (ui.update(String("SSSCs") + i)) {
+			ui.answer(solar->getChannelSource(i) + 1);
+			return;
+		}
+		if (ui.update(String("SSSCk") + i)) {
+			ui.answer(solar->getChannelSink(i) + 1);
+			return;
+		}
+		if (ui.update(String("SSSCn") + i)) {
+			ui.answer(solar->getChannelOnDelta(i));
+			return;
+		}
+		if (ui.update(String("SSSCf") + i)) {
+			ui.answer(solar->getChannelOffDelta(i));
+			return;
+		}
+		if (ui.update(String("SSSCp") + i)) {
+			ui.answer(solar->getReleDriver(i)->getPort());
+			return;
+		}
+		if (ui.update(String("SSSCv") + i)) {
+			ui.answer(solar->getReleDriver(i)->getInvertFlag());
+			return;
+		}
+		if (ui.update(String("SSSCe") + i)) {
+			ui.answer(solar->getChannelErrorPolicy(i));
+			return;
+		}
+	}
 
 	if (ui.update("SSSba")) {
 		ui.answer(solar->getBatterySensor() + 1);
@@ -769,6 +1603,100 @@ void NetworkManager::uiAction() {
 		solar->setDelta(ui.getInt());
 		return;
 	}
+	if (ui.click("SSSrn")) {
+		// the limits are shared by all channel relays
+		for (uint8_t i = 0;i < SOLAR_CHANNELS_COUNT;i++) {
+			solar->getReleDriver(i)->setMinOnTime(ui.getInt());
+		}
+
+		return;
+	}
+	if (ui.click("SSSrf")) {
+		// the limits are shared by all channel relays
+		for (uint8_t i = 0;i < SOLAR_CHANNELS_COUNT;i++) {
+			solar->getReleDriver(i)->setMinOffTime(ui.getInt());
+		}
+
+		return;
+	}
+	if (ui.click("SSSrr")) {
+		// the limits are shared by all channel relays
+		for (uint8_t i = 0;i < SOLAR_CHANNELS_COUNT;i++) {
+			solar->getReleDriver(i)->setMaxRate(ui.getInt());
+		}
+
+		return;
+	}
+	if (ui.click("SSSro")) {
+		// the limits are shared by all channel relays
+		for (uint8_t i = 0;i < SOLAR_CHANNELS_COUNT;i++) {
+			solar->getReleDriver(i)->setOverrideTime(ui.getInt());
+		}
+
+		return;
+	}
+	if (ui.click("SSSCc")) {
+		solar->setChannelsCount(ui.getInt());
+		return;
+	}
+	if (ui.click("SSEw")) {
+		energy->setWorkFlag(ui.getBool());
+		return;
+	}
+	if (ui.click("SSEf")) {
+		energy->setFlow(max(ui.getFloat(), (float) 0) * 100 + 0.5);
+		return;
+	}
+	if (ui.click("SSEc")) {
+		energy->setCapacity(ui.getInt());
+		return;
+	}
+
+	for (uint8_t i = 0;i < SOLAR_RULES_COUNT;i++) {
+		if (ui.click(String("SSSRt") + i)) {
+			solar->setRule(i, ui.getString().c_str());
+			return;
+		}
+		if (ui.click(String("SSSRc") + i)) {
+			solar->setRuleChannel(i, ui.getInt());
+			return;
+		}
+		if (ui.click(String("SSSRa") + i)) {
+			solar->setRuleAction(i, ui.getInt());
+			return;
+		}
+	}
+
+	for (uint8_t i = 0;i < solar->getChannelsCount();i++) {
+		if (ui.click(String("SSSCs") + i)) {
+			solar->setChannelSource(i, ui.getInt() - 1);
+			return;
+		}
+		if (ui.click(String("SSSCk") + i)) {
+			solar->setChannelSink(i, ui.getInt() - 1);
+			return;
+		}
+		if (ui.click(String("SSSCn") + i)) {
+			solar->setChannelOnDelta(i, ui.getInt());
+			return;
+		}
+		if (ui.click(String("SSSCf") + i)) {
+			solar->setChannelOffDelta(i, ui.getInt());
+			return;
+		}
+		if (ui.click(String("SSSCp") + i)) {
+			solar->getReleDriver(i)->setPort(ui.getInt());
+			return;
+		}
+		if (ui.click(String("SSSCv") + i)) {
+			solar->getReleDriver(i)->setInvertFlag(ui.getBool());
+			return;
+		}
+		if (ui.click(String("SSSCe") + i)) {
+			solar->setChannelErrorPolicy(i, ui.getInt());
+			return;
+		}
+	}
 	
 	if (ui.click("SSSba")) {
 		solar->setBatterySensor(ui.getInt() - 1);
@@ -825,6 +1753,7 @@ void NetworkManager::updateWebSensorsBlock() {
 	DynamicArray<String> addresses;
 
 	web_sensors.ds18b20_addresses_string.clear();
+	web_sensors.bus_version = sensors->getDS18B20BusVersion();
 	sensors->makeDS18B20AddressList(&web_sensors.ds18b20_addresses, NULL, &addresses);
 
 	for (uint8_t i = 0;i < addresses.size();i++) {
@@ -0,0 +1,286 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * Host stand-in for the ESP8266 Arduino core, used by the native test env.
+ * Time is simulated: it moves only when a test, a delay or a fake device advances it.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+
+typedef bool boolean;
+typedef uint8_t byte;
+typedef uint16_t word;
+
+inline uint16_t makeWord(uint8_t high, uint8_t low) { return (high << 8) | low; }
+#define word(...) makeWord(__VA_ARGS__)
+
+#define ARDUINO 10819
+#undef unix // predefined by the host compiler, the sources use it as a name
+#define ICACHE_RAM_ATTR
+#define IRAM_ATTR
+#define PROGMEM
+#define F(x) x
+
+#define PI 3.1415926535897932384626433832795
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define RISING 1
+#define FALLING 2
+#define CHANGE 3
+#define DEC 10
+#define HEX 16
+
+#define A0 17
+#define D0 16
+#define D1 5
+#define D2 4
+#define D3 0
+#define D4 2
+#define D5 14
+#define D6 12
+#define D7 13
+#define D8 15
+
+#define B00000001 1
+#define B00000010 2
+#define B00000100 4
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+using std::min;
+using std::max;
+
+namespace mock {
+	#define MOCK_PINS_COUNT 18
+	#define MOCK_RTC_MEMORY_SIZE 512 // bytes of the rtc user memory
+
+	inline uint64_t clock = 0; // mcs since the start
+	inline uint8_t pins_mode[MOCK_PINS_COUNT];
+	inline uint8_t pins_level[MOCK_PINS_COUNT];
+	inline void (*pins_interrupt[MOCK_PINS_COUNT])(void);
+	inline uint16_t analog_value = 0;
+	inline uint8_t rtc_memory[MOCK_RTC_MEMORY_SIZE];
+	inline uint32_t resets = 0;
+
+	inline void advance(uint64_t time) {
+		clock += time;
+	}
+
+	// fires the isr attached to the pin, like an edge would
+	inline bool interrupt(uint8_t pin) {
+		if (pin >= MOCK_PINS_COUNT || pins_interrupt[pin] == NULL) {
+			return false;
+		}
+
+		pins_interrupt[pin]();
+		return true;
+	}
+
+	inline void reset() {
+		clock = 0;
+		analog_value = 0;
+		resets = 0;
+
+		memset(pins_mode, 0, sizeof(pins_mode));
+		memset(pins_level, 0, sizeof(pins_level));
+		memset(pins_interrupt, 0, sizeof(pins_interrupt));
+		memset(rtc_memory, 0, sizeof(rtc_memory));
+	}
+}
+
+inline unsigned long millis() { return (uint32_t) (mock::clock / 1000); }
+inline unsigned long micros() { return (uint32_t) mock::clock; }
+inline void delay(unsigned long time) { mock::advance((uint64_t) time * 1000); }
+inline void delayMicroseconds(unsigned int time) { mock::advance(time); }
+inline void yield() {}
+
+inline void pinMode(uint8_t pin, uint8_t mode) { if (pin < MOCK_PINS_COUNT) mock::pins_mode[pin] = mode; }
+inline void digitalWrite(uint8_t pin, uint8_t level) { if (pin < MOCK_PINS_COUNT) mock::pins_level[pin] = level; }
+inline int digitalRead(uint8_t pin) { return (pin < MOCK_PINS_COUNT) ? mock::pins_level[pin] : LOW; }
+inline int analogRead(uint8_t pin) { return mock::analog_value; }
+inline uint8_t digitalPinToInterrupt(uint8_t pin) { return pin; }
+inline void attachInterrupt(uint8_t pin, void (*isr)(void), int mode) { if (pin < MOCK_PINS_COUNT) mock::pins_interrupt[pin] = isr; }
+inline void detachInterrupt(uint8_t pin) { if (pin < MOCK_PINS_COUNT) mock::pins_interrupt[pin] = NULL; }
+inline void noInterrupts() {}
+inline void interrupts() {}
+inline void tone(uint8_t pin, unsigned int freq, unsigned long duration = 0) {}
+inline void noTone(uint8_t pin) {}
+inline long random(long max) { return max > 0 ? rand() % max : 0; }
+inline long random(long min, long max) { return max > min ? min + rand() % (max - min) : min; }
+
+
+class String {
+public:
+	String() {}
+	String(const char* text) : s(text ? text : "") {}
+	String(const std::string& text) : s(text) {}
+	String(char c) : s(1, c) {}
+	String(int value, unsigned char base = DEC) : s(number(value, base)) {}
+	String(unsigned int value, unsigned char base = DEC) : s(number(value, base)) {}
+	String(long value, unsigned char base = DEC) : s(number(value, base)) {}
+	String(unsigned long value, unsigned char base = DEC) : s(number(value, base)) {}
+	String(unsigned char value, unsigned char base = DEC) : s(number(value, base)) {}
+	String(float value, unsigned char decimals = 2) : s(fixed(value, decimals)) {}
+	String(double value, unsigned char decimals = 2) : s(fixed(value, decimals)) {}
+
+	const char* c_str() const { return s.c_str(); }
+	unsigned int length() const { return s.size(); }
+	long toInt() const { return atol(s.c_str()); }
+	float toFloat() const { return atof(s.c_str()); }
+	void toCharArray(char* buffer, unsigned int size) const { if (size) { strncpy(buffer, s.c_str(), size - 1); buffer[size - 1] = 0; } }
+	bool reserve(unsigned int size) { s.reserve(size); return true; }
+	String substring(unsigned int from) const { return from < s.size() ? String(s.substr(from)) : String(); }
+	String substring(unsigned int from, unsigned int to) const { return from < s.size() && to > from ? String(s.substr(from, to - from)) : String(); }
+	int indexOf(char c) const { size_t i = s.find(c); return i == std::string::npos ? -1 : (int) i; }
+	int indexOf(const String& text) const { size_t i = s.find(text.s); return i == std::string::npos ? -1 : (int) i; }
+	bool startsWith(const String& text) const { return !s.compare(0, text.s.size(), text.s); }
+	bool endsWith(const String& text) const { return s.size() >= text.s.size() && !s.compare(s.size() - text.s.size(), text.s.size(), text.s); }
+	char charAt(unsigned int i) const { return i < s.size() ? s[i] : 0; }
+	char operator[](unsigned int i) const { return i < s.size() ? s[i] : 0; }
+	char& operator[](unsigned int i) { return s[i]; }
+	bool equals(const String& text) const { return s == text.s; }
+	bool operator==(const String& text) const { return s == text.s; }
+	bool operator==(const char* text) const { return s == (text ? text : ""); }
+	bool operator!=(const String& text) const { return s != text.s; }
+	bool operator!=(const char* text) const { return s != (text ? text : ""); }
+	bool operator<(const String& text) const { return s < text.s; }
+	String& operator+=(const String& text) { s += text.s; return *this; }
+	String& operator+=(const char* text) { s += text ? text : ""; return *this; }
+	String& operator+=(char c) { s += c; return *this; }
+	template <class T> String& operator+=(T value) { s += String(value).s; return *this; }
+	template <class T> bool concat(T value) { *this += value; return true; }
+	void trim() { s.erase(0, s.find_first_not_of(" \t\r\n")); s.erase(s.find_last_not_of(" \t\r\n") + 1); }
+	void toUpperCase() { for (char& c : s) c = toupper(c); }
+	void toLowerCase() { for (char& c : s) c = tolower(c); }
+	void clear() { s.clear(); }
+
+	std::string s;
+
+private:
+	template <class T> static std::string number(T value, unsigned char base) {
+		char buffer[24];
+
+		if (base == HEX) snprintf(buffer, sizeof(buffer), "%llx", (unsigned long long) value);
+		else snprintf(buffer, sizeof(buffer), "%lld", (long long) value);
+
+		return buffer;
+	}
+
+	static std::string fixed(double value, unsigned char decimals) {
+		char buffer[48];
+
+		snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+		return buffer;
+	}
+};
+
+inline String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+inline String operator+(const String& a, const char* b) { return String(a.s + (b ? b : "")); }
+inline String operator+(const char* a, const String& b) { return String((a ? a : "") + b.s); }
+template <class T> String operator+(const String& a, T b) { return String(a.s + String(b).s); }
+
+
+class Print;
+
+class Printable {
+public:
+	virtual ~Printable() {}
+	virtual size_t printTo(Print& p) const = 0;
+};
+
+class Print {
+public:
+	virtual ~Print() {}
+	virtual size_t write(uint8_t value) = 0;
+	virtual size_t write(const uint8_t* buffer, size_t size) { size_t n = 0; while (size--) n += write(*buffer++); return n; }
+	size_t write(const char* text) { return text ? write((const uint8_t*) text, strlen(text)) : 0; }
+	// write(0) is an integer, like in the core
+	size_t write(int value) { return write((uint8_t) value); }
+	size_t write(unsigned int value) { return write((uint8_t) value); }
+	size_t write(long value) { return write((uint8_t) value); }
+	size_t write(char value) { return write((uint8_t) value); }
+
+	size_t print(const String& text) { return write(text.c_str()); }
+	size_t print(const char* text) { return write(text); }
+	size_t print(char c) { return write((uint8_t) c); }
+	size_t print(int value, int base = DEC) { return print(String(value, base)); }
+	size_t print(unsigned int value, int base = DEC) { return print(String(value, base)); }
+	size_t print(long value, int base = DEC) { return print(String(value, base)); }
+	size_t print(unsigned long value, int base = DEC) { return print(String(value, base)); }
+	size_t print(unsigned char value, int base = DEC) { return print(String(value, base)); }
+	size_t print(double value, int decimals = 2) { return print(String(value, decimals)); }
+	size_t print(const Printable& value) { return value.printTo(*this); }
+	template <class T> size_t println(T value) { return print(value) + println(); }
+	template <class T> size_t println(T value, int format) { return print(value, format) + println(); }
+	size_t println() { return write("\r\n"); }
+	size_t printf(const char* format, ...) {
+		char buffer[256];
+		va_list args;
+
+		va_start(args, format);
+		vsnprintf(buffer, sizeof(buffer), format, args);
+		va_end(args);
+
+		return write(buffer);
+	}
+};
+
+class Stream : public Print {
+public:
+	virtual int available() { return 0; }
+	virtual int read() { return -1; }
+	size_t write(uint8_t value) { return 1; }
+	using Print::write;
+};
+
+class HardwareSerial : public Stream {
+public:
+	void begin(unsigned long baud) {}
+};
+
+inline HardwareSerial Serial;
+
+
+class EspClass {
+public:
+	uint32_t getFreeHeap() { return 40000; }
+	uint32_t getMaxFreeBlockSize() { return 30000; }
+	uint8_t getHeapFragmentation() { return 10; }
+	uint32_t getChipId() { return 0x00C0FFEE; }
+	uint32_t getCycleCount() { return (uint32_t) (mock::clock * 160); }
+	void restart() { mock::resets++; }
+	void reset() { mock::resets++; }
+	void wdtFeed() {}
+
+	// offset in 4 byte blocks, like the sdk
+	bool rtcUserMemoryRead(uint32_t offset, uint32_t* data, size_t size) {
+		if (offset * 4 + size > MOCK_RTC_MEMORY_SIZE) {
+			return false;
+		}
+
+		memcpy(data, mock::rtc_memory + offset * 4, size);
+		return true;
+	}
+
+	bool rtcUserMemoryWrite(uint32_t offset, uint32_t* data, size_t size) {
+		if (offset * 4 + size > MOCK_RTC_MEMORY_SIZE) {
+			return false;
+		}
+
+		memcpy(mock::rtc_memory + offset * 4, data, size);
+		return true;
+	}
+};
+
+inline EspClass ESP;
@@ -0,0 +1,44 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * Host stand-in for the Blynk library, used by the native test env.
+ * The server is never reached.
+ */
+
+#pragma once
+#include <ESP8266WiFi.h>
+
+class BlynkParam {
+public:
+	int asInt() const { return 0; }
+	long asLong() const { return 0; }
+	float asFloat() const { return 0; }
+	double asDouble() const { return 0; }
+	const char* asStr() const { return ""; }
+	String asString() const { return String(); }
+};
+
+class BlynkArduinoClient {
+public:
+	BlynkArduinoClient() {}
+	BlynkArduinoClient(WiFiClient& client) {}
+};
+
+class BlynkWifi {
+public:
+	BlynkWifi(BlynkArduinoClient& transport) {}
+
+	template <class... A> void config(A... args) {}
+	template <class... A> void virtualWrite(A... args) {}
+	template <class... A> void syncVirtual(A... args) {}
+	bool connect(uint32_t timeout = 0) { return false; }
+	void disconnect() {}
+	bool connected() { return false; }
+	void run() {}
+};
+
+struct BlynkReq {
+	uint8_t pin;
+};
+
+#define BLYNK_WRITE_DEFAULT() void BlynkWidgetWriteDefault(BlynkReq& request, const BlynkParam& param)
@@ -0,0 +1,85 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * Host stand-in for the Clock library, used by the native test env.
+ * It counts on the simulated millis() and is valid once a time has been set.
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <time.h>
+
+#define MOCK_CLOCK_VALID_UNIX 946684800 // 01.01.2000
+
+struct TimeT {
+	uint8_t hour;
+	uint8_t minute;
+	uint8_t second;
+	uint8_t weekday;
+	uint8_t day;
+	uint8_t month;
+	uint16_t year;
+};
+
+class Clock {
+public:
+	Clock() : unix_time(0), timer(0) {}
+	void tick() {}
+
+	// 0 - the time is valid
+	uint8_t status() { return getUnix() < MOCK_CLOCK_VALID_UNIX; }
+
+	uint8_t hour(int8_t gmt = 0) { return getTime(gmt).hour; }
+	uint8_t minute(int8_t gmt = 0) { return getTime(gmt).minute; }
+	uint8_t second(int8_t gmt = 0) { return getTime(gmt).second; }
+	uint8_t weekday(int8_t gmt = 0) { return getTime(gmt).weekday; }
+	uint8_t day(int8_t gmt = 0) { return getTime(gmt).day; }
+	uint8_t month(int8_t gmt = 0) { return getTime(gmt).month; }
+	uint16_t year(int8_t gmt = 0) { return getTime(gmt).year; }
+
+	TimeT getTime(int8_t gmt = 0) {
+		time_t local = (time_t) getUnix() + gmt * 3600;
+		struct tm parts;
+		TimeT time;
+
+		gmtime_r(&local, &parts);
+		time.hour = parts.tm_hour;
+		time.minute = parts.tm_min;
+		time.second = parts.tm_sec;
+		time.weekday = parts.tm_wday ? parts.tm_wday : 7;
+		time.day = parts.tm_mday;
+		time.month = parts.tm_mon + 1;
+		time.year = parts.tm_year + 1900;
+
+		return time;
+	}
+
+	void setTime(int8_t gmt, TimeT time) {
+		setTime(gmt, time.hour, time.minute, time.second, time.day, time.month, time.year);
+	}
+
+	void setTime(int8_t gmt, uint8_t hour, uint8_t minute, uint8_t second, uint8_t day, uint8_t month, uint16_t year) {
+		struct tm parts;
+
+		memset(&parts, 0, sizeof(parts));
+		parts.tm_hour = hour;
+		parts.tm_min = minute;
+		parts.tm_sec = second;
+		parts.tm_mday = day;
+		parts.tm_mon = month - 1;
+		parts.tm_year = year - 1900;
+
+		setUnix(timegm(&parts) - gmt * 3600);
+	}
+
+	uint32_t getUnix() { return unix_time + (millis() - timer) / 1000; }
+
+	void setUnix(uint32_t time) {
+		unix_time = time;
+		timer = millis();
+	}
+
+private:
+	uint32_t unix_time;
+	uint32_t timer; // mls
+};
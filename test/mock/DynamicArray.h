@@ -0,0 +1,111 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * Host stand-in for the DynamicArray library, used by the native test env.
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <type_traits>
+
+template <class T>
+class DynamicArray {
+public:
+	DynamicArray() : data(NULL), count(0), max_size(0xFFFF) {}
+	DynamicArray(const DynamicArray& array) : data(NULL), count(0), max_size(array.max_size) { *this = array; }
+	~DynamicArray() { clear(); }
+
+	DynamicArray& operator=(const DynamicArray& array) {
+		if (this != &array) {
+			clear();
+
+			for (uint16_t i = 0;i < array.count;i++) {
+				add((T*) &array.data[i]);
+			}
+		}
+
+		return *this;
+	}
+
+	bool add() {
+		if (count >= max_size) {
+			return false;
+		}
+
+		T* next = new T[count + 1]();
+
+		for (uint16_t i = 0;i < count;i++) {
+			copy(next[i], data[i]);
+		}
+
+		delete[] data;
+		data = next;
+		count++;
+
+		return true;
+	}
+
+	bool add(T* value) {
+		if (!add()) {
+			return false;
+		}
+
+		copy(data[count - 1], *value);
+		return true;
+	}
+
+	template <class V = T, class = typename std::enable_if<!std::is_array<V>::value>::type>
+	bool add(const V& value) {
+		return add((T*) &value);
+	}
+
+	bool del(uint16_t index) {
+		if (index >= count) {
+			return false;
+		}
+
+		for (uint16_t i = index;i + 1 < count;i++) {
+			copy(data[i], data[i + 1]);
+		}
+
+		count--;
+
+		// the slot is dropped, a shorter array keeps the order
+		T* next = count ? new T[count]() : NULL;
+		for (uint16_t i = 0;i < count;i++) {
+			copy(next[i], data[i]);
+		}
+
+		delete[] data;
+		data = next;
+
+		return true;
+	}
+
+	// safe to call twice, the owners also call the destructor to empty the array
+	void clear() {
+		delete[] data;
+		data = NULL;
+		count = 0;
+	}
+
+	uint16_t size() { return count; }
+	void setMaxSize(uint16_t size) { max_size = size; }
+	uint16_t getMaxSize() { return max_size; }
+	T& operator[](uint16_t index) { return data[index]; }
+	T* get(uint16_t index) { return index < count ? &data[index] : NULL; }
+
+private:
+	template <class V> static void copy(V& to, const V& from) {
+		if constexpr (std::is_array<V>::value) {
+			memcpy(to, from, sizeof(V));
+		}
+		else {
+			to = from;
+		}
+	}
+
+	T* data;
+	uint16_t count;
+	uint16_t max_size;
+};
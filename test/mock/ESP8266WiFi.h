@@ -0,0 +1,62 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * Host stand-in for the ESP8266 WiFi stack, used by the native test env.
+ * The radio is off and never connects.
+ */
+
+#pragma once
+#include <Arduino.h>
+
+enum WiFiMode_t { WIFI_OFF, WIFI_STA, WIFI_AP, WIFI_AP_STA };
+enum wl_status_t {
+	WL_IDLE_STATUS = 0,
+	WL_NO_SSID_AVAIL,
+	WL_SCAN_COMPLETED,
+	WL_CONNECTED,
+	WL_CONNECT_FAILED,
+	WL_CONNECTION_LOST,
+	WL_WRONG_PASSWORD,
+	WL_DISCONNECTED,
+	WL_NO_SHIELD = 255
+};
+
+class IPAddress : public Printable {
+public:
+	IPAddress() { memset(bytes, 0, sizeof(bytes)); }
+	IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) { bytes[0] = a; bytes[1] = b; bytes[2] = c; bytes[3] = d; }
+
+	uint8_t operator[](int index) const { return bytes[index]; }
+	size_t printTo(Print& p) const { return p.print(toString()); }
+	String toString() const { return String(bytes[0]) + "." + bytes[1] + "." + bytes[2] + "." + bytes[3]; }
+
+private:
+	uint8_t bytes[4];
+};
+
+class ESP8266WiFiClass {
+public:
+	ESP8266WiFiClass() : wifi_mode(WIFI_OFF) {}
+
+	bool mode(WiFiMode_t mode) { wifi_mode = mode; return true; }
+	WiFiMode_t getMode() { return wifi_mode; }
+	template <class... A> bool begin(A... args) { return true; }
+	template <class... A> bool softAP(A... args) { return true; }
+	bool disconnect(bool off = false) { return true; }
+	wl_status_t status() { return WL_DISCONNECTED; }
+	int8_t scanNetworks(bool async = false, bool hidden = false) { return 0; }
+	String SSID() { return String(); }
+	String SSID(uint8_t index) { return String(); }
+	int32_t RSSI() { return 0; }
+	int32_t RSSI(uint8_t index) { return 0; }
+	IPAddress localIP() { return IPAddress(); }
+	IPAddress softAPIP() { return IPAddress(192, 168, 4, 1); }
+	uint8_t softAPgetStationNum() { return 0; }
+
+private:
+	WiFiMode_t wifi_mode;
+};
+
+inline ESP8266WiFiClass WiFi;
+
+class WiFiClient : public Stream {};
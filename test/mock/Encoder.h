@@ -0,0 +1,37 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * Host stand-in for the Encoder library, used by the native test env.
+ * The knob is never turned.
+ */
+
+#pragma once
+#include <Arduino.h>
+
+#define ENC_TYPE1 1
+#define ENC_TYPE2 2
+#define ENC_PORT_INPUT_PULLUP 1
+#define BUTTON_PORT_INPUT_PULLUP 1
+
+class Encoder {
+public:
+	Encoder() {}
+	Encoder(uint8_t clk, uint8_t dt, uint8_t sw) {}
+
+	void tick() {}
+	void setEncPortMode(uint8_t mode) {}
+	void setButPortMode(uint8_t mode) {}
+	void setButInvert(bool flag) {}
+	void clearButFlags() {}
+	void deleteTurns() {}
+
+	bool isTurn() { return false; }
+	bool isPressed() { return false; }
+	bool isLeft(bool flag = false) { return false; }
+	bool isRight(bool flag = false) { return false; }
+	bool isLeftH(bool flag = false) { return false; }
+	bool isRightH(bool flag = false) { return false; }
+	bool isClick(bool flag = false) { return false; }
+	bool isHolded(bool flag = false) { return false; }
+	int8_t getTurn(bool flag = false) { return 0; }
+};
@@ -0,0 +1,134 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * Host stand-in for GyverPortal, used by the native test env.
+ * Pages are never built or requested.
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <LittleFS.h>
+
+enum GPalign { GP_CENTER, GP_LEFT, GP_RIGHT, GP_EDGE, GP_JUSTIFY };
+enum GPcolor { GP_DARK, GP_LIGHT, GP_ORANGE, GP_YELLOW, GP_RED, GP_GREEN, GP_BLUE, GP_GRAY };
+enum GPblock { GP_TAB, GP_THIN, GP_DIV, GP_DIV_RAW };
+
+struct GPtime {
+	GPtime() : hour(0), minute(0), second(0) {}
+	GPtime(uint32_t unix, int16_t gmt = 0) : hour((unix + gmt * 3600) / 3600 % 24), minute(unix / 60 % 60), second(unix % 60) {}
+	GPtime(int hour, int minute, int second) : hour(hour), minute(minute), second(second) {}
+
+	uint8_t hour;
+	uint8_t minute;
+	uint8_t second;
+};
+
+struct GPdate {
+	GPdate() : year(2000), month(1), day(1) {}
+	GPdate(uint32_t unix, int16_t gmt = 0) : year(2000), month(1), day(1) {}
+	GPdate(int year, int month, int day) : year(year), month(month), day(day) {}
+
+	uint16_t year;
+	uint8_t month;
+	uint8_t day;
+};
+
+struct GPbuilder {
+	template <class... A> void BREAK(A... args) {}
+	template <class... A> void BUILD_BEGIN(A... args) {}
+	template <class... A> void BUILD_END(A... args) {}
+	template <class... A> void BUTTON(A... args) {}
+	template <class... A> void BUTTON_LINK(A... args) {}
+	template <class... A> void DATE(A... args) {}
+	template <class... A> void FILE_MANAGER(A... args) {}
+	template <class... A> void FILE_UPLOAD(A... args) {}
+	template <class... A> void HR(A... args) {}
+	template <class... A> void LABEL(A... args) {}
+	template <class... A> void NAV_TABS_LINKS(A... args) {}
+	template <class... A> void NUMBER(A... args) {}
+	template <class... A> void NUMBER_F(A... args) {}
+	template <class... A> void PASS_EYE(A... args) {}
+	template <class... A> void PLAIN(A... args) {}
+	template <class... A> void SELECT(A... args) {}
+	template <class... A> void SPAN(A... args) {}
+	template <class... A> void SUBMIT(A... args) {}
+	template <class... A> void SUBMIT_MINI(A... args) {}
+	template <class... A> void SWITCH(A... args) {}
+	template <class... A> void SYSTEM_INFO(A... args) {}
+	template <class... A> void TEXT(A... args) {}
+	template <class... A> void THEME(A... args) {}
+	template <class... A> void TIME(A... args) {}
+	template <class... A> void TITLE(A... args) {}
+	template <class... A> void UPDATE(A... args) {}
+	template <class... A> void BOX_BEGIN(A... args) {}
+	template <class... A> void BOX_END(A... args) {}
+	template <class... A> void BLOCK_BEGIN(A... args) {}
+	template <class... A> void BLOCK_END(A... args) {}
+	template <class... A> void SPOILER_BEGIN(A... args) {}
+	template <class... A> void SPOILER_END(A... args) {}
+	template <class... A> void FORM_BEGIN(A... args) {}
+	template <class... A> void FORM_END(A... args) {}
+};
+
+inline GPbuilder GP;
+
+class GyverPortal {
+public:
+	GyverPortal() {}
+	GyverPortal(FS* fs) {}
+
+	template <class... A> void attach(A... args) {}
+	template <class... A> void attachBuild(A... args) {}
+	template <class... A> void start(A... args) {}
+	template <class... A> void enableOTA(A... args) {}
+	template <class... A> void answer(A... args) {}
+	void stop() {}
+	bool tick() { return false; }
+
+	bool update() { return false; }
+	bool update(const String& name) { return false; }
+	bool click() { return false; }
+	bool click(const String& name) { return false; }
+	bool clickSub(const String& name) { return false; }
+	bool form() { return false; }
+	bool form(const String& name) { return false; }
+	bool formSub(const String& name) { return false; }
+	bool uri(const String& name) { return false; }
+
+	int getInt() { return 0; }
+	bool getBool() { return false; }
+	float getFloat() { return 0; }
+	String getString() { return String(); }
+	GPtime getTime() { return GPtime(); }
+	GPdate getDate() { return GPdate(); }
+	bool copyStr(char* buffer, int size = 0) { return false; }
+	bool copyStr(const String& name, char* buffer, int size = 0) { return false; }
+	String clickName() { return String(); }
+	String updateName() { return String(); }
+	String formName() { return String(); }
+};
+
+// https://stackoverflow.com/a/30566098
+#define OVR_MACRO(M, ...) _OVR(M, _COUNT_ARGS(__VA_ARGS__)) (__VA_ARGS__)
+#define _OVR(mName, nArgs) _OVR_EXPAND(mName, nArgs)
+#define _OVR_EXPAND(mName, nArgs) mName##nArgs
+#define _COUNT_ARGS(...) _ARG_MATCH(__VA_ARGS__, 9, 8, 7, 6, 5, 4, 3, 2, 1)
+#define _ARG_MATCH(_1, _2, _3, _4, _5, _6, _7, _8, _9, N, ...) N
+
+#define M_FORM(...) OVR_MACRO(M_FORM, __VA_ARGS__)
+#define M_FORM2(act, args) GP.FORM_BEGIN(act); args; GP.FORM_END();
+#define M_FORM3(act, subm, args) GP.FORM_BEGIN(act); args; GP.SUBMIT(subm); GP.FORM_END();
+
+#define M_BOX(...) OVR_MACRO(M_BOX, __VA_ARGS__)
+#define M_BOX1(args) GP.BOX_BEGIN(); args; GP.BOX_END();
+#define M_BOX2(align, args) GP.BOX_BEGIN(align); args; GP.BOX_END();
+#define M_BOX3(align, width, args) GP.BOX_BEGIN(align, width); args; GP.BOX_END();
+
+#define M_BLOCK(...) OVR_MACRO(M_BLOCK, __VA_ARGS__)
+#define M_BLOCK1(args) GP.BLOCK_BEGIN(); args; GP.BLOCK_END();
+#define M_BLOCK2(type, args) GP.BLOCK_BEGIN(type); args; GP.BLOCK_END();
+#define M_BLOCK3(type, width, args) GP.BLOCK_BEGIN(type, width); args; GP.BLOCK_END();
+
+#define M_SPOILER(...) OVR_MACRO(M_SPOILER, __VA_ARGS__)
+#define M_SPOILER2(text, args) GP.SPOILER_BEGIN(text); args; GP.SPOILER_END();
+#define M_SPOILER3(text, style, args) GP.SPOILER_BEGIN(text, style); args; GP.SPOILER_END();
@@ -0,0 +1,33 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * Host stand-in for the LiquidCrystal_I2C library, used by the native test env.
+ * The display itself is driven through I2CManager, only the base class is kept.
+ */
+
+#pragma once
+#include <Arduino.h>
+
+#define LCD_CLEARDISPLAY 0x01
+#define LCD_SETCGRAMADDR 0x40
+#define LCD_SETDDRAMADDR 0x80
+#define LCD_BACKLIGHT 0x08
+#define LCD_NOBACKLIGHT 0x00
+
+#define En B00000100 // enable bit
+#define Rw B00000010 // read/write bit
+#define Rs B00000001 // register select bit
+
+class LiquidCrystal_I2C : public Print {
+public:
+	LiquidCrystal_I2C(uint8_t address, uint8_t cols, uint8_t rows) {}
+
+	void init() {}
+	void clear() {}
+	void backlight() {}
+	void noBacklight() {}
+	void setCursor(uint8_t x, uint8_t y) {}
+	void createChar(uint8_t location, const uint8_t* charmap) {}
+	size_t write(uint8_t value) { return 1; }
+	using Print::write;
+};
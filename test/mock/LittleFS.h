@@ -0,0 +1,80 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * Host stand-in for LittleFS, used by the native test env.
+ * Files live in memory for the life of the test binary.
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <map>
+
+namespace mock {
+	inline std::map<std::string, std::string> files;
+}
+
+class File : public Stream {
+public:
+	File() : content(NULL), position(0), write_flag(false) {}
+	File(std::string* content, bool write_flag) : content(content), position(0), write_flag(write_flag) {}
+
+	operator bool() const { return content != NULL; }
+
+	size_t write(uint8_t value) { return write(&value, 1); }
+	size_t write(const uint8_t* buffer, size_t size) {
+		if (content == NULL || !write_flag) {
+			return 0;
+		}
+
+		content->append((const char*) buffer, size);
+		return size;
+	}
+	size_t write(const char* buffer, size_t size) { return write((const uint8_t*) buffer, size); }
+
+	size_t read(uint8_t* buffer, size_t size) {
+		if (content == NULL) {
+			return 0;
+		}
+
+		size = min(size, content->size() - position);
+		memcpy(buffer, content->data() + position, size);
+		position += size;
+
+		return size;
+	}
+	int read() { uint8_t value; return read(&value, 1) ? value : -1; }
+	int available() { return content == NULL ? 0 : content->size() - position; }
+	size_t size() { return content == NULL ? 0 : content->size(); }
+	bool seek(uint32_t position) { this->position = min((size_t) position, size()); return true; }
+	String readString() { String text(content == NULL ? "" : content->substr(position)); position = size(); return text; }
+	void close() { content = NULL; }
+
+private:
+	std::string* content;
+	size_t position;
+	bool write_flag;
+};
+
+class FS {
+public:
+	bool begin() { return true; }
+	bool format() { mock::files.clear(); return true; }
+	bool exists(const char* path) { return mock::files.count(path) > 0; }
+	bool remove(const char* path) { return mock::files.erase(path) > 0; }
+
+	File open(const String& path, const char* mode) { return open(path.c_str(), mode); }
+	File open(const char* path, const char* mode) {
+		if (*mode == 'w') {
+			mock::files[path].clear();
+			return File(&mock::files[path], true);
+		}
+
+		if (!exists(path)) {
+			return File();
+		}
+
+		return File(&mock::files[path], false);
+	}
+};
+
+inline FS LittleFS;
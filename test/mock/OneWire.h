@@ -0,0 +1,639 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * Host stand-in for OneWire, used by the native test env.
+ * A bus is found by its pin and holds simulated DS18B20 sensors. They answer slot by
+ * slot with a wired-and, so searches, collisions and missing sensors behave like on
+ * the wire. Every reset and slot costs its standard speed time on the simulated clock.
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <vector>
+
+#define FAKE_ONEWIRE_RESET_TIME 960 // mcs, reset pulse and presence window
+#define FAKE_ONEWIRE_SLOT_TIME 65 // mcs, one bit
+
+#define FAKE_DS18B20_CONVERT_TIME 750000 // mcs, 12 bit, halves with every bit less
+#define FAKE_DS18B20_POWER_ON_RAW 0x0550 // 85°
+#define FAKE_DS18B20_EEPROM_TH 75
+#define FAKE_DS18B20_EEPROM_TL 70
+#define FAKE_DS18B20_EEPROM_CONFIG 0x7F // 12 bit
+
+#define FAKE_DS18B20_STATE_IDLE 0 // released until the next reset
+#define FAKE_DS18B20_STATE_ROM 1
+#define FAKE_DS18B20_STATE_MATCH 2
+#define FAKE_DS18B20_STATE_SEARCH 3
+#define FAKE_DS18B20_STATE_FUNCTION 4
+#define FAKE_DS18B20_STATE_WRITE 5
+#define FAKE_DS18B20_STATE_SEND 6
+#define FAKE_DS18B20_STATE_CONVERT 7
+#define FAKE_DS18B20_STATE_POWER 8
+
+namespace mock {
+	inline uint8_t crc8(const uint8_t* data, uint8_t length) {
+		uint8_t crc = 0;
+
+		while (length--) {
+			uint8_t value = *data++;
+
+			for (uint8_t i = 0;i < 8;i++) {
+				uint8_t mix = (crc ^ value) & 0x01;
+
+				crc >>= 1;
+				if (mix) {
+					crc ^= 0x8C;
+				}
+
+				value >>= 1;
+			}
+		}
+
+		return crc;
+	}
+}
+
+
+class FakeDS18B20 {
+public:
+	FakeDS18B20(uint64_t serial, int32_t t = 2000) {
+		rom[0] = 0x28;
+		for (uint8_t i = 1;i < 7;i++) {
+			rom[i] = serial >> ((i - 1) * 8);
+		}
+		rom[7] = mock::crc8(rom, 7);
+
+		eeprom[0] = FAKE_DS18B20_EEPROM_TH;
+		eeprom[1] = FAKE_DS18B20_EEPROM_TL;
+		eeprom[2] = FAKE_DS18B20_EEPROM_CONFIG;
+
+		this->t = t;
+		trajectory = NULL;
+		convert_delay = 0;
+		connected_flag = true;
+		parasite_flag = false;
+		crc_breaks = 0;
+		eeprom_writes = 0;
+		powerOn();
+	}
+
+	/* the test side */
+	// c°, sampled at the end of every conversion
+	void setT(int32_t t) { this->t = t; }
+	// c° by mls, replaces the fixed value
+	void setTrajectory(int32_t (*trajectory)(uint32_t time)) { this->trajectory = trajectory; }
+	// mcs over the datasheet time, a slow part
+	void setConvertDelay(uint32_t delay) { convert_delay = delay; }
+	void setConnected(bool flag) { connected_flag = flag; state = FAKE_DS18B20_STATE_IDLE; }
+	void setParasite(bool flag) { parasite_flag = flag; }
+	// the next scratchpad reads carry a flipped bit
+	void breakCrc(uint8_t count) { crc_breaks = count; }
+
+	// a power cycle, the scratchpad holds 85° again
+	void powerOn() {
+		uint16_t raw = FAKE_DS18B20_POWER_ON_RAW;
+
+		scratchpad[0] = raw;
+		scratchpad[1] = raw >> 8;
+		memcpy(scratchpad + 2, eeprom, 3);
+		scratchpad[5] = 0xFF;
+		scratchpad[6] = 0x0C;
+		scratchpad[7] = 0x10;
+		scratchpad[8] = mock::crc8(scratchpad, 8);
+
+		state = FAKE_DS18B20_STATE_IDLE;
+		converting_flag = false;
+		alarm_flag = false;
+		conversions = 0;
+		scratchpad_reads = 0;
+		scratchpad_writes = 0;
+	}
+
+	uint8_t getResolution() { return 9 + ((scratchpad[4] >> 5) & 0x03); }
+	uint8_t getEepromResolution() { return 9 + ((eeprom[2] >> 5) & 0x03); }
+	int8_t getAlarmHigh() { return scratchpad[2]; }
+	int8_t getAlarmLow() { return scratchpad[3]; }
+	bool getAlarmFlag() { update(); return alarm_flag; }
+	bool isConverting() { update(); return converting_flag; }
+
+	uint8_t rom[8];
+	uint32_t conversions;
+	uint32_t scratchpad_reads;
+	uint32_t scratchpad_writes;
+	uint32_t eeprom_writes; // kept over power cycles
+
+	/* the wire side */
+	bool reset() {
+		update();
+		state = connected_flag ? FAKE_DS18B20_STATE_ROM : FAKE_DS18B20_STATE_IDLE;
+		rx_bits = 0;
+
+		return connected_flag;
+	}
+
+	uint8_t readBit() {
+		update();
+
+		switch (state) {
+		case FAKE_DS18B20_STATE_SEND: {
+			if (tx_bit >= tx_length * 8) {
+				return 1;
+			}
+
+			uint8_t bit = (tx[tx_bit / 8] >> (tx_bit % 8)) & 0x01;
+			tx_bit++;
+
+			return bit;
+		}
+		case FAKE_DS18B20_STATE_SEARCH: {
+			uint8_t bit = (rom[search_bit / 8] >> (search_bit % 8)) & 0x01;
+
+			if (search_phase == 0) {
+				search_phase = 1;
+				return bit;
+			}
+
+			if (search_phase == 1) {
+				search_phase = 2;
+				return !bit;
+			}
+
+			return 1;
+		}
+		case FAKE_DS18B20_STATE_CONVERT:
+			return !converting_flag;
+		case FAKE_DS18B20_STATE_POWER:
+			return !parasite_flag;
+		default:
+			return 1;
+		}
+	}
+
+	void writeBit(uint8_t bit) {
+		update();
+
+		if (state == FAKE_DS18B20_STATE_SEARCH) {
+			// the master picks the branch, the other side drops out
+			if (search_phase != 2 || bit != ((rom[search_bit / 8] >> (search_bit % 8)) & 0x01)) {
+				state = FAKE_DS18B20_STATE_IDLE;
+				return;
+			}
+
+			search_phase = 0;
+			if (++search_bit >= 64) {
+				state = FAKE_DS18B20_STATE_FUNCTION;
+			}
+
+			return;
+		}
+
+		if (state != FAKE_DS18B20_STATE_ROM && state != FAKE_DS18B20_STATE_MATCH && state != FAKE_DS18B20_STATE_FUNCTION && state != FAKE_DS18B20_STATE_WRITE) {
+			return;
+		}
+
+		rx_byte = (rx_byte >> 1) | (bit ? 0x80 : 0);
+		if (++rx_bits == 8) {
+			rx_bits = 0;
+			receive(rx_byte);
+		}
+	}
+
+private:
+	void receive(uint8_t value) {
+		switch (state) {
+		case FAKE_DS18B20_STATE_ROM:
+			switch (value) {
+			case 0x33: // read rom
+				send(rom, 8);
+				break;
+			case 0x55: // match rom
+				state = FAKE_DS18B20_STATE_MATCH;
+				match_bytes = 0;
+				match_flag = true;
+				break;
+			case 0xCC: // skip rom
+				state = FAKE_DS18B20_STATE_FUNCTION;
+				break;
+			case 0xF0: // search rom
+			case 0xEC: // alarm search
+				state = (value == 0xF0 || alarm_flag) ? FAKE_DS18B20_STATE_SEARCH : FAKE_DS18B20_STATE_IDLE;
+				search_bit = 0;
+				search_phase = 0;
+				break;
+			default:
+				state = FAKE_DS18B20_STATE_IDLE;
+			}
+			break;
+		case FAKE_DS18B20_STATE_MATCH:
+			match_flag = match_flag && value == rom[match_bytes];
+
+			if (++match_bytes == 8) {
+				state = match_flag ? FAKE_DS18B20_STATE_FUNCTION : FAKE_DS18B20_STATE_IDLE;
+			}
+			break;
+		case FAKE_DS18B20_STATE_FUNCTION:
+			switch (value) {
+			case 0x44: // convert t
+				converting_flag = true;
+				convert_end = mock::clock + (FAKE_DS18B20_CONVERT_TIME >> (12 - getResolution())) + convert_delay;
+				conversions++;
+				state = FAKE_DS18B20_STATE_CONVERT;
+				break;
+			case 0xBE: { // read scratchpad
+				uint8_t data[9];
+
+				memcpy(data, scratchpad, 9);
+				if (crc_breaks) {
+					crc_breaks--;
+					data[0] ^= 0x01;
+				}
+
+				scratchpad_reads++;
+				send(data, 9);
+				break;
+			}
+			case 0x4E: // write scratchpad
+				state = FAKE_DS18B20_STATE_WRITE;
+				write_bytes = 0;
+				break;
+			case 0x48: // copy scratchpad
+				memcpy(eeprom, scratchpad + 2, 3);
+				eeprom_writes++;
+				state = FAKE_DS18B20_STATE_IDLE;
+				break;
+			case 0xB8: // recall eeprom
+				memcpy(scratchpad + 2, eeprom, 3);
+				scratchpad[8] = mock::crc8(scratchpad, 8);
+				state = FAKE_DS18B20_STATE_IDLE;
+				break;
+			case 0xB4: // read power supply
+				state = FAKE_DS18B20_STATE_POWER;
+				break;
+			default:
+				state = FAKE_DS18B20_STATE_IDLE;
+			}
+			break;
+		case FAKE_DS18B20_STATE_WRITE:
+			// th, tl and the configuration, the reserved bits read as ones
+			scratchpad[2 + write_bytes] = (write_bytes == 2) ? (value & 0x60) | 0x1F : value;
+			scratchpad[8] = mock::crc8(scratchpad, 8);
+			scratchpad_writes += (write_bytes == 2);
+
+			if (++write_bytes == 3) {
+				state = FAKE_DS18B20_STATE_IDLE;
+			}
+			break;
+		}
+	}
+
+	void send(const uint8_t* data, uint8_t length) {
+		memcpy(tx, data, length);
+		tx_length = length;
+		tx_bit = 0;
+		state = FAKE_DS18B20_STATE_SEND;
+	}
+
+	// a conversion runs on its own, the bus is not needed for it to end
+	void update() {
+		if (!converting_flag || mock::clock < convert_end) {
+			return;
+		}
+
+		int32_t centi = trajectory ? trajectory(convert_end / 1000) : t;
+
+		centi = constrain(centi, (int32_t) -5500, (int32_t) 12500);
+		int16_t raw = (int16_t) floor(centi * 16 / 100.0 + 0.5);
+
+		raw &= ~((1 << (12 - getResolution())) - 1);
+		scratchpad[0] = raw;
+		scratchpad[1] = raw >> 8;
+		scratchpad[8] = mock::crc8(scratchpad, 8);
+
+		int8_t whole = raw >> 4;
+		alarm_flag = whole >= (int8_t) scratchpad[2] || whole <= (int8_t) scratchpad[3];
+		converting_flag = false;
+	}
+
+	int32_t t;
+	int32_t (*trajectory)(uint32_t time);
+	uint32_t convert_delay; // mcs
+	bool connected_flag;
+	bool parasite_flag;
+	uint8_t crc_breaks;
+
+	uint8_t scratchpad[9];
+	uint8_t eeprom[3];
+	uint8_t state;
+	bool converting_flag;
+	uint64_t convert_end; // mcs
+	bool alarm_flag;
+
+	uint8_t rx_byte;
+	uint8_t rx_bits;
+	uint8_t tx[9];
+	uint8_t tx_length;
+	uint8_t tx_bit;
+	uint8_t match_bytes;
+	bool match_flag;
+	uint8_t write_bytes;
+	uint8_t search_bit;
+	uint8_t search_phase; // 0 - the bit, 1 - its complement, 2 - the master direction
+};
+
+
+class FakeOneWireBus;
+namespace mock {
+	inline std::vector<FakeOneWireBus*> onewire_buses;
+}
+
+class FakeOneWireBus {
+public:
+	FakeOneWireBus(uint8_t pin) : pin(pin), resets(0), slots(0), time(0) {
+		mock::onewire_buses.push_back(this);
+	}
+
+	~FakeOneWireBus() {
+		mock::onewire_buses.erase(std::find(mock::onewire_buses.begin(), mock::onewire_buses.end(), this));
+	}
+
+	static FakeOneWireBus* find(uint8_t pin) {
+		for (FakeOneWireBus* bus : mock::onewire_buses) {
+			if (bus->pin == pin) {
+				return bus;
+			}
+		}
+
+		return NULL;
+	}
+
+	void add(FakeDS18B20* device) { devices.push_back(device); }
+	void remove(FakeDS18B20* device) { devices.erase(std::find(devices.begin(), devices.end(), device)); }
+
+	bool reset() {
+		bool presence = false;
+
+		for (FakeDS18B20* device : devices) {
+			presence |= device->reset();
+		}
+
+		spend(FAKE_ONEWIRE_RESET_TIME);
+		resets++;
+
+		return presence;
+	}
+
+	// every device drives its bit, a zero wins
+	uint8_t readBit() {
+		uint8_t bit = 1;
+
+		for (FakeDS18B20* device : devices) {
+			bit &= device->readBit();
+		}
+
+		spend(FAKE_ONEWIRE_SLOT_TIME);
+		slots++;
+
+		return bit;
+	}
+
+	void writeBit(uint8_t bit) {
+		for (FakeDS18B20* device : devices) {
+			device->writeBit(bit);
+		}
+
+		spend(FAKE_ONEWIRE_SLOT_TIME);
+		slots++;
+	}
+
+	static void charge(uint32_t time) {
+		mock::advance(time);
+	}
+
+	void spend(uint32_t time) {
+		this->time += time;
+		charge(time);
+	}
+
+	void resetStats() {
+		resets = 0;
+		slots = 0;
+		time = 0;
+	}
+
+	uint8_t pin;
+	std::vector<FakeDS18B20*> devices;
+
+	uint32_t resets;
+	uint32_t slots;
+	uint64_t time; // mcs on the wire
+};
+
+
+class OneWire {
+public:
+	OneWire() : pin(0xFF) { reset_search(); }
+	OneWire(uint8_t pin) { begin(pin); }
+
+	void begin(uint8_t pin) {
+		this->pin = pin;
+		reset_search();
+	}
+
+	uint8_t reset() {
+		FakeOneWireBus* bus = FakeOneWireBus::find(pin);
+
+		if (bus == NULL) {
+			FakeOneWireBus::charge(FAKE_ONEWIRE_RESET_TIME);
+			return 0;
+		}
+
+		return bus->reset();
+	}
+
+	void select(const uint8_t rom[8]) {
+		write(0x55);
+
+		for (uint8_t i = 0;i < 8;i++) {
+			write(rom[i]);
+		}
+	}
+
+	void skip() {
+		write(0xCC);
+	}
+
+	void write(uint8_t value, uint8_t power = 0) {
+		for (uint8_t i = 0;i < 8;i++) {
+			write_bit((value >> i) & 0x01);
+		}
+	}
+
+	void write_bytes(const uint8_t* buffer, uint16_t count, bool power = 0) {
+		for (uint16_t i = 0;i < count;i++) {
+			write(buffer[i]);
+		}
+	}
+
+	uint8_t read() {
+		uint8_t value = 0;
+
+		for (uint8_t i = 0;i < 8;i++) {
+			value |= read_bit() << i;
+		}
+
+		return value;
+	}
+
+	void read_bytes(uint8_t* buffer, uint16_t count) {
+		for (uint16_t i = 0;i < count;i++) {
+			buffer[i] = read();
+		}
+	}
+
+	void write_bit(uint8_t value) {
+		FakeOneWireBus* bus = FakeOneWireBus::find(pin);
+
+		if (bus == NULL) {
+			FakeOneWireBus::charge(FAKE_ONEWIRE_SLOT_TIME);
+			return;
+		}
+
+		bus->writeBit(value);
+	}
+
+	uint8_t read_bit() {
+		FakeOneWireBus* bus = FakeOneWireBus::find(pin);
+
+		if (bus == NULL) {
+			FakeOneWireBus::charge(FAKE_ONEWIRE_SLOT_TIME);
+			return 1;
+		}
+
+		return bus->readBit();
+	}
+
+	void depower() {}
+
+	void reset_search() {
+		last_discrepancy = 0;
+		last_family_discrepancy = 0;
+		last_device_flag = false;
+		memset(rom, 0, sizeof(rom));
+	}
+
+	void target_search(uint8_t family_code) {
+		reset_search();
+		rom[0] = family_code;
+		last_discrepancy = 64;
+	}
+
+	// the search of the application note 187
+	bool search(uint8_t* address, bool search_mode = true) {
+		uint8_t bit_number = 1;
+		uint8_t last_zero = 0;
+		uint8_t byte_number = 0;
+		uint8_t byte_mask = 1;
+		bool result = false;
+
+		if (!last_device_flag) {
+			if (!reset()) {
+				reset_search();
+				return false;
+			}
+
+			write(search_mode ? 0xF0 : 0xEC);
+
+			do {
+				uint8_t bit = read_bit();
+				uint8_t cmp_bit = read_bit();
+				uint8_t direction;
+
+				if (bit && cmp_bit) {
+					break;
+				}
+
+				if (bit != cmp_bit) {
+					direction = bit;
+				}
+				else {
+					direction = (bit_number < last_discrepancy) ? (rom[byte_number] & byte_mask) > 0 : bit_number == last_discrepancy;
+
+					if (!direction) {
+						last_zero = bit_number;
+
+						if (last_zero < 9) {
+							last_family_discrepancy = last_zero;
+						}
+					}
+				}
+
+				if (direction) {
+					rom[byte_number] |= byte_mask;
+				}
+				else {
+					rom[byte_number] &= ~byte_mask;
+				}
+
+				write_bit(direction);
+				bit_number++;
+				byte_mask <<= 1;
+
+				if (!byte_mask) {
+					byte_number++;
+					byte_mask = 1;
+				}
+			} while (byte_number < 8);
+
+			if (bit_number > 64) {
+				last_discrepancy = last_zero;
+				last_device_flag = !last_discrepancy;
+				result = true;
+			}
+		}
+
+		if (!result || !rom[0]) {
+			reset_search();
+			return false;
+		}
+
+		memcpy(address, rom, 8);
+		return true;
+	}
+
+	static uint8_t crc8(const uint8_t* data, uint8_t length) {
+		return mock::crc8(data, length);
+	}
+
+	static uint16_t crc16(const uint8_t* input, uint16_t length, uint16_t crc = 0) {
+		static const uint8_t odd_parity[16] = {0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0};
+
+		for (uint16_t i = 0;i < length;i++) {
+			uint16_t value = (input[i] ^ crc) & 0xFF;
+
+			crc >>= 8;
+			if (odd_parity[value & 0x0F] ^ odd_parity[value >> 4]) {
+				crc ^= 0xC001;
+			}
+
+			value <<= 6;
+			crc ^= value;
+			value <<= 1;
+			crc ^= value;
+		}
+
+		return crc;
+	}
+
+	static bool check_crc16(const uint8_t* input, uint16_t length, const uint8_t* inverted_crc, uint16_t crc = 0) {
+		crc = ~crc16(input, length, crc);
+		return (crc & 0xFF) == inverted_crc[0] && (crc >> 8) == inverted_crc[1];
+	}
+
+private:
+	uint8_t pin;
+
+	uint8_t rom[8];
+	uint8_t last_discrepancy;
+	uint8_t last_family_discrepancy;
+	bool last_device_flag;
+};
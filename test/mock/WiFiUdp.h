@@ -0,0 +1,23 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * Host stand-in for WiFiUdp, used by the native test env. No packet ever arrives.
+ */
+
+#pragma once
+#include <ESP8266WiFi.h>
+
+class WiFiUDP : public Stream {
+public:
+	uint8_t begin(uint16_t port) { return 1; }
+	void stop() {}
+	int beginPacket(const char* host, uint16_t port) { return 1; }
+	int beginPacket(IPAddress ip, uint16_t port) { return 1; }
+	int endPacket() { return 1; }
+	size_t write(uint8_t value) { return 1; }
+	size_t write(const uint8_t* buffer, size_t size) { return size; }
+	int parsePacket() { return 0; }
+	int read() { return -1; }
+	int read(uint8_t* buffer, size_t size) { return 0; }
+	int available() { return 0; }
+};
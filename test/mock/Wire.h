@@ -0,0 +1,26 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * Host stand-in for the Wire library, used by the native test env.
+ * Nobody answers on the bus, every address is not acknowledged.
+ */
+
+#pragma once
+#include <Arduino.h>
+
+class TwoWire : public Stream {
+public:
+	void begin() {}
+	void begin(int sda, int scl) {}
+	void setClock(uint32_t frequency) {}
+	void setClockStretchLimit(uint32_t limit) {}
+	void beginTransmission(uint8_t address) {}
+	uint8_t endTransmission(bool stop = true) { return 2; }
+	uint8_t requestFrom(uint8_t address, uint8_t size, bool stop = true) { return 0; }
+	size_t write(uint8_t value) { return 1; }
+	size_t write(const uint8_t* buffer, size_t size) { return size; }
+	int available() { return 0; }
+	int read() { return -1; }
+};
+
+inline TwoWire Wire;
@@ -0,0 +1,116 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * Host stand-in for the Settings library, used by the native test env.
+ * Every entry is "<code>=<value>;", arrays are comma separated.
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <type_traits>
+
+namespace mock {
+	inline char* findParameter(char* buffer, const String& code) {
+		String key = code + "=";
+		char* pointer = buffer;
+
+		while ((pointer = strstr(pointer, key.c_str())) != NULL) {
+			if (pointer == buffer || pointer[-1] == ';') {
+				return pointer + key.length();
+			}
+
+			pointer++;
+		}
+
+		return NULL;
+	}
+
+	template <class T> void appendValue(std::string& line, T value) {
+		if constexpr (std::is_floating_point<T>::value) {
+			line += String((double) value, 2).s;
+		}
+		else {
+			line += std::to_string((long long) value);
+		}
+	}
+
+	template <class T> void parseValue(const char* text, T* value) {
+		if constexpr (std::is_floating_point<T>::value) {
+			*value = atof(text);
+		}
+		else {
+			*value = (T) atoll(text);
+		}
+	}
+}
+
+template <class T> void setParameter(char* buffer, String code, T value) {
+	std::string line = code.s + "=";
+
+	mock::appendValue(line, value);
+	strcat(buffer, (line + ";").c_str());
+}
+
+inline void setParameter(char* buffer, String code, const char* value) {
+	strcat(buffer, (code.s + "=" + (value ? value : "") + ";").c_str());
+}
+
+inline void setParameter(char* buffer, String code, char* value) {
+	setParameter(buffer, code, (const char*) value);
+}
+
+template <class T> void setParameter(char* buffer, String code, T* value, uint16_t count) {
+	std::string line = code.s + "=";
+
+	for (uint16_t i = 0;i < count;i++) {
+		if (i) {
+			line += ",";
+		}
+
+		mock::appendValue(line, value[i]);
+	}
+
+	strcat(buffer, (line + ";").c_str());
+}
+
+template <class T> bool getParameter(char* buffer, String code, T* value) {
+	char* pointer = mock::findParameter(buffer, code);
+
+	if (pointer == NULL) {
+		return false;
+	}
+
+	mock::parseValue(pointer, value);
+	return true;
+}
+
+// char arrays are strings, the rest are comma separated lists
+template <class T> bool getParameter(char* buffer, String code, T* value, uint16_t count) {
+	char* pointer = mock::findParameter(buffer, code);
+
+	if (pointer == NULL) {
+		return false;
+	}
+
+	if constexpr (std::is_same<T, char>::value) {
+		uint16_t length = strcspn(pointer, ";");
+
+		length = min(length, (uint16_t) (count - 1));
+		memcpy(value, pointer, length);
+		value[length] = 0;
+	}
+	else {
+		for (uint16_t i = 0;i < count;i++) {
+			mock::parseValue(pointer, &value[i]);
+			pointer += strcspn(pointer, ",;");
+
+			if (*pointer != ',') {
+				break;
+			}
+
+			pointer++;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,378 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * DS18B20 readout on the fake OneWire bus: discovery, conversion times, crc errors,
+ * disconnects and the 85° power-on value. The benchmark prints the tick latency and
+ * the bus load of SensorsManager for 1 to 10 sensors.
+ */
+
+#include <unity.h>
+#include "data.h"
+
+#define TEST_LOOP_TIME 1 // mls between two ticks of the main loop
+#define TEST_SENSORS_T 2150 // c°, + 100 per sensor
+
+SystemManager systemManager;
+
+static FakeOneWireBus* bus;
+static FakeDS18B20* devices[DS_SENSORS_MAX_COUNT];
+static uint8_t devices_count;
+static SensorsManager* sensors;
+
+void setUp() {
+	mock::reset();
+
+	bus = new FakeOneWireBus(DS18B20_PORT);
+	devices_count = 0;
+	sensors = new SensorsManager();
+	sensors->setSystemManager(&systemManager);
+}
+
+void tearDown() {
+	delete sensors;
+
+	for (uint8_t i = 0;i < devices_count;i++) {
+		delete devices[i];
+	}
+
+	delete bus;
+}
+
+static void addDevices(uint8_t count) {
+	for (uint8_t i = 0;i < count;i++) {
+		devices[devices_count] = new FakeDS18B20(0xA5000 + devices_count * 0x1111, TEST_SENSORS_T + devices_count * 100);
+		bus->add(devices[devices_count++]);
+	}
+}
+
+// every device of the bus gets an entry, like the settings screen does
+static void addSensors() {
+	sensors->begin();
+
+	for (uint8_t i = 0;i < devices_count;i++) {
+		sensors->addDS18B20();
+		sensors->setDS18B20Address(i, devices[i]->rom);
+	}
+}
+
+static void run(uint32_t time) {
+	uint64_t end = mock::clock + (uint64_t) time * 1000;
+
+	while (mock::clock < end) {
+		sensors->tick();
+		mock::advance(TEST_LOOP_TIME * 1000);
+	}
+}
+
+static int32_t rampTrajectory(uint32_t time) {
+	return 2000 + (int32_t) (time / 1000) * 5; // 0.05°/sec
+}
+
+
+void test_search_finds_every_rom() {
+	OneWire wire(DS18B20_PORT);
+	DeviceAddress address;
+	uint8_t found = 0;
+
+	addDevices(DS_SENSORS_MAX_COUNT);
+
+	while (wire.search(address)) {
+		TEST_ASSERT_EQUAL_UINT8(OneWire::crc8(address, 7), address[7]);
+
+		for (uint8_t i = 0;i < devices_count;i++) {
+			found += !memcmp(address, devices[i]->rom, 8);
+		}
+	}
+
+	TEST_ASSERT_EQUAL(DS_SENSORS_MAX_COUNT, found);
+
+	DallasTemperature dallas(&wire);
+	dallas.begin();
+	TEST_ASSERT_EQUAL(DS_SENSORS_MAX_COUNT, dallas.getDS18Count());
+}
+
+void test_alarm_search_finds_only_alarmed_devices() {
+	OneWire wire(DS18B20_PORT);
+	DallasTemperature dallas(&wire);
+	DeviceAddress address;
+
+	addDevices(3);
+	dallas.begin();
+
+	// 21.5°, 22.5° and 23.5° against a 22..23° band
+	for (uint8_t i = 0;i < devices_count;i++) {
+		dallas.setHighAlarmTemp(devices[i]->rom, 23);
+		dallas.setLowAlarmTemp(devices[i]->rom, 21);
+	}
+
+	dallas.setWaitForConversion(false);
+	dallas.requestTemperatures();
+	delay(dallas.millisToWaitForConversion(12));
+
+	TEST_ASSERT_FALSE(devices[1]->getAlarmFlag());
+	TEST_ASSERT_TRUE(devices[0]->getAlarmFlag());
+	TEST_ASSERT_TRUE(devices[2]->getAlarmFlag());
+
+	uint8_t found = 0;
+	wire.reset_search();
+	while (wire.search(address, false)) {
+		TEST_ASSERT_TRUE(memcmp(address, devices[1]->rom, 8));
+		found++;
+	}
+
+	TEST_ASSERT_EQUAL(2, found);
+}
+
+void test_conversion_time_follows_resolution() {
+	OneWire wire(DS18B20_PORT);
+	DallasTemperature dallas(&wire);
+
+	addDevices(1);
+	devices[0]->setT(2169);
+	dallas.begin();
+	dallas.setWaitForConversion(false);
+
+	for (uint8_t resolution = 9;resolution <= 12;resolution++) {
+		uint32_t convert_time = FAKE_DS18B20_CONVERT_TIME >> (12 - resolution);
+
+		dallas.setResolution(devices[0]->rom, resolution);
+		TEST_ASSERT_EQUAL(resolution, devices[0]->getResolution());
+
+		dallas.requestTemperaturesByAddress(devices[0]->rom);
+		uint64_t timer = mock::clock;
+
+		mock::advance(convert_time - (mock::clock - timer) - 1000);
+		TEST_ASSERT_FALSE(dallas.isConversionComplete());
+
+		mock::advance(1000);
+		TEST_ASSERT_TRUE(dallas.isConversionComplete());
+
+		// 21.69° is 347.04/16, the low bits are cleared by the resolution
+		int16_t raw = 347 & ~((1 << (12 - resolution)) - 1);
+		TEST_ASSERT_EQUAL_INT16(raw * 8, dallas.getTemp(devices[0]->rom));
+	}
+}
+
+void test_power_on_value() {
+	OneWire wire(DS18B20_PORT);
+	DallasTemperature dallas(&wire);
+
+	addDevices(1);
+	dallas.begin();
+
+	TEST_ASSERT_EQUAL_INT16(85 * 128, dallas.getTemp(devices[0]->rom));
+}
+
+void test_sensors_read_every_device() {
+	addDevices(4);
+	addSensors();
+	run(SEC_TO_MLS(10));
+
+	for (uint8_t i = 0;i < devices_count;i++) {
+		TEST_ASSERT_EQUAL(0, sensors->getDS18B20Status(i));
+		TEST_ASSERT_INT_WITHIN(4, TEST_SENSORS_T + i * 100, sensors->getDS18B20TCenti(i));
+		TEST_ASSERT_EQUAL(12, devices[i]->getResolution());
+	}
+}
+
+void test_crc_error_is_counted_and_retried() {
+	addDevices(2);
+	addSensors();
+	sensors->setCrcPeriod(1);
+	run(SEC_TO_MLS(10));
+
+	uint32_t reads = devices[1]->scratchpad_reads;
+	devices[1]->breakCrc(1);
+	devices[1]->setT(3000);
+	run(SEC_TO_MLS(DEFAULT_READ_DATA_TIME));
+
+	// the retry on the next tick already has a valid crc
+	TEST_ASSERT_EQUAL(1, sensors->getDS18B20CrcErrors(1));
+	TEST_ASSERT_EQUAL(0, sensors->getDS18B20CrcErrors(0));
+	TEST_ASSERT_EQUAL(0, sensors->getDS18B20Status(1));
+	TEST_ASSERT_EQUAL_INT16(3000, sensors->getDS18B20TCenti(1));
+	TEST_ASSERT_EQUAL(reads + 2, devices[1]->scratchpad_reads);
+}
+
+void test_disconnect_and_return() {
+	addDevices(2);
+	addSensors();
+	run(SEC_TO_MLS(10));
+
+	devices[0]->setConnected(false);
+	run(SEC_TO_MLS(DEFAULT_READ_DATA_TIME * 2));
+
+	TEST_ASSERT_EQUAL(DS18B20_STATUS_DISCONNECTED, sensors->getDS18B20Status(0));
+	TEST_ASSERT_EQUAL(0, sensors->getDS18B20Status(1));
+
+	// the next discovery round logs the missing device
+	run(MIN_TO_MLS(DS18B20_SEARCH_TIME));
+	TEST_ASSERT_EQUAL(DS18B20_BUS_EVENT_MISSING, sensors->getDS18B20BusEvent(0)->type);
+
+	devices[0]->setConnected(true);
+	run(MIN_TO_MLS(DS18B20_SEARCH_TIME) + SEC_TO_MLS(DEFAULT_READ_DATA_TIME * 2));
+
+	TEST_ASSERT_EQUAL(0, sensors->getDS18B20Status(0));
+	TEST_ASSERT_INT_WITHIN(4, TEST_SENSORS_T, sensors->getDS18B20TCenti(0));
+}
+
+void test_power_on_reset_during_conversion() {
+	addDevices(1);
+	addSensors();
+	run(SEC_TO_MLS(10));
+
+	while (!devices[0]->isConverting()) {
+		run(TEST_LOOP_TIME);
+	}
+
+	// a brown-out loses the conversion, the scratchpad holds 85° again
+	devices[0]->powerOn();
+	run(SEC_TO_MLS(1));
+	TEST_ASSERT_EQUAL(DS18B20_STATUS_POWER_ON, sensors->getDS18B20Status(0));
+
+	run(SEC_TO_MLS(DEFAULT_READ_DATA_TIME * 2));
+	TEST_ASSERT_EQUAL(0, sensors->getDS18B20Status(0));
+}
+
+// a resolution reaches the scratchpad right away, the eeprom only on a user save
+void test_resolution_is_saved_on_request() {
+	addDevices(2);
+	addSensors();
+	run(SEC_TO_MLS(10));
+
+	sensors->setDS18B20Resolution(0, 10);
+	sensors->setDS18B20AutoResolutionFlag(1, true); // 9 bit, no control uses it
+	run(SEC_TO_MLS(DEFAULT_READ_DATA_TIME * 2));
+
+	TEST_ASSERT_EQUAL(10, devices[0]->getResolution());
+	TEST_ASSERT_EQUAL(9, devices[1]->getResolution());
+	TEST_ASSERT_EQUAL(0, devices[0]->eeprom_writes);
+	TEST_ASSERT_EQUAL(0, devices[1]->eeprom_writes);
+
+	sensors->saveDS18B20Config();
+	run(SEC_TO_MLS(DEFAULT_READ_DATA_TIME * 2));
+
+	TEST_ASSERT_EQUAL(1, devices[0]->eeprom_writes);
+	TEST_ASSERT_EQUAL(10, devices[0]->getEepromResolution());
+	TEST_ASSERT_EQUAL(0, devices[1]->eeprom_writes);
+
+	// nothing new to copy
+	sensors->saveDS18B20Config();
+	run(SEC_TO_MLS(DEFAULT_READ_DATA_TIME * 2));
+	TEST_ASSERT_EQUAL(1, devices[0]->eeprom_writes);
+
+	// the saved resolution survives a power cycle
+	devices[0]->powerOn();
+	TEST_ASSERT_EQUAL(10, devices[0]->getResolution());
+
+	for (uint8_t i = 0;i < devices_count;i++) {
+		TEST_ASSERT_EQUAL(0, sensors->getDS18B20Status(i));
+	}
+}
+
+// the power supply of a new device is read over the ticks of the search, the library follows the bus
+void test_parasite_device_is_found() {
+	addDevices(2);
+	addSensors();
+	run(SEC_TO_MLS(10));
+	TEST_ASSERT_FALSE(sensors->getDallasTemperature()->isParasitePowerMode());
+
+	addDevices(1);
+	devices[2]->setParasite(true);
+	sensors->resetStats();
+	run(MIN_TO_MLS(DS18B20_SEARCH_TIME) + SEC_TO_MLS(10));
+
+	TEST_ASSERT_EQUAL(3, sensors->getGlobalDS18B20Count());
+	TEST_ASSERT_TRUE(sensors->getDallasTemperature()->isParasitePowerMode());
+	TEST_ASSERT_LESS_OR_EQUAL(DS18B20_TRANSFER_BYTES * 8 * FAKE_ONEWIRE_SLOT_TIME, sensors->getTickTimeMax());
+
+	for (uint8_t i = 0;i < sensors->getGlobalDS18B20Count();i++) {
+		ds18b20_bus_device_t* device = sensors->getGlobalDS18B20(i);
+		TEST_ASSERT_EQUAL(!memcmp(device->address, devices[2]->rom, 8), device->parasite_flag);
+	}
+
+	bus->remove(devices[2]);
+	run(MIN_TO_MLS(DS18B20_SEARCH_TIME) + SEC_TO_MLS(10));
+	TEST_ASSERT_FALSE(sensors->getDallasTemperature()->isParasitePowerMode());
+
+	for (uint8_t i = 0;i < 2;i++) {
+		TEST_ASSERT_EQUAL(0, sensors->getDS18B20Status(i));
+	}
+}
+
+// the settings screen asks by address, the answer comes from the caches without bus traffic
+void test_t_by_address_does_not_block() {
+	addDevices(2);
+	sensors->begin();
+	sensors->addDS18B20();
+	sensors->setDS18B20Address(0, devices[0]->rom);
+	run(MIN_TO_MLS(DS18B20_SEARCH_TIME));
+
+	DeviceAddress unknown = {0x28, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07};
+	uint32_t slots = bus->slots;
+	uint64_t timer = mock::clock;
+
+	TEST_ASSERT_INT_WITHIN(4, TEST_SENSORS_T, sensors->getDS18B20TByAddress(devices[0]->rom));
+	TEST_ASSERT_INT_WITHIN(4, TEST_SENSORS_T + 100, sensors->getDS18B20TByAddress(devices[1]->rom));
+	TEST_ASSERT_EQUAL_INT16(DS18B20_DISCONNECTED_T, sensors->getDS18B20TByAddress(unknown));
+	TEST_ASSERT_EQUAL(slots, bus->slots);
+	TEST_ASSERT_TRUE(timer == mock::clock);
+
+	devices[0]->setConnected(false);
+	run(SEC_TO_MLS(DEFAULT_READ_DATA_TIME * 2));
+	TEST_ASSERT_EQUAL_INT16(DS18B20_DISCONNECTED_T, sensors->getDS18B20TByAddress(devices[0]->rom));
+}
+
+void test_benchmark() {
+	static const uint8_t counts[] = {1, 4, DS_SENSORS_MAX_COUNT};
+
+	for (uint8_t count : counts) {
+		tearDown();
+		setUp();
+
+		addDevices(count);
+		for (uint8_t i = 0;i < devices_count;i++) {
+			devices[i]->setTrajectory(rampTrajectory);
+		}
+
+		addSensors();
+		run(SEC_TO_MLS(10));
+
+		sensors->resetStats();
+		bus->resetStats();
+		uint64_t timer = mock::clock;
+		run(MIN_TO_MLS(5));
+
+		char message[160];
+		uint32_t time = (mock::clock - timer) / 1000000;
+
+		snprintf(message, sizeof(message), "%u sensors: tick %u mcs average, %u mcs max, %u transactions/min, bus busy %u%%",
+			count, sensors->getTickTimeAverage(), sensors->getTickTimeMax(), sensors->getOneWireTransactions() / 5,
+			(uint32_t) (bus->time / 10000 / time));
+		TEST_MESSAGE(message);
+
+		for (uint8_t i = 0;i < devices_count;i++) {
+			TEST_ASSERT_EQUAL(0, sensors->getDS18B20Status(i));
+			TEST_ASSERT_INT_WITHIN(5 * DEFAULT_READ_DATA_TIME + 4, rampTrajectory(millis()), sensors->getDS18B20TCenti(i));
+		}
+	}
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_search_finds_every_rom);
+	RUN_TEST(test_alarm_search_finds_only_alarmed_devices);
+	RUN_TEST(test_conversion_time_follows_resolution);
+	RUN_TEST(test_power_on_value);
+	RUN_TEST(test_sensors_read_every_device);
+	RUN_TEST(test_crc_error_is_counted_and_retried);
+	RUN_TEST(test_disconnect_and_return);
+	RUN_TEST(test_power_on_reset_during_conversion);
+	RUN_TEST(test_resolution_is_saved_on_request);
+	RUN_TEST(test_parasite_device_is_found);
+	RUN_TEST(test_t_by_address_does_not_block);
+	RUN_TEST(test_benchmark);
+
+	return UNITY_END();
+}
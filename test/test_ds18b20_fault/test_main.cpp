@@ -0,0 +1,142 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * DS18B20 fault checks of a sensor pair. The blame must not depend on which member is
+ * read first: a plain disagreement flags both, a member failing its own rate check is
+ * the only one flagged.
+ */
+
+#include <unity.h>
+#include "data.h"
+
+#define TEST_LOOP_TIME 1 // mls between two ticks of the main loop
+#define TEST_T 2000 // c°
+#define TEST_PAIR_DELTA 2 // °
+
+SystemManager systemManager;
+
+static FakeOneWireBus* bus;
+static FakeDS18B20* devices[2];
+static SensorsManager* sensors;
+
+void setUp() {
+	mock::reset();
+
+	bus = new FakeOneWireBus(DS18B20_PORT);
+	sensors = new SensorsManager();
+	sensors->setSystemManager(&systemManager);
+	sensors->begin();
+
+	for (uint8_t i = 0;i < 2;i++) {
+		devices[i] = new FakeDS18B20(0xFA170 + i * 0x1111, TEST_T);
+		bus->add(devices[i]);
+
+		sensors->addDS18B20();
+		sensors->setDS18B20Address(i, devices[i]->rom);
+	}
+
+	sensors->setDS18B20Pair(0, 1);
+	sensors->setDS18B20Pair(1, 0);
+	sensors->setFaultPairDelta(TEST_PAIR_DELTA);
+}
+
+void tearDown() {
+	delete sensors;
+
+	for (uint8_t i = 0;i < 2;i++) {
+		delete devices[i];
+	}
+
+	delete bus;
+}
+
+// both sensors are read in the same cycle, the first index first
+static void publish() {
+	sensor_sample_t* sample = sensors->getSample(SENSOR_SOURCE_DS18B20 + 1);
+	uint32_t time = sample->time;
+
+	while (sample->time == time) {
+		sensors->tick();
+		mock::advance(TEST_LOOP_TIME * 1000);
+	}
+}
+
+static void settle() {
+	for (uint8_t i = 0;i < 3;i++) {
+		publish();
+	}
+
+	TEST_ASSERT_EQUAL(0, sensors->getDS18B20Status(0));
+	TEST_ASSERT_EQUAL(0, sensors->getDS18B20Status(1));
+}
+
+static void checkDisagreement(uint8_t index) {
+	settle();
+
+	devices[index]->setT(TEST_T + TEST_PAIR_DELTA * 100 + 100);
+	publish();
+	publish();
+
+	TEST_ASSERT_EQUAL(DS18B20_STATUS_PAIR, sensors->getDS18B20Status(0));
+	TEST_ASSERT_EQUAL(DS18B20_STATUS_PAIR, sensors->getDS18B20Status(1));
+
+	// the flags go away with the next agreeing samples
+	devices[index]->setT(TEST_T);
+	publish();
+	publish();
+
+	TEST_ASSERT_EQUAL(0, sensors->getDS18B20Status(0));
+	TEST_ASSERT_EQUAL(0, sensors->getDS18B20Status(1));
+}
+
+static void checkJump(uint8_t index) {
+	sensors->setFaultRate(10);
+	settle();
+
+	// 30° within one sample period is far beyond 10°/min
+	devices[index]->setT(TEST_T + 3000);
+	publish();
+
+	TEST_ASSERT_EQUAL(DS18B20_STATUS_RATE, sensors->getDS18B20Status(index));
+	TEST_ASSERT_EQUAL(0, sensors->getDS18B20Status(!index));
+}
+
+
+void test_disagreement_flags_both_first_read() {
+	checkDisagreement(0);
+}
+
+void test_disagreement_flags_both_second_read() {
+	checkDisagreement(1);
+}
+
+void test_jump_blames_only_the_jumper_first_read() {
+	checkJump(0);
+}
+
+void test_jump_blames_only_the_jumper_second_read() {
+	checkJump(1);
+}
+
+void test_agreement_within_delta() {
+	settle();
+
+	devices[0]->setT(TEST_T + TEST_PAIR_DELTA * 100 - 100);
+	publish();
+	publish();
+
+	TEST_ASSERT_EQUAL(0, sensors->getDS18B20Status(0));
+	TEST_ASSERT_EQUAL(0, sensors->getDS18B20Status(1));
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_disagreement_flags_both_first_read);
+	RUN_TEST(test_disagreement_flags_both_second_read);
+	RUN_TEST(test_jump_blames_only_the_jumper_first_read);
+	RUN_TEST(test_jump_blames_only_the_jumper_second_read);
+	RUN_TEST(test_agreement_within_delta);
+
+	return UNITY_END();
+}
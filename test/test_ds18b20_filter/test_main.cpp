@@ -0,0 +1,179 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * DS18B20 sample filters: the median window, the slew limit and the EMA, alone and
+ * chained, against a reference model of the published values.
+ */
+
+#include <unity.h>
+#include "data.h"
+
+#define TEST_LOOP_TIME 1 // mls between two ticks of the main loop
+#define TEST_T 2000 // c°, the samples are multiples of 6.25 c°, the 12 bit step
+
+SystemManager systemManager;
+
+static FakeOneWireBus* bus;
+static FakeDS18B20* device;
+static SensorsManager* sensors;
+
+void setUp() {
+	mock::reset();
+
+	bus = new FakeOneWireBus(DS18B20_PORT);
+	device = new FakeDS18B20(0xF1170, TEST_T);
+	bus->add(device);
+
+	sensors = new SensorsManager();
+	sensors->setSystemManager(&systemManager);
+	sensors->begin();
+	sensors->addDS18B20();
+	sensors->setDS18B20Address(0, device->rom);
+}
+
+void tearDown() {
+	delete sensors;
+	delete device;
+	delete bus;
+}
+
+// the next published sample, the conversion after the call sees the new t
+static int16_t publish(int16_t t) {
+	sensor_sample_t* sample = sensors->getSample(SENSOR_SOURCE_DS18B20);
+	uint32_t time = sample->time;
+
+	device->setT(t);
+
+	while (sample->time == time) {
+		sensors->tick();
+		mock::advance(TEST_LOOP_TIME * 1000);
+	}
+
+	TEST_ASSERT_EQUAL(0, sensors->getDS18B20Status(0));
+	TEST_ASSERT_EQUAL_INT16(t, sensors->getDS18B20RawTCenti(0));
+
+	return sample->value;
+}
+
+// the first sample has no history, then the filter starts from a settled value
+static void settle(uint8_t count) {
+	for (uint8_t i = 0;i < count;i++) {
+		TEST_ASSERT_EQUAL_INT16(TEST_T, publish(TEST_T));
+	}
+}
+
+
+void test_filters_off_pass_samples() {
+	static const int16_t values[] = {2000, 2600, -550, 9000, 2025};
+
+	for (int16_t t : values) {
+		TEST_ASSERT_EQUAL_INT16(t, publish(t));
+	}
+}
+
+void test_median_drops_one_spike() {
+	sensors->setDS18B20FilterMedian(0, 3);
+	settle(3);
+
+	TEST_ASSERT_EQUAL_INT16(TEST_T, publish(TEST_T + 600));
+	TEST_ASSERT_EQUAL_INT16(TEST_T, publish(TEST_T));
+	TEST_ASSERT_EQUAL_INT16(TEST_T, publish(TEST_T - 600));
+	TEST_ASSERT_EQUAL_INT16(TEST_T, publish(TEST_T));
+}
+
+// a step passes after half the window
+void test_median_follows_a_step() {
+	sensors->setDS18B20FilterMedian(0, DS18B20_FILTER_MEDIAN_MAX);
+	settle(DS18B20_FILTER_MEDIAN_MAX);
+
+	for (uint8_t i = 0;i < DS18B20_FILTER_MEDIAN_MAX / 2;i++) {
+		TEST_ASSERT_EQUAL_INT16(TEST_T, publish(TEST_T + 500));
+	}
+
+	TEST_ASSERT_EQUAL_INT16(TEST_T + 500, publish(TEST_T + 500));
+}
+
+// the window grows with the history, the first samples are not held back
+void test_median_window_starts_short() {
+	sensors->setDS18B20FilterMedian(0, 3);
+
+	TEST_ASSERT_EQUAL_INT16(TEST_T, publish(TEST_T));
+	TEST_ASSERT_EQUAL_INT16(TEST_T + 300, publish(TEST_T + 300)); // the upper of two
+	TEST_ASSERT_EQUAL_INT16(TEST_T + 300, publish(TEST_T + 300));
+}
+
+void test_slew_limits_the_rate() {
+	sensor_sample_t* sample = sensors->getSample(SENSOR_SOURCE_DS18B20);
+	int16_t output = TEST_T;
+
+	sensors->setDS18B20FilterSlew(0, 10); // 1°/sec
+	settle(1);
+
+	for (uint8_t i = 0;output != TEST_T + 3000;i++) {
+		uint32_t time = sample->time;
+		int16_t t = publish(TEST_T + 3000);
+		int32_t step = 10 * (sample->time - time) / 100;
+
+		TEST_ASSERT_TRUE(i < 10);
+		TEST_ASSERT_EQUAL_INT16(min(output + step, TEST_T + 3000), t);
+		output = t;
+	}
+
+	// both directions, a small change is not delayed
+	TEST_ASSERT_EQUAL_INT16(TEST_T + 2975, publish(TEST_T + 2975));
+	TEST_ASSERT_TRUE(publish(TEST_T) > TEST_T);
+}
+
+// alpha 1/4 against the floating point recurrence
+void test_ema_follows_the_recurrence() {
+	double ema = TEST_T;
+
+	sensors->setDS18B20FilterEma(0, 2);
+	settle(1);
+
+	for (uint8_t i = 0;i < 40;i++) {
+		ema += (TEST_T + 1000 - ema) / 4;
+		TEST_ASSERT_INT_WITHIN(1, (int32_t) round(ema), publish(TEST_T + 1000));
+	}
+
+	TEST_ASSERT_EQUAL_INT16(TEST_T + 1000, publish(TEST_T + 1000));
+}
+
+void test_ema_starts_from_the_first_sample() {
+	sensors->setDS18B20FilterEma(0, DS18B20_FILTER_EMA_MAX);
+
+	TEST_ASSERT_EQUAL_INT16(-1025, publish(-1025));
+}
+
+// median, then slew, then ema, the spike never reaches the later stages
+void test_chain_order() {
+	sensors->setDS18B20FilterMedian(0, 3);
+	sensors->setDS18B20FilterSlew(0, 1);
+	sensors->setDS18B20FilterEma(0, 1);
+	settle(3);
+
+	TEST_ASSERT_EQUAL_INT16(TEST_T, publish(TEST_T + 5000));
+	TEST_ASSERT_EQUAL_INT16(TEST_T, publish(TEST_T));
+
+	// a lasting step is limited to 0.1°/sec before the ema halves it
+	publish(TEST_T + 5000);
+	int16_t t = publish(TEST_T + 5000);
+
+	TEST_ASSERT_TRUE(t > TEST_T);
+	TEST_ASSERT_TRUE(t <= TEST_T + DEFAULT_READ_DATA_TIME * 10 + 1);
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_filters_off_pass_samples);
+	RUN_TEST(test_median_drops_one_spike);
+	RUN_TEST(test_median_follows_a_step);
+	RUN_TEST(test_median_window_starts_short);
+	RUN_TEST(test_slew_limits_the_rate);
+	RUN_TEST(test_ema_follows_the_recurrence);
+	RUN_TEST(test_ema_starts_from_the_first_sample);
+	RUN_TEST(test_chain_order);
+
+	return UNITY_END();
+}
@@ -0,0 +1,186 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * Tick latency of the DS18B20 pipeline. Every OneWire exchange is split into steps of
+ * DS18B20_TRANSFER_BYTES, a tick must not keep the wire longer than that per bus, from the
+ * first tick on, with discovery, config writes, alarm arming and alarm searches running in
+ * between.
+ */
+
+#include <unity.h>
+#include "data.h"
+
+#define TEST_LOOP_TIME 1 // mls between two ticks of the main loop
+#define TEST_SENSORS_T 2150 // c°, + 100 per sensor
+#define TEST_BUS_PORT D3 // the second bus
+#define TEST_TICK_BOUND (DS18B20_TRANSFER_BYTES * 8 * FAKE_ONEWIRE_SLOT_TIME) // mcs per bus
+
+SystemManager systemManager;
+
+static FakeOneWireBus* buses[DS18B20_BUS_COUNT];
+static FakeDS18B20* devices[DS_SENSORS_MAX_COUNT];
+static uint8_t devices_count;
+static SensorsManager* sensors;
+
+void setUp() {
+	mock::reset();
+
+	buses[0] = new FakeOneWireBus(DS18B20_PORT);
+	buses[1] = new FakeOneWireBus(TEST_BUS_PORT);
+	devices_count = 0;
+	sensors = new SensorsManager();
+	sensors->setSystemManager(&systemManager);
+}
+
+void tearDown() {
+	delete sensors;
+
+	for (uint8_t i = 0;i < devices_count;i++) {
+		delete devices[i];
+	}
+
+	for (uint8_t i = 0;i < DS18B20_BUS_COUNT;i++) {
+		delete buses[i];
+	}
+}
+
+// sensors alternate between the buses when both are used
+static void addSensor(uint8_t bus_count) {
+	uint8_t i = devices_count;
+	uint8_t bus = i % bus_count;
+
+	devices[devices_count] = new FakeDS18B20(0xB7000 + i * 0x1111, TEST_SENSORS_T + i * 100);
+	buses[bus]->add(devices[devices_count++]);
+
+	sensors->addDS18B20();
+	sensors->setDS18B20Bus(i, bus);
+	sensors->setDS18B20Address(i, devices[i]->rom);
+}
+
+static void addSensors(uint8_t count, uint8_t bus_count) {
+	sensors->begin();
+
+	if (bus_count > 1) {
+		sensors->setDS18B20BusPort(1, TEST_BUS_PORT);
+	}
+
+	for (uint8_t i = 0;i < count;i++) {
+		addSensor(bus_count);
+	}
+}
+
+static void run(uint32_t time) {
+	uint64_t end = mock::clock + (uint64_t) time * 1000;
+
+	while (mock::clock < end) {
+		sensors->tick();
+		mock::advance(TEST_LOOP_TIME * 1000);
+	}
+}
+
+// two discovery rounds, the readout of every sensor and the bound of the slowest tick since the start
+static void checkTickBound(uint8_t bus_count) {
+	run(MIN_TO_MLS(DS18B20_SEARCH_TIME * 2));
+
+	char message[96];
+	snprintf(message, sizeof(message), "%u sensors on %u buses: tick %u mcs max", devices_count, bus_count, sensors->getTickTimeMax());
+	TEST_MESSAGE(message);
+
+	TEST_ASSERT_LESS_OR_EQUAL(TEST_TICK_BOUND * bus_count, sensors->getTickTimeMax());
+
+	for (uint8_t i = 0;i < devices_count;i++) {
+		TEST_ASSERT_EQUAL(0, sensors->getDS18B20Status(i));
+		TEST_ASSERT_INT_WITHIN(4, TEST_SENSORS_T + i * 100, sensors->getDS18B20TCenti(i));
+	}
+}
+
+static void checkTickBound(uint8_t count, uint8_t bus_count) {
+	addSensors(count, bus_count);
+	checkTickBound(bus_count);
+}
+
+
+void test_one_sensor() {
+	checkTickBound(1, 1);
+}
+
+void test_ten_sensors() {
+	checkTickBound(DS_SENSORS_MAX_COUNT, 1);
+}
+
+void test_two_buses() {
+	checkTickBound(DS_SENSORS_MAX_COUNT, DS18B20_BUS_COUNT);
+}
+
+// arming writes th/tl to every sensor, the conversions end with an alarm search
+void test_alarm_band() {
+	sensors->setAlarmBand(1);
+	checkTickBound(DS_SENSORS_MAX_COUNT, DS18B20_BUS_COUNT);
+
+	for (uint8_t i = 0;i < devices_count;i++) {
+		TEST_ASSERT_TRUE(devices[i]->scratchpad_writes > 0);
+	}
+}
+
+// one sensor and then the whole bus change resolution, a save copies them to the eeprom
+void test_resolution_change() {
+	addSensors(DS_SENSORS_MAX_COUNT, DS18B20_BUS_COUNT);
+	run(SEC_TO_MLS(DEFAULT_READ_DATA_TIME * 2));
+
+	sensors->setDS18B20Resolution(0, 10);
+	run(SEC_TO_MLS(DEFAULT_READ_DATA_TIME * 2));
+	TEST_ASSERT_EQUAL(10, devices[0]->getResolution());
+
+	// a SKIP ROM write on the first bus
+	for (uint8_t i = 0;i < devices_count;i += DS18B20_BUS_COUNT) {
+		sensors->setDS18B20Resolution(i, 11);
+	}
+
+	sensors->saveDS18B20Config();
+	checkTickBound(DS18B20_BUS_COUNT);
+
+	for (uint8_t i = 0;i < devices_count;i++) {
+		TEST_ASSERT_EQUAL((i % DS18B20_BUS_COUNT) ? 12 : 11, devices[i]->getResolution());
+		TEST_ASSERT_EQUAL(1, devices[i]->eeprom_writes);
+	}
+}
+
+// the new device is found, checked for its power supply and configured
+void test_device_appears() {
+	addSensors(DS_SENSORS_MAX_COUNT - 1, DS18B20_BUS_COUNT);
+	run(SEC_TO_MLS(DEFAULT_READ_DATA_TIME * 2));
+
+	addSensor(DS18B20_BUS_COUNT);
+	sensors->setDS18B20Resolution(devices_count - 1, 9);
+	checkTickBound(DS18B20_BUS_COUNT);
+
+	TEST_ASSERT_EQUAL(DS_SENSORS_MAX_COUNT, sensors->getGlobalDS18B20Count());
+	TEST_ASSERT_EQUAL(9, devices[devices_count - 1]->getResolution());
+}
+
+// a transfer resumed over the ticks reads the same scratchpad as a single exchange
+void test_split_read_matches_device() {
+	addSensors(1, 1);
+	run(SEC_TO_MLS(DEFAULT_READ_DATA_TIME * 2));
+
+	devices[0]->setT(-1062);
+	run(SEC_TO_MLS(DEFAULT_READ_DATA_TIME * 2));
+
+	TEST_ASSERT_EQUAL(0, sensors->getDS18B20Status(0));
+	TEST_ASSERT_INT_WITHIN(4, -1062, sensors->getDS18B20TCenti(0));
+	TEST_ASSERT_EQUAL(0, sensors->getDS18B20CrcErrors(0));
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_one_sensor);
+	RUN_TEST(test_ten_sensors);
+	RUN_TEST(test_two_buses);
+	RUN_TEST(test_alarm_band);
+	RUN_TEST(test_resolution_change);
+	RUN_TEST(test_device_appears);
+	RUN_TEST(test_split_read_matches_device);
+
+	return UNITY_END();
+}
@@ -0,0 +1,161 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * Heat counting of a pump run. The real SensorsManager and SolarSystemManager run without
+ * a flow meter, so the meter ticks only with the samples, at the configured, the slowest or
+ * the adaptive read interval. ΔT × flow × capacity over the run must give the expected Wh,
+ * and the day and month counters must restart at midnight.
+ */
+
+#include <unity.h>
+#include "data.h"
+
+#define TEST_LOOP_TIME 10 // mls between two ticks of the main loop
+#define TEST_BATTERY_T 6000 // c°
+#define TEST_BOILER_T 3000 // c°
+#define TEST_EXIT_T 5000 // c°
+#define TEST_RUN_TIME 60 // min
+#define TEST_READ_TIME_MAX 100 // sec
+
+SystemManager systemManager;
+
+static FakeOneWireBus* bus;
+static FakeDS18B20* devices[3]; // battery, boiler, exit
+static SensorsManager* sensors;
+static SolarSystemManager* solar;
+static EnergyMeter* energy;
+
+void setUp() {
+	mock::reset();
+	LittleFS.format();
+
+	bus = new FakeOneWireBus(DS18B20_PORT);
+	devices[0] = new FakeDS18B20(0xF0EA0, TEST_BATTERY_T);
+	devices[1] = new FakeDS18B20(0xF0EB1, TEST_BOILER_T);
+	devices[2] = new FakeDS18B20(0xF0EC2, TEST_EXIT_T);
+
+	for (uint8_t i = 0;i < 3;i++) {
+		bus->add(devices[i]);
+	}
+
+	systemManager.makeDefault();
+	systemManager.getTimeManager()->makeDefault();
+	systemManager.getSensorsManager()->makeDefault();
+	systemManager.getSolarSystemManager()->makeDefault();
+	systemManager.begin();
+
+	sensors = systemManager.getSensorsManager();
+	solar = systemManager.getSolarSystemManager();
+	energy = solar->getEnergyMeter();
+
+	for (uint8_t i = 0;i < 3;i++) {
+		sensors->addDS18B20();
+		sensors->setDS18B20Address(i, devices[i]->rom);
+	}
+
+	solar->setWorkFlag(true);
+	solar->setBatterySensor(0);
+	solar->setBoilerSensor(1);
+	solar->setExitSensor(2);
+}
+
+void tearDown() {
+	for (uint8_t i = 0;i < 3;i++) {
+		delete devices[i];
+	}
+
+	delete bus;
+}
+
+static void run(uint32_t time) {
+	uint64_t end = mock::clock + (uint64_t) time * 1000;
+
+	while (mock::clock < end) {
+		sensors->tick();
+		solar->tick();
+		mock::advance(TEST_LOOP_TIME * 1000);
+	}
+}
+
+// W of the nominal pump flow, centi K * centi l/min * J/(l·K) / 6000
+static uint32_t getExpectedPower() {
+	return (uint64_t) (TEST_EXIT_T - TEST_BOILER_T) * DEFAULT_ENERGY_FLOW * DEFAULT_ENERGY_CAPACITY / 600000;
+}
+
+// the pump runs from the start, the heat counts from the first sample to the last one
+static void checkRun(uint32_t read_interval) {
+	uint32_t expected = (uint64_t) getExpectedPower() * MIN_TO_MLS(TEST_RUN_TIME) / 3600000;
+	uint32_t tolerance = (uint64_t) getExpectedPower() * read_interval / 3600000 + 1;
+
+	run(MIN_TO_MLS(TEST_RUN_TIME));
+
+	TEST_ASSERT_TRUE(solar->getReleFlag());
+	TEST_ASSERT_EQUAL(0, solar->getStatus());
+	TEST_ASSERT_EQUAL_UINT32(getExpectedPower(), energy->getPower());
+	TEST_ASSERT_UINT32_WITHIN(tolerance, expected, energy->getLifetime());
+}
+
+
+void test_default_read_time() {
+	checkRun(SEC_TO_MLS(DEFAULT_READ_DATA_TIME));
+}
+
+// every step is longer than ENERGY_STEP_MAX
+void test_slowest_read_time() {
+	sensors->setReadDataTime(TEST_READ_TIME_MAX);
+
+	checkRun(SEC_TO_MLS(TEST_READ_TIME_MAX));
+	TEST_ASSERT_TRUE(sensors->getDS18B20ReadInterval(0) > ENERGY_STEP_MAX);
+}
+
+// steady temperatures stretch the interval to its widest
+void test_adaptive_read_time() {
+	sensors->setReadDataTime(20);
+
+	for (uint8_t i = 0;i < 3;i++) {
+		sensors->setDS18B20AdaptiveFlag(i, true);
+	}
+
+	checkRun(SEC_TO_MLS(20 * DS18B20_ADAPTIVE_MAX_RATIO));
+	TEST_ASSERT_EQUAL_UINT32(SEC_TO_MLS(20 * DS18B20_ADAPTIVE_MAX_RATIO), sensors->getDS18B20ReadInterval(0));
+}
+
+// half of the run before midnight, the month goes on
+void test_day_rollover() {
+	uint32_t half = (uint64_t) getExpectedPower() * MIN_TO_MLS(TEST_RUN_TIME / 2) / 3600000;
+	uint32_t tolerance = (uint64_t) getExpectedPower() * SEC_TO_MLS(DEFAULT_READ_DATA_TIME) / 3600000 + 1;
+
+	systemManager.getTimeManager()->setTime(23, 60 - TEST_RUN_TIME / 2, 0, 14, 6, 2026);
+	run(MIN_TO_MLS(TEST_RUN_TIME));
+
+	TEST_ASSERT_EQUAL_UINT32(20260615, energy->getDate());
+	TEST_ASSERT_UINT32_WITHIN(1, half, energy->getDay());
+	TEST_ASSERT_UINT32_WITHIN(tolerance, half * 2, energy->getMonth());
+	TEST_ASSERT_EQUAL_UINT32(energy->getMonth(), energy->getLifetime());
+}
+
+// the last day of a month, both counters restart
+void test_month_rollover() {
+	uint32_t half = (uint64_t) getExpectedPower() * MIN_TO_MLS(TEST_RUN_TIME / 2) / 3600000;
+	uint32_t tolerance = (uint64_t) getExpectedPower() * SEC_TO_MLS(DEFAULT_READ_DATA_TIME) / 3600000 + 1;
+
+	systemManager.getTimeManager()->setTime(23, 60 - TEST_RUN_TIME / 2, 0, 31, 5, 2026);
+	run(MIN_TO_MLS(TEST_RUN_TIME));
+
+	TEST_ASSERT_EQUAL_UINT32(20260601, energy->getDate());
+	TEST_ASSERT_UINT32_WITHIN(1, half, energy->getDay());
+	TEST_ASSERT_UINT32_WITHIN(1, half, energy->getMonth());
+	TEST_ASSERT_UINT32_WITHIN(tolerance, half * 2, energy->getLifetime());
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_default_read_time);
+	RUN_TEST(test_slowest_read_time);
+	RUN_TEST(test_adaptive_read_time);
+	RUN_TEST(test_day_rollover);
+	RUN_TEST(test_month_rollover);
+
+	return UNITY_END();
+}
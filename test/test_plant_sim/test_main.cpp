@@ -0,0 +1,244 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * Closed loop regression over simulated days. A thermal model of the collector, the boiler
+ * and the exit pipe drives three fake DS18B20 sensors, the real SensorsManager and
+ * SolarSystemManager run on the mocked clock in real time, the model reads the pump back
+ * from the relay. The pump starts, the harvested heat and the boiler comfort are checked
+ * with the default settings against the same plant under an ideal pump.
+ */
+
+#include <unity.h>
+#include "data.h"
+
+#define TEST_LOOP_TIME 10 // mls between two ticks of the main loop
+#define TEST_STEP_TIME 10 // sec, one integration step of the model
+#define TEST_DAYS_COUNT 7 // a week of clear, cloudy and mixed days
+#define TEST_ENERGY_RATIO 0.9 // of the ideal pump, 0.95 on the cloudiest day
+#define TEST_COLD_EXCESS 180 // min over the ideal pump, 155 on the worst day
+#define TEST_HOT_EXCESS 0 // min over the ideal pump
+#define TEST_CYCLES_MAX 80 // starts per day, 61 on the cloudiest day
+#define TEST_NIGHT_PUMP_MAX 30 // min
+
+#define TEST_COLLECTOR_AREA 4.0 // m²
+#define TEST_COLLECTOR_EFFICIENCY 0.6
+#define TEST_COLLECTOR_CAPACITY 40000.0 // J/K, absorber and fluid
+#define TEST_COLLECTOR_LOSS 8.0 // W/K
+#define TEST_BOILER_CAPACITY 837000.0 // J/K, 200 l
+#define TEST_BOILER_LOSS 2.0 // W/K
+#define TEST_BOILER_T 40.0 // °, at the start
+#define TEST_PUMP_RATE 200.0 // W/K, flow and exchanger
+#define TEST_PIPE_RUN_TIME 30.0 // sec, the exit follows the collector
+#define TEST_PIPE_IDLE_TIME 600.0 // sec, the exit cools down
+#define TEST_IRRADIANCE 800.0 // W/m², clear sky noon
+#define TEST_CLOUD_MIN 0.3 // of the clear sky
+#define TEST_AMBIENT_T 12.0 // °, daily mean
+#define TEST_AMBIENT_SWING 6.0 // °
+#define TEST_ROOM_T 20.0 // °
+#define TEST_DRAW_POWER 1500.0 // W, 07 - 08 and 19 - 21
+#define TEST_COLD_T 15.0 // °, mains water
+#define TEST_COMFORT_MIN 45.0 // °
+#define TEST_COMFORT_MAX 80.0 // °
+
+SystemManager systemManager;
+
+static FakeOneWireBus* bus;
+static FakeDS18B20* devices[3]; // collector, boiler, exit
+static SensorsManager* sensors;
+static SolarSystemManager* solar;
+
+struct plant_t {
+	uint32_t time; // sec from midnight of the first day
+	float cloud_ratio;
+	float collector_t;
+	float boiler_t;
+	float exit_t;
+};
+
+struct plant_day_t {
+	uint32_t cycles;
+	uint32_t pump_time; // sec
+	uint32_t night_pump_time; // sec, without sun
+	uint32_t cold_time; // sec, the boiler under the comfort band
+	uint32_t hot_time; // sec, the boiler over the comfort band
+	float energy; // kWh into the boiler
+	float boiler_max; // °
+};
+
+static plant_t plant;
+static plant_t ideal; // the same plant, the pump runs whenever the collector is warmer
+static plant_day_t days[TEST_DAYS_COUNT];
+static plant_day_t ideal_days[TEST_DAYS_COUNT];
+
+void setUp() {
+	mock::reset();
+	LittleFS.format();
+
+	bus = new FakeOneWireBus(DS18B20_PORT);
+
+	for (uint8_t i = 0;i < 3;i++) {
+		devices[i] = new FakeDS18B20(0xF5A00 + i * 0x1111, TEST_BOILER_T * 100);
+		bus->add(devices[i]);
+	}
+
+	systemManager.makeDefault();
+	systemManager.getTimeManager()->makeDefault();
+	systemManager.getSensorsManager()->makeDefault();
+	systemManager.getSolarSystemManager()->makeDefault();
+	systemManager.begin();
+	systemManager.getTimeManager()->setTime(0, 0, 0, 1, 6, 2026);
+
+	sensors = systemManager.getSensorsManager();
+	solar = systemManager.getSolarSystemManager();
+
+	for (uint8_t i = 0;i < 3;i++) {
+		sensors->addDS18B20();
+		sensors->setDS18B20Address(i, devices[i]->rom);
+	}
+
+	// the wiring of the plant, every control setting stays at its default
+	solar->setWorkFlag(true);
+	solar->setBatterySensor(0);
+	solar->setBoilerSensor(1);
+	solar->setExitSensor(2);
+
+	memset(&plant, 0, sizeof(plant_t));
+	plant.collector_t = TEST_AMBIENT_T;
+	plant.boiler_t = TEST_BOILER_T;
+	plant.exit_t = TEST_AMBIENT_T;
+	ideal = plant;
+
+	memset(days, 0, sizeof(days));
+	memset(ideal_days, 0, sizeof(ideal_days));
+}
+
+void tearDown() {
+	for (uint8_t i = 0;i < 3;i++) {
+		delete devices[i];
+	}
+
+	delete bus;
+}
+
+static float getHour(plant_t* plant) {
+	return (plant->time % 86400) / 3600.0;
+}
+
+static float getAmbientT(plant_t* plant) {
+	// the warmest hour is 15
+	return TEST_AMBIENT_T + TEST_AMBIENT_SWING * sin(2 * PI * (getHour(plant) - 9) / 24);
+}
+
+static float getIrradiance(plant_t* plant) {
+	if (getHour(plant) < 6 || getHour(plant) >= 18) {
+		return 0;
+	}
+
+	return TEST_IRRADIANCE * plant->cloud_ratio * sin(PI * (getHour(plant) - 6) / 12);
+}
+
+static bool isDrawTime(plant_t* plant) {
+	uint8_t hour = getHour(plant);
+
+	return hour == 7 || hour == 19 || hour == 20;
+}
+
+static void step(plant_t* plant, plant_day_t* days, bool pump_flag) {
+	plant_day_t* day = &days[plant->time / 86400];
+	float dt = TEST_STEP_TIME;
+
+	// every day gets its own clouds, the same ones in every run
+	uint32_t hash = (plant->time / 86400 + 1) * 2654435761UL;
+	plant->cloud_ratio = TEST_CLOUD_MIN + (1 - TEST_CLOUD_MIN) * (hash >> 16) / 65535.0;
+
+	float ambient_t = getAmbientT(plant);
+	float gain = getIrradiance(plant) * TEST_COLLECTOR_AREA * TEST_COLLECTOR_EFFICIENCY;
+	float heat = pump_flag ? TEST_PUMP_RATE * (plant->collector_t - plant->boiler_t) : 0; // W, a cold collector cools the boiler
+	float draw = (isDrawTime(plant) && plant->boiler_t > TEST_COLD_T) ? TEST_DRAW_POWER : 0;
+
+	plant->collector_t += (gain - TEST_COLLECTOR_LOSS * (plant->collector_t - ambient_t) - heat) * dt / TEST_COLLECTOR_CAPACITY;
+	plant->boiler_t += (heat - TEST_BOILER_LOSS * (plant->boiler_t - TEST_ROOM_T) - draw) * dt / TEST_BOILER_CAPACITY;
+
+	// the pipe follows the running water and cools down to the air when it stops
+	float ratio = dt / (pump_flag ? TEST_PIPE_RUN_TIME : TEST_PIPE_IDLE_TIME);
+	plant->exit_t += ((pump_flag ? plant->collector_t : ambient_t) - plant->exit_t) * min(ratio, (float) 1);
+
+	day->energy += heat * dt / 3600000.0;
+	day->boiler_max = max(day->boiler_max, plant->boiler_t);
+
+	if (pump_flag) {
+		day->pump_time += TEST_STEP_TIME;
+		day->night_pump_time += getIrradiance(plant) ? 0 : TEST_STEP_TIME;
+	}
+
+	if (plant->boiler_t < TEST_COMFORT_MIN) {
+		day->cold_time += TEST_STEP_TIME;
+	}
+
+	if (plant->boiler_t > TEST_COMFORT_MAX) {
+		day->hot_time += TEST_STEP_TIME;
+	}
+
+	plant->time += TEST_STEP_TIME;
+}
+
+// the controller runs every loop tick, the model once per step on the same clock
+static void run(uint8_t days_count) {
+	uint32_t cycles = solar->getReleDriver()->getCycles();
+
+	while (plant.time < days_count * 86400UL) {
+		for (uint32_t i = 0;i < SEC_TO_MLS(TEST_STEP_TIME);i += TEST_LOOP_TIME) {
+			sensors->tick();
+			solar->tick();
+			mock::advance(TEST_LOOP_TIME * 1000);
+		}
+
+		step(&plant, days, solar->getReleFlag());
+		step(&ideal, ideal_days, ideal.collector_t > ideal.boiler_t);
+
+		devices[0]->setT(plant.collector_t * 100);
+		devices[1]->setT(plant.boiler_t * 100);
+		devices[2]->setT(plant.exit_t * 100);
+
+		// a start is counted on the day it happens
+		days[(plant.time - 1) / 86400].cycles += solar->getReleDriver()->getCycles() - cycles;
+		cycles = solar->getReleDriver()->getCycles();
+	}
+}
+
+
+void test_days_with_default_settings() {
+	run(TEST_DAYS_COUNT);
+
+	for (uint8_t i = 0;i < TEST_DAYS_COUNT;i++) {
+		plant_day_t* day = &days[i];
+		char message[192];
+
+		snprintf(message, sizeof(message), "day %u: %u starts, pump %u min (%u at night), %.2f of %.2f kWh, boiler max %.1f°, cold %u of %u min, hot %u of %u min",
+			i + 1, day->cycles, day->pump_time / 60, day->night_pump_time / 60, day->energy, ideal_days[i].energy, day->boiler_max,
+			day->cold_time / 60, ideal_days[i].cold_time / 60, day->hot_time / 60, ideal_days[i].hot_time / 60);
+		TEST_MESSAGE(message);
+
+		// a working day without a chattering relay
+		TEST_ASSERT_TRUE(day->cycles >= 1);
+		TEST_ASSERT_LESS_OR_EQUAL(TEST_CYCLES_MAX, day->cycles);
+
+		// the heat the sun gave, not lost to the delays and the hysteresis
+		TEST_ASSERT_TRUE(day->energy >= ideal_days[i].energy * TEST_ENERGY_RATIO);
+		TEST_ASSERT_LESS_OR_EQUAL(ideal_days[i].cold_time / 60 + TEST_COLD_EXCESS, day->cold_time / 60);
+		TEST_ASSERT_LESS_OR_EQUAL(ideal_days[i].hot_time / 60 + TEST_HOT_EXCESS, day->hot_time / 60);
+
+		// the pump does not cool the boiler through a dark collector
+		TEST_ASSERT_LESS_OR_EQUAL(TEST_NIGHT_PUMP_MAX, day->night_pump_time / 60);
+	}
+
+	TEST_ASSERT_EQUAL(0, solar->getStatus());
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_days_with_default_settings);
+
+	return UNITY_END();
+}
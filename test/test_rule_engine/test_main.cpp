@@ -0,0 +1,372 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * RuleEngine against a reference interpreter. Random rules are compiled to the postfix
+ * code and compared with a recursive descent evaluation of the same text, the arithmetic
+ * saturates at the int32 range in both. The benchmark prints the cost of one rule.
+ */
+
+#include <unity.h>
+#include <chrono>
+#include "data.h"
+
+#define TEST_RULES_COUNT 5000
+#define TEST_DEPTH_MAX 3
+#define TEST_SENSORS_COUNT 4 // ds3 has failed
+#define TEST_BENCHMARK_COUNT 200000
+#define TEST_LONG_RULE "(ds0 - ds1) * 2.5 > ds2 + 1.5 || !rele0" // RULE_TEXT_SIZE - 1 characters
+
+SystemManager systemManager;
+
+static SensorsManager* sensors;
+static solar_snapshot_t snapshot;
+static rule_context_t context;
+static uint32_t seed;
+
+void setUp() {
+	static const int32_t values[TEST_SENSORS_COUNT] = {6512, -1025, 4000, 2500};
+
+	mock::reset();
+	sensors = new SensorsManager();
+	sensors->setSystemManager(&systemManager);
+
+	for (uint8_t i = 0;i < TEST_SENSORS_COUNT;i++) {
+		sensors->setSample(SENSOR_SOURCE_DS18B20 + i, SENSOR_TYPE_TEMPERATURE, values[i], (i == 3) ? DS18B20_STATUS_DISCONNECTED : 0);
+	}
+
+	memset(&snapshot, 0, sizeof(solar_snapshot_t));
+	snapshot.channels[0].rele_flag = true;
+
+	context = {sensors, &snapshot, 14, 35, true};
+	seed = 12345;
+}
+
+void tearDown() {
+	delete sensors;
+}
+
+
+// reference: a recursive descent over the text, every binary level on its own
+struct Reference {
+	const char* p;
+	bool failed; // a failed sensor or an unset clock, the rule does not fire
+
+	static int32_t saturate(int64_t value) {
+		return (value > INT32_MAX) ? INT32_MAX : (value < INT32_MIN) ? INT32_MIN : value;
+	}
+
+	void skip() {
+		while (*p == ' ') p++;
+	}
+
+	bool accept(const char* token) {
+		skip();
+
+		// '<' is not the start of '<=', '!' not of '!='
+		if (strncmp(p, token, strlen(token)) || (strlen(token) == 1 && p[1] == '=' && strchr("<>!", *token))) {
+			return false;
+		}
+
+		p += strlen(token);
+		return true;
+	}
+
+	int32_t primary() {
+		skip();
+
+		if (accept("(")) {
+			int32_t value = orLevel();
+			accept(")");
+			return value;
+		}
+
+		if (isdigit(*p)) {
+			int64_t value = strtol(p, (char**) &p, 10) * 100;
+
+			if (*p == '.') {
+				p++;
+				if (isdigit(*p)) value += (*p++ - '0') * 10;
+				if (isdigit(*p)) value += *p++ - '0';
+			}
+
+			return value;
+		}
+
+		if (accept("hour")) { failed |= !context.time_flag; return context.hour * 100; }
+		if (accept("minute")) { failed |= !context.time_flag; return context.minute * 100; }
+		if (accept("rele")) return snapshot.channels[strtol(p, (char**) &p, 10)].rele_flag ? RULE_TRUE : 0;
+
+		accept("ds");
+		sensor_sample_t* sample = sensors->getSample(SENSOR_SOURCE_DS18B20 + strtol(p, (char**) &p, 10));
+		failed |= sample->quality != 0;
+
+		return sample->value;
+	}
+
+	int32_t unary() {
+		if (accept("!")) return unary() ? 0 : RULE_TRUE;
+		if (accept("-")) return saturate(-(int64_t) unary());
+
+		return primary();
+	}
+
+	int32_t mulLevel() {
+		int32_t a = unary();
+
+		while (true) {
+			if (accept("*")) { int64_t b = unary(); a = saturate(a * b / 100); }
+			else if (accept("/")) { int64_t b = unary(); a = b ? saturate((int64_t) a * 100 / b) : 0; }
+			else return a;
+		}
+	}
+
+	int32_t addLevel() {
+		int32_t a = mulLevel();
+
+		while (true) {
+			if (accept("+")) a = saturate((int64_t) a + mulLevel());
+			else if (accept("-")) a = saturate((int64_t) a - mulLevel());
+			else return a;
+		}
+	}
+
+	int32_t compareLevel() {
+		int32_t a = addLevel();
+
+		while (true) {
+			if (accept("<=")) a = (a <= addLevel()) ? RULE_TRUE : 0;
+			else if (accept(">=")) a = (a >= addLevel()) ? RULE_TRUE : 0;
+			else if (accept("<")) a = (a < addLevel()) ? RULE_TRUE : 0;
+			else if (accept(">")) a = (a > addLevel()) ? RULE_TRUE : 0;
+			else return a;
+		}
+	}
+
+	int32_t equalLevel() {
+		int32_t a = compareLevel();
+
+		while (true) {
+			if (accept("==")) a = (a == compareLevel()) ? RULE_TRUE : 0;
+			else if (accept("!=")) a = (a != compareLevel()) ? RULE_TRUE : 0;
+			else return a;
+		}
+	}
+
+	// no short circuit, the postfix code evaluates both sides too
+	int32_t andLevel() {
+		int32_t a = equalLevel();
+
+		while (accept("&&")) {
+			int32_t b = equalLevel();
+			a = (a && b) ? RULE_TRUE : 0;
+		}
+
+		return a;
+	}
+
+	int32_t orLevel() {
+		int32_t a = andLevel();
+
+		while (accept("||")) {
+			int32_t b = andLevel();
+			a = (a || b) ? RULE_TRUE : 0;
+		}
+
+		return a;
+	}
+
+	bool evaluate(const char* text, int32_t* result) {
+		p = text;
+		failed = false;
+		*result = orLevel();
+
+		return !failed;
+	}
+};
+
+static uint32_t nextRandom(uint32_t limit) {
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 8) % limit;
+}
+
+static void addOperand(String* text) {
+	static const char* operands[] = {"ds0", "ds1", "ds2", "ds3", "hour", "minute", "rele0", "rele1", "7", "2.5", "0.01", "0", "1000000"};
+
+	*text += operands[nextRandom(sizeof(operands) / sizeof(operands[0]))];
+}
+
+static void addExpression(String* text, uint8_t depth) {
+	static const char* operators[] = {"*", "/", "+", "-", "<", "<=", ">", ">=", "==", "!=", "&&", "||"};
+
+	if (!depth || !nextRandom(3)) {
+		if (!nextRandom(6)) *text += nextRandom(2) ? "-" : "!";
+		addOperand(text);
+		return;
+	}
+
+	bool brackets = nextRandom(2);
+
+	if (brackets) *text += "(";
+	addExpression(text, depth - 1);
+	*text += operators[nextRandom(sizeof(operators) / sizeof(operators[0]))];
+	addExpression(text, depth - 1);
+	if (brackets) *text += ")";
+}
+
+static int32_t evaluate(const char* text) {
+	RuleEngine rule;
+	int32_t result = 0;
+
+	TEST_ASSERT_TRUE(rule.compile(text));
+	TEST_ASSERT_TRUE(rule.evaluate(&context, &result));
+
+	return result;
+}
+
+
+void test_matches_reference() {
+	Reference reference;
+	RuleEngine rule;
+	uint16_t compared = 0;
+	uint16_t failed = 0;
+
+	for (uint16_t i = 0;i < TEST_RULES_COUNT;i++) {
+		String text;
+		addExpression(&text, TEST_DEPTH_MAX);
+
+		// the generator may go over the text or the code size
+		if (text.length() > RULE_TEXT_SIZE - 1 || !rule.compile(text.c_str())) {
+			continue;
+		}
+
+		int32_t expected, result;
+		bool expected_flag = reference.evaluate(text.c_str(), &expected);
+		bool result_flag = rule.evaluate(&context, &result);
+
+		TEST_ASSERT_TRUE_MESSAGE(expected_flag == result_flag, text.c_str());
+
+		if (expected_flag) {
+			TEST_ASSERT_EQUAL_MESSAGE(expected, result, text.c_str());
+		}
+
+		compared++;
+		failed += !expected_flag;
+	}
+
+	char message[64];
+	snprintf(message, sizeof(message), "%u rules compared, %u over a failed sensor", compared, failed);
+	TEST_MESSAGE(message);
+
+	TEST_ASSERT_TRUE(compared > TEST_RULES_COUNT / 2);
+	TEST_ASSERT_TRUE(failed > 0 && failed < compared);
+}
+
+void test_arithmetic_saturates() {
+	TEST_ASSERT_EQUAL(INT32_MAX, evaluate("1000000 * 1000000"));
+	TEST_ASSERT_EQUAL(INT32_MIN, evaluate("-1000000 * 1000000"));
+	TEST_ASSERT_EQUAL(INT32_MAX, evaluate("1000000 / 0.01"));
+	TEST_ASSERT_EQUAL(INT32_MAX, evaluate("1000000 * 1000000 + 1000000"));
+	TEST_ASSERT_EQUAL(INT32_MIN, evaluate("-1000000 * 1000000 - 1000000"));
+	TEST_ASSERT_EQUAL(INT32_MAX, evaluate("-(-1000000 * 1000000)"));
+
+	// a saturated value still compares the right way
+	TEST_ASSERT_EQUAL(RULE_TRUE, evaluate("1000000 * 1000000 > 1000000"));
+	TEST_ASSERT_EQUAL(INT32_MAX - 1000000 * 100, evaluate("1000000 * 1000000 - 1000000"));
+}
+
+void test_overlong_text_is_refused() {
+	RuleEngine rule;
+
+	TEST_ASSERT_EQUAL(RULE_TEXT_SIZE - 1, strlen(TEST_LONG_RULE));
+	TEST_ASSERT_TRUE(rule.compile(TEST_LONG_RULE));
+	TEST_ASSERT_FALSE(rule.compile(TEST_LONG_RULE " "));
+	TEST_ASSERT_FALSE(rule.compile(TEST_LONG_RULE " && ds0 > 0"));
+
+	// the rule stays as it was
+	TEST_ASSERT_EQUAL_STRING(TEST_LONG_RULE, rule.getText());
+	TEST_ASSERT_TRUE(rule.isCompiled());
+}
+
+void test_time_rule_waits_for_the_clock() {
+	RuleEngine rule;
+	int32_t result;
+
+	TEST_ASSERT_TRUE(rule.compile("hour >= 6 || ds0 > 0"));
+	TEST_ASSERT_TRUE(rule.evaluate(&context, &result));
+
+	context.time_flag = false;
+	TEST_ASSERT_FALSE(rule.evaluate(&context, &result));
+
+	TEST_ASSERT_TRUE(rule.compile("ds0 > 0"));
+	TEST_ASSERT_TRUE(rule.evaluate(&context, &result));
+}
+
+// midnight of an unset clock matches "hour < 6", the pump must not start on it
+void test_solar_rule_waits_for_the_clock() {
+	TimeManager* time = systemManager.getTimeManager();
+	SolarSystemManager* solar = systemManager.getSolarSystemManager();
+	SensorsManager* system_sensors = systemManager.getSensorsManager();
+
+	LittleFS.format();
+	time->makeDefault();
+	system_sensors->makeDefault();
+	solar->makeDefault();
+	systemManager.begin();
+
+	solar->setWorkFlag(true);
+	solar->setChannelErrorPolicy(0, SOLAR_ERROR_OFF);
+	solar->setRule(0, "hour < 6");
+	solar->setRuleChannel(0, 0);
+	solar->setRuleAction(0, SOLAR_RULE_ON);
+
+	TEST_ASSERT_TRUE(time->getStatus());
+	solar->tick();
+	TEST_ASSERT_FALSE(solar->getReleFlag());
+
+	time->setTime(3, 0, 0, 16, 10, 2026);
+	system_sensors->setSample(SENSOR_SOURCE_DS18B20, SENSOR_TYPE_TEMPERATURE, 2000, 0);
+	solar->tick();
+
+	TEST_ASSERT_TRUE(solar->getReleFlag());
+	TEST_ASSERT_EQUAL(SOLAR_REASON_RULE, solar->getSnapshot()->channels[0].reason);
+}
+
+// host time, the code is the same on the esp8266, which is some 20 - 50 times slower
+void test_benchmark() {
+	static const char* texts[] = {"ds0 > 50", "ds0 - ds1 > 10.25 && hour >= 6", TEST_LONG_RULE};
+
+	for (const char* text : texts) {
+		RuleEngine rule;
+		int32_t result = 0;
+		int64_t sum = 0;
+
+		TEST_ASSERT_TRUE(rule.compile(text));
+
+		auto start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0;i < TEST_BENCHMARK_COUNT;i++) {
+			rule.evaluate(&context, &result);
+			sum += result;
+		}
+		auto end = std::chrono::steady_clock::now();
+
+		double time = std::chrono::duration<double, std::nano>(end - start).count() / TEST_BENCHMARK_COUNT;
+		char message[128];
+
+		snprintf(message, sizeof(message), "\"%s\": %u ops, %.1f ns per rule, %.1f ns per op (%lld)", text, rule.getLength(), time,
+			time / rule.getLength(), (long long) (sum / TEST_BENCHMARK_COUNT));
+		TEST_MESSAGE(message);
+	}
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_matches_reference);
+	RUN_TEST(test_arithmetic_saturates);
+	RUN_TEST(test_overlong_text_is_refused);
+	RUN_TEST(test_time_rule_waits_for_the_clock);
+	RUN_TEST(test_solar_rule_waits_for_the_clock);
+	RUN_TEST(test_benchmark);
+
+	return UNITY_END();
+}
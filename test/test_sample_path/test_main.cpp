@@ -0,0 +1,128 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * The sample path before and after the move to centi-degrees. The float path converts the
+ * raw value with getTempC(), adds a float correction, compares a float delta and prints
+ * with String(float, 1). The integer path does the same in c° and prints with
+ * centiToString(). Both must print the same text, except that a tie (x.x5°) is rounded
+ * away from zero by centiToString() and to even by printf. The benchmark prints the cost
+ * of each.
+ */
+
+#include <unity.h>
+#include <chrono>
+#include "data.h"
+
+#define TEST_SAMPLES_COUNT 1024
+#define TEST_BENCHMARK_COUNT 200 // passes over the samples
+#define TEST_CORRECTION 50 // c°
+#define TEST_ON_DELTA 5 // °
+
+SystemManager systemManager;
+
+static int16_t raws[TEST_SAMPLES_COUNT]; // 1/16°
+
+void setUp() {
+	uint32_t seed = 1;
+
+	// 12 bit values from -55° to 125°
+	for (uint16_t i = 0;i < TEST_SAMPLES_COUNT;i++) {
+		seed = seed * 1103515245 + 12345;
+		raws[i] = -880 + (int16_t) ((seed >> 16) % 2881);
+	}
+}
+
+void tearDown() {
+}
+
+// getTempC() and a float correction, as the readout was before
+static float getFloatT(int16_t raw) {
+	return raw * 0.0625f + TEST_CORRECTION / 100.0f;
+}
+
+// convertDS18B20Raw() for 12 bits and a c° correction
+static int16_t getCentiT(int16_t raw) {
+	return (((int32_t) raw * 25 + 2) >> 2) + TEST_CORRECTION;
+}
+
+static uint32_t runFloatPath(int16_t battery_raw, int16_t boiler_raw) {
+	float battery_t = getFloatT(battery_raw);
+	float boiler_t = getFloatT(boiler_raw);
+	bool on_flag = battery_t - boiler_t >= TEST_ON_DELTA;
+
+	return String(battery_t, 1).length() + on_flag;
+}
+
+static uint32_t runCentiPath(int16_t battery_raw, int16_t boiler_raw) {
+	int16_t battery_t = getCentiT(battery_raw);
+	int16_t boiler_t = getCentiT(boiler_raw);
+	bool on_flag = battery_t - boiler_t >= TEST_ON_DELTA * 100;
+
+	return centiToString(battery_t, 1).length() + on_flag;
+}
+
+void test_paths_print_the_same() {
+	// every 12 bit value of the range
+	for (int16_t raw = -880;raw <= 2000;raw++) {
+		float t = getFloatT(raw);
+		int16_t centi_t = getCentiT(raw);
+
+		// a tie is exact in binary, push it away from zero as centiToString() does
+		if (abs(centi_t) % 10 == 5) {
+			t += (t < 0) ? -0.01f : 0.01f;
+		}
+
+		String float_string = String(t, 1);
+		String centi_string = centiToString(centi_t, 1);
+
+		TEST_ASSERT_EQUAL_STRING(float_string.c_str(), centi_string.c_str());
+	}
+}
+
+void test_paths_switch_the_same() {
+	for (uint16_t i = 1;i < TEST_SAMPLES_COUNT;i++) {
+		bool float_flag = getFloatT(raws[i]) - getFloatT(raws[i - 1]) >= TEST_ON_DELTA;
+		bool centi_flag = getCentiT(raws[i]) - getCentiT(raws[i - 1]) >= TEST_ON_DELTA * 100;
+
+		TEST_ASSERT_EQUAL(float_flag, centi_flag);
+	}
+}
+
+// host time, the esp8266 has no fpu and pays far more for the float path
+void test_benchmark() {
+	uint32_t (*paths[])(int16_t, int16_t) = {runFloatPath, runCentiPath};
+	static const char* names[] = {"float", "centi"};
+	double times[2];
+
+	for (uint8_t path = 0;path < 2;path++) {
+		uint64_t sum = 0;
+
+		auto start = std::chrono::steady_clock::now();
+		for (uint32_t pass = 0;pass < TEST_BENCHMARK_COUNT;pass++) {
+			for (uint16_t i = 1;i < TEST_SAMPLES_COUNT;i++) {
+				sum += paths[path](raws[i], raws[i - 1]);
+			}
+		}
+		auto end = std::chrono::steady_clock::now();
+
+		times[path] = std::chrono::duration<double, std::nano>(end - start).count() / TEST_BENCHMARK_COUNT / (TEST_SAMPLES_COUNT - 1);
+		char message[96];
+
+		snprintf(message, sizeof(message), "%s path: %.1f ns per sample (%llu)", names[path], times[path], (unsigned long long) sum);
+		TEST_MESSAGE(message);
+	}
+
+	char message[64];
+	snprintf(message, sizeof(message), "centi path: %.2fx of the float path", times[1] / times[0]);
+	TEST_MESSAGE(message);
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_paths_print_the_same);
+	RUN_TEST(test_paths_switch_the_same);
+	RUN_TEST(test_benchmark);
+
+	return UNITY_END();
+}
@@ -0,0 +1,311 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * Settings file size. Every manager is filled up to the longest values its setters accept,
+ * the written entries must stay inside the worst case reserved for it in SETTINGS_BUFFER_SIZE
+ * and the saved file must read back.
+ */
+
+#include <unity.h>
+#include "data.h"
+
+#define TEST_LONG_TEXT "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789" // longer than any settings string
+#define TEST_COUNTER 4000000000UL // ten digits, a counter near the end of its range
+#define TEST_RULE "ds0 - ds1 > 10.25 && hour >= 6 || rele1" // RULE_TEXT_SIZE - 1 characters
+
+SystemManager systemManager;
+
+static char buffer[SETTINGS_BUFFER_SIZE * 2];
+
+// a power cycle, the managers start from their defaults and read the file
+static void restart() {
+	memset(mock::rtc_memory, 0, sizeof(mock::rtc_memory));
+
+	systemManager.makeDefault();
+	systemManager.getTimeManager()->makeDefault();
+	systemManager.getSensorsManager()->makeDefault();
+	systemManager.getSolarSystemManager()->makeDefault();
+	systemManager.getDisplayManager()->makeDefault();
+	systemManager.getNetworkManager()->makeDefault();
+	systemManager.getBlynkManager()->makeDefault();
+	systemManager.begin();
+}
+
+void setUp() {
+	mock::reset();
+	LittleFS.format();
+	restart();
+}
+
+void tearDown() {
+}
+
+static void fillSensors(SensorsManager* sensors) {
+	DeviceAddress address;
+	memset(address, 0xFF, sizeof(DeviceAddress));
+
+	sensors->setReadDataTime(255);
+	sensors->setAutoResolutionRatio(255);
+	sensors->setCrcPeriod(255);
+	sensors->setAdaptiveRate(255);
+	sensors->setAlarmBand(255);
+	sensors->setFaultStuckCount(255);
+	sensors->setFaultRate(255);
+	sensors->setFaultPairDelta(255);
+	sensors->setFlowPort(16);
+	sensors->setFlowPulses(65535);
+	sensors->setAnalogWorkFlag(true);
+	sensors->getAnalogDriver()->setPointsCount(ANALOG_POINTS_COUNT);
+
+	for (uint8_t i = 0;i < ANALOG_POINTS_COUNT;i++) {
+		sensors->getAnalogDriver()->setPoint(i, 65535, INT32_MIN);
+	}
+
+	for (uint8_t bus = 0;bus < DS18B20_BUS_COUNT;bus++) {
+		sensors->setDS18B20BusPort(bus, 16);
+	}
+
+	for (uint8_t i = 0;i < DS_SENSORS_MAX_COUNT;i++) {
+		address[7] = i;
+
+		TEST_ASSERT_TRUE(sensors->addDS18B20());
+		sensors->setDS18B20Name(i, TEST_LONG_TEXT);
+		sensors->setDS18B20Address(i, address);
+		sensors->setDS18B20Resolution(i, 255);
+		sensors->setDS18B20AutoResolutionFlag(i, true);
+		sensors->setDS18B20ReadTime(i, 255);
+		sensors->setDS18B20AdaptiveFlag(i, true);
+		sensors->setDS18B20Bus(i, DS18B20_BUS_COUNT - 1);
+		sensors->setDS18B20CorrectionCenti(i, -DS18B20_CORRECTION_MAX);
+		sensors->setDS18B20FilterMedian(i, 255);
+		sensors->setDS18B20FilterEma(i, 255);
+		sensors->setDS18B20FilterSlew(i, 255);
+		sensors->setDS18B20Pair(i, -128);
+	}
+}
+
+static void fillNetwork(NetworkManager* network) {
+	network->setMode(NETWORK_AUTO);
+	network->setWifi(TEST_LONG_TEXT, TEST_LONG_TEXT);
+	network->setAp(TEST_LONG_TEXT, TEST_LONG_TEXT);
+}
+
+static void fillBlynk(BlynkManager* blynk) {
+	blynk->setWorkFlag(true);
+	blynk->setSendDataTime(255);
+	blynk->setAuth(TEST_LONG_TEXT);
+
+	for (uint8_t i = 0;i < BLYNK_LINKS_MAX;i++) {
+		TEST_ASSERT_TRUE(blynk->addLink());
+		blynk->setLinkPort(i, 255);
+		blynk->setLinkElementCode(i, TEST_LONG_TEXT);
+	}
+}
+
+static void fillAll() {
+	systemManager.getTimeManager()->setNtpFlag(true);
+	systemManager.getTimeManager()->setGmt(-128);
+
+	fillSensors(systemManager.getSensorsManager());
+	fillNetwork(systemManager.getNetworkManager());
+	fillBlynk(systemManager.getBlynkManager());
+}
+
+// the entries of one manager, checked against its share of the buffer
+template <class T> static uint16_t writeSettings(T* manager) {
+	*buffer = 0;
+	manager->writeSettings(buffer);
+
+	return strlen(buffer);
+}
+
+static void save() {
+	systemManager.saveSettingsRequest();
+	mock::advance(SEC_TO_MLS(SAVE_SETTINGS_TIME) * 1000);
+	systemManager.tick();
+}
+
+
+void test_every_manager_fits_its_worst_case() {
+	fillAll();
+
+	TEST_ASSERT_LESS_OR_EQUAL(TIME_SETTINGS_SIZE, writeSettings(systemManager.getTimeManager()));
+	TEST_ASSERT_LESS_OR_EQUAL(SENSORS_SETTINGS_SIZE, writeSettings(systemManager.getSensorsManager()));
+	TEST_ASSERT_LESS_OR_EQUAL(SOLAR_SETTINGS_SIZE, writeSettings(systemManager.getSolarSystemManager()));
+	TEST_ASSERT_LESS_OR_EQUAL(DISPLAY_SETTINGS_SIZE, writeSettings(systemManager.getDisplayManager()));
+	TEST_ASSERT_LESS_OR_EQUAL(NETWORK_SETTINGS_SIZE, writeSettings(systemManager.getNetworkManager()));
+	TEST_ASSERT_LESS_OR_EQUAL(BLYNK_SETTINGS_SIZE, writeSettings(systemManager.getBlynkManager()));
+}
+
+void test_strings_are_cut_to_their_size() {
+	fillAll();
+
+	TEST_ASSERT_EQUAL(DS_NAME_SIZE - 1, strlen(systemManager.getSensorsManager()->getDS18B20Name(0)));
+	TEST_ASSERT_EQUAL(NETWORK_SSID_PASS_SIZE - 1, strlen(systemManager.getNetworkManager()->getWifiSsid()));
+	TEST_ASSERT_EQUAL(NETWORK_SSID_PASS_SIZE - 1, strlen(systemManager.getNetworkManager()->getApPass()));
+	TEST_ASSERT_EQUAL(BLYNK_AUTH_SIZE - 1, strlen(systemManager.getBlynkManager()->getAuth()));
+	TEST_ASSERT_EQUAL(BLYNK_ELEMENT_CODE_SIZE - 1, strlen(systemManager.getBlynkManager()->getLinkElementCode(0)));
+}
+
+void test_full_settings_are_saved_and_read_back() {
+	fillAll();
+	save();
+
+	TEST_ASSERT_TRUE(LittleFS.exists("/config.nztr"));
+	TEST_ASSERT_LESS_OR_EQUAL(SETTINGS_BUFFER_SIZE, mock::files["/config.nztr"].size());
+
+	restart();
+
+	SensorsManager* sensors = systemManager.getSensorsManager();
+	TEST_ASSERT_EQUAL(DS_SENSORS_MAX_COUNT, sensors->getDS18B20Count());
+	TEST_ASSERT_EQUAL_INT16(-DS18B20_CORRECTION_MAX, sensors->getDS18B20(DS_SENSORS_MAX_COUNT - 1)->correction);
+	TEST_ASSERT_EQUAL(DS_SENSORS_MAX_COUNT - 1, sensors->getDS18B20Address(DS_SENSORS_MAX_COUNT - 1)[7]);
+	TEST_ASSERT_EQUAL(INT32_MIN, sensors->getAnalogDriver()->getPointValue(ANALOG_POINTS_COUNT - 1));
+	TEST_ASSERT_EQUAL(BLYNK_LINKS_MAX, systemManager.getBlynkManager()->getLinksCount());
+	TEST_ASSERT_EQUAL_STRING(systemManager.getBlynkManager()->getLinkElementCode(0), systemManager.getBlynkManager()->getLinkElementCode(BLYNK_LINKS_MAX - 1));
+}
+
+// the limits of channel 0 apply to every relay, the counters are kept per channel
+void test_rele_keys_fit_and_read_back() {
+	SolarSystemManager* solar = systemManager.getSolarSystemManager();
+	ReleDriver* rele = solar->getReleDriver(0);
+
+	fillAll();
+	rele->setMinOnTime(65535);
+	rele->setMinOffTime(65535);
+	rele->setMaxRate(255);
+	rele->setOverrideTime(255);
+	rele->resetStats();
+	rele->loadStats(TEST_COUNTER, TEST_COUNTER, TEST_COUNTER);
+
+	TEST_ASSERT_LESS_OR_EQUAL(SOLAR_SETTINGS_SIZE, writeSettings(solar));
+	save();
+	restart();
+
+	for (uint8_t i = 0;i < SOLAR_CHANNELS_COUNT;i++) {
+		TEST_ASSERT_EQUAL(RELE_TIME_MAX, solar->getReleDriver(i)->getMinOnTime());
+		TEST_ASSERT_EQUAL(RELE_TIME_MAX, solar->getReleDriver(i)->getMinOffTime());
+		TEST_ASSERT_EQUAL(RELE_RATE_MAX, solar->getReleDriver(i)->getMaxRate());
+		TEST_ASSERT_EQUAL(RELE_OVERRIDE_TIME_MAX, solar->getReleDriver(i)->getOverrideTime());
+	}
+
+	// the tick of the save may switch the relay once
+	TEST_ASSERT_UINT32_WITHIN(1, TEST_COUNTER, rele->getCycles());
+	TEST_ASSERT_UINT32_WITHIN(SAVE_SETTINGS_TIME, TEST_COUNTER, rele->getOnTime());
+}
+
+// every channel of the table with its relay and counters
+void test_channel_keys_fit_and_read_back() {
+	SolarSystemManager* solar = systemManager.getSolarSystemManager();
+
+	fillAll();
+	solar->setExitSensor(-128);
+	solar->setChannelsCount(255);
+
+	for (uint8_t i = 0;i < SOLAR_CHANNELS_COUNT;i++) {
+		solar->setChannelSource(i, i);
+		solar->setChannelSink(i, -128);
+		solar->setChannelOnDelta(i, 255);
+		solar->setChannelOffDelta(i, 255);
+		solar->setChannelErrorPolicy(i, SOLAR_ERROR_OFF);
+		solar->getReleDriver(i)->setPort(RELE_PORT_MAX);
+		solar->getReleDriver(i)->setInvertFlag(true);
+		solar->getReleDriver(i)->resetStats();
+		solar->getReleDriver(i)->loadStats(TEST_COUNTER, TEST_COUNTER, TEST_COUNTER);
+	}
+
+	TEST_ASSERT_LESS_OR_EQUAL(SOLAR_SETTINGS_SIZE, writeSettings(solar));
+	save();
+	restart();
+
+	TEST_ASSERT_EQUAL(SOLAR_CHANNELS_COUNT, solar->getChannelsCount());
+
+	for (uint8_t i = 0;i < SOLAR_CHANNELS_COUNT;i++) {
+		TEST_ASSERT_EQUAL(i, solar->getChannelSource(i));
+		TEST_ASSERT_EQUAL(-1, solar->getChannelSink(i));
+		TEST_ASSERT_EQUAL(SOLAR_DELTA_MAX, solar->getChannelOnDelta(i));
+		TEST_ASSERT_EQUAL(SOLAR_DELTA_MAX - 1, solar->getChannelOffDelta(i));
+		TEST_ASSERT_EQUAL(SOLAR_ERROR_OFF, solar->getChannelErrorPolicy(i));
+		TEST_ASSERT_EQUAL(RELE_PORT_MAX, solar->getReleDriver(i)->getPort());
+		TEST_ASSERT_TRUE(solar->getReleDriver(i)->getInvertFlag());
+		TEST_ASSERT_UINT32_WITHIN(1, TEST_COUNTER, solar->getReleDriver(i)->getCycles());
+	}
+}
+
+// every rule at its longest text
+void test_rule_keys_fit_and_read_back() {
+	SolarSystemManager* solar = systemManager.getSolarSystemManager();
+
+	fillAll();
+	TEST_ASSERT_EQUAL(RULE_TEXT_SIZE - 1, strlen(TEST_RULE));
+
+	for (uint8_t i = 0;i < SOLAR_RULES_COUNT;i++) {
+		solar->setRule(i, TEST_RULE);
+		solar->setRuleChannel(i, 255);
+		solar->setRuleAction(i, SOLAR_RULE_ON);
+		TEST_ASSERT_TRUE(solar->getRule(i)->isCompiled());
+	}
+
+	TEST_ASSERT_LESS_OR_EQUAL(SOLAR_SETTINGS_SIZE, writeSettings(solar));
+	save();
+	restart();
+
+	for (uint8_t i = 0;i < SOLAR_RULES_COUNT;i++) {
+		TEST_ASSERT_EQUAL_STRING(TEST_RULE, solar->getRule(i)->getText());
+		TEST_ASSERT_TRUE(solar->getRule(i)->isCompiled());
+		TEST_ASSERT_EQUAL(SOLAR_CHANNELS_COUNT - 1, solar->getRuleChannel(i));
+		TEST_ASSERT_EQUAL(SOLAR_RULE_ON, solar->getRuleAction(i));
+	}
+}
+
+// a separator in a rule would split its entry in the file
+void test_rule_with_separator_is_refused() {
+	SolarSystemManager* solar = systemManager.getSolarSystemManager();
+
+	solar->setRule(0, "ds0 > 50");
+	solar->setRule(0, "ds0 > 60;SSSCp0=5");
+	TEST_ASSERT_EQUAL_STRING("ds0 > 50", solar->getRule(0)->getText());
+
+	writeSettings(solar);
+	TEST_ASSERT_NULL(strstr(buffer, "SSSCp0=5"));
+}
+
+// the heat counters of a long life, the clock is not set so the day does not roll over
+void test_energy_keys_fit_and_read_back() {
+	SolarSystemManager* solar = systemManager.getSolarSystemManager();
+	EnergyMeter* energy = solar->getEnergyMeter();
+
+	fillAll();
+	energy->setWorkFlag(true);
+	energy->setFlow(65535);
+	energy->setCapacity(65535);
+	energy->resetStats();
+	energy->loadStats(TEST_COUNTER, TEST_COUNTER, TEST_COUNTER, 20991231);
+
+	TEST_ASSERT_LESS_OR_EQUAL(SOLAR_SETTINGS_SIZE, writeSettings(solar));
+	save();
+	restart();
+
+	TEST_ASSERT_TRUE(energy->getWorkFlag());
+	TEST_ASSERT_EQUAL(ENERGY_FLOW_MAX, energy->getFlow());
+	TEST_ASSERT_EQUAL(ENERGY_CAPACITY_MAX, energy->getCapacity());
+	TEST_ASSERT_EQUAL_UINT32(TEST_COUNTER, energy->getDay());
+	TEST_ASSERT_EQUAL_UINT32(TEST_COUNTER, energy->getMonth());
+	TEST_ASSERT_EQUAL_UINT32(TEST_COUNTER, energy->getLifetime());
+	TEST_ASSERT_EQUAL_UINT32(20991231, energy->getDate());
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_every_manager_fits_its_worst_case);
+	RUN_TEST(test_strings_are_cut_to_their_size);
+	RUN_TEST(test_full_settings_are_saved_and_read_back);
+	RUN_TEST(test_rele_keys_fit_and_read_back);
+	RUN_TEST(test_channel_keys_fit_and_read_back);
+	RUN_TEST(test_rule_keys_fit_and_read_back);
+	RUN_TEST(test_rule_with_separator_is_refused);
+	RUN_TEST(test_energy_keys_fit_and_read_back);
+
+	return UNITY_END();
+}
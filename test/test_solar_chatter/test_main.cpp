@@ -0,0 +1,166 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * Relay chatter from sensor glitches. One sample spikes on the battery or the boiler sensor
+ * now and then, the delta crosses the on threshold for that sample only. The real
+ * SensorsManager and SolarSystemManager run with the default relay protection, the pump
+ * starts on every glitch without a filter and never with the median filter.
+ */
+
+#include <unity.h>
+#include "data.h"
+
+#define TEST_LOOP_TIME 10 // mls between two ticks of the main loop
+#define TEST_BATTERY_T 4000 // c°
+#define TEST_BOILER_T 3800 // c°, under the off delta
+#define TEST_EXIT_T 3900 // c°
+#define TEST_GLITCH 1000 // c°, over the on delta
+#define TEST_GLITCHES_COUNT 10
+#define TEST_QUIET_TIME (3600 / DEFAULT_RELE_MAX_RATE) // sec between two glitches, the start spacing
+
+SystemManager systemManager;
+
+static FakeOneWireBus* bus;
+static FakeDS18B20* devices[3]; // battery, boiler, exit
+static SensorsManager* sensors;
+static SolarSystemManager* solar;
+
+void setUp() {
+	mock::reset();
+	LittleFS.format();
+
+	bus = new FakeOneWireBus(DS18B20_PORT);
+	devices[0] = new FakeDS18B20(0xF0CA0, TEST_BATTERY_T);
+	devices[1] = new FakeDS18B20(0xF0CB1, TEST_BOILER_T);
+	devices[2] = new FakeDS18B20(0xF0CC2, TEST_EXIT_T);
+
+	for (uint8_t i = 0;i < 3;i++) {
+		bus->add(devices[i]);
+	}
+
+	systemManager.makeDefault();
+	systemManager.getTimeManager()->makeDefault();
+	systemManager.getSensorsManager()->makeDefault();
+	systemManager.getSolarSystemManager()->makeDefault();
+	systemManager.begin();
+
+	sensors = systemManager.getSensorsManager();
+	solar = systemManager.getSolarSystemManager();
+
+	for (uint8_t i = 0;i < 3;i++) {
+		sensors->addDS18B20();
+		sensors->setDS18B20Address(i, devices[i]->rom);
+	}
+
+	solar->setWorkFlag(true);
+	solar->setBatterySensor(0);
+	solar->setBoilerSensor(1);
+	solar->setExitSensor(2);
+}
+
+void tearDown() {
+	for (uint8_t i = 0;i < 3;i++) {
+		delete devices[i];
+	}
+
+	delete bus;
+}
+
+static void run(uint32_t time) {
+	uint64_t end = mock::clock + (uint64_t) time * 1000;
+
+	while (mock::clock < end) {
+		sensors->tick();
+		solar->tick();
+		mock::advance(TEST_LOOP_TIME * 1000);
+	}
+}
+
+// until both sensors publish a new sample, the conversion after the call sees the new t
+static void nextSample() {
+	uint32_t times[2];
+
+	for (uint8_t i = 0;i < 2;i++) {
+		times[i] = sensors->getSample(SENSOR_SOURCE_DS18B20 + i)->time;
+	}
+
+	while (sensors->getSample(SENSOR_SOURCE_DS18B20)->time == times[0] || sensors->getSample(SENSOR_SOURCE_DS18B20 + 1)->time == times[1]) {
+		run(TEST_LOOP_TIME);
+	}
+}
+
+// one sample of every glitch reaches the sensors manager, the battery up or the boiler down
+static uint32_t runGlitches() {
+	uint32_t cycles = solar->getReleDriver()->getCycles();
+
+	for (uint8_t i = 0;i < TEST_GLITCHES_COUNT;i++) {
+		FakeDS18B20* device = devices[i % 2];
+		int16_t t = (i % 2) ? TEST_BOILER_T : TEST_BATTERY_T;
+
+		nextSample();
+		device->setT((i % 2) ? t - TEST_GLITCH : t + TEST_GLITCH); // a single sample
+		nextSample();
+		device->setT(t);
+		nextSample();
+
+		run(SEC_TO_MLS(TEST_QUIET_TIME));
+	}
+
+	return solar->getReleDriver()->getCycles() - cycles;
+}
+
+// the pump runs on the sensor errors of the start, the next start waits for the spacing
+static void settle() {
+	run(SEC_TO_MLS(TEST_QUIET_TIME));
+
+	TEST_ASSERT_EQUAL(0, solar->getStatus());
+	TEST_ASSERT_FALSE(solar->getReleFlag());
+}
+
+
+void test_glitches_start_the_pump_without_filter() {
+	settle();
+
+	TEST_ASSERT_EQUAL(TEST_GLITCHES_COUNT, runGlitches());
+	TEST_ASSERT_FALSE(solar->getReleFlag());
+}
+
+void test_median_keeps_the_pump_off() {
+	for (uint8_t i = 0;i < 2;i++) {
+		sensors->setDS18B20FilterMedian(i, 3);
+	}
+
+	settle();
+
+	TEST_ASSERT_EQUAL(0, runGlitches());
+	TEST_ASSERT_FALSE(solar->getReleFlag());
+}
+
+// the filter does not hide a lasting delta
+void test_median_passes_a_real_delta() {
+	for (uint8_t i = 0;i < 2;i++) {
+		sensors->setDS18B20FilterMedian(i, 3);
+	}
+
+	settle();
+
+	uint32_t cycles = solar->getReleDriver()->getCycles();
+	devices[0]->setT(TEST_BATTERY_T + TEST_GLITCH);
+
+	for (uint8_t i = 0;i < 4;i++) {
+		nextSample();
+	}
+
+	TEST_ASSERT_TRUE(solar->getReleFlag());
+	TEST_ASSERT_EQUAL(cycles + 1, solar->getReleDriver()->getCycles());
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_glitches_start_the_pump_without_filter);
+	RUN_TEST(test_median_keeps_the_pump_off);
+	RUN_TEST(test_median_passes_a_real_delta);
+
+	return UNITY_END();
+}
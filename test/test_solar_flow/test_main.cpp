@@ -0,0 +1,201 @@
+/*
+ * Project: Solar Battery Control System
+ *
+ * Flow meter and dry pump protection. The pulses come through the interrupt handler, the
+ * rate and the volume are checked against the pulse count, and a pump running without
+ * flow must stop after SOLAR_NO_FLOW_TIME whatever the error policy, then retry with a
+ * growing pause.
+ */
+
+#include <unity.h>
+#include "data.h"
+
+#define TEST_LOOP_TIME 1 // mls between two ticks of the main loop
+#define TEST_FLOW_PORT D3
+#define TEST_PULSES 450 // per liter
+#define TEST_BATTERY_T 6000 // c°
+#define TEST_BOILER_T 3000 // c°
+#define TEST_EXIT_T 4500 // c°
+#define TEST_SETTLE_TIME 10 // sec
+
+SystemManager systemManager;
+
+static FakeOneWireBus* bus;
+static FakeDS18B20* devices[3];
+static SensorsManager* sensors;
+static SolarSystemManager* solar;
+static uint32_t pulses_rate; // per minute
+static uint32_t pulses_sent;
+
+void setUp() {
+	mock::reset();
+	LittleFS.format();
+
+	bus = new FakeOneWireBus(DS18B20_PORT);
+	devices[0] = new FakeDS18B20(0xF10A0, TEST_BATTERY_T);
+	devices[1] = new FakeDS18B20(0xF10B1, TEST_BOILER_T);
+	devices[2] = new FakeDS18B20(0xF10C2, TEST_EXIT_T);
+
+	for (uint8_t i = 0;i < 3;i++) {
+		bus->add(devices[i]);
+	}
+
+	systemManager.makeDefault();
+	systemManager.getTimeManager()->makeDefault();
+	systemManager.getSensorsManager()->makeDefault();
+	systemManager.getSolarSystemManager()->makeDefault();
+	systemManager.begin();
+
+	sensors = systemManager.getSensorsManager();
+	solar = systemManager.getSolarSystemManager();
+
+	for (uint8_t i = 0;i < 3;i++) {
+		sensors->addDS18B20();
+		sensors->setDS18B20Address(i, devices[i]->rom);
+	}
+
+	sensors->setFlowPort(TEST_FLOW_PORT);
+	sensors->setFlowPulses(TEST_PULSES);
+
+	solar->setWorkFlag(true);
+	solar->setBatterySensor(0);
+	solar->setBoilerSensor(1);
+	solar->setExitSensor(2);
+	solar->getReleDriver()->setMaxRate(0);
+
+	pulses_rate = 0;
+	pulses_sent = 0;
+}
+
+void tearDown() {
+	for (uint8_t i = 0;i < 3;i++) {
+		delete devices[i];
+	}
+
+	delete bus;
+}
+
+// the pulses are spread evenly over the loop ticks
+static void run(uint32_t time) {
+	uint64_t end = mock::clock + (uint64_t) time * 1000;
+
+	while (mock::clock < end) {
+		uint32_t pulses = (uint64_t) pulses_rate * millis() / MIN_TO_MLS(1);
+
+		for (;pulses_sent < pulses;pulses_sent++) {
+			TEST_ASSERT_TRUE(mock::interrupt(TEST_FLOW_PORT));
+		}
+
+		sensors->tick();
+		solar->tick();
+		mock::advance(TEST_LOOP_TIME * 1000);
+	}
+}
+
+// the pump flow, while the pump is off the meter stands still
+static void setFlow(uint32_t centi_liters) {
+	pulses_rate = (uint64_t) centi_liters * TEST_PULSES / 100;
+	pulses_sent = (uint64_t) pulses_rate * millis() / MIN_TO_MLS(1);
+}
+
+// mls when the pump reaches the state
+static uint32_t runUntil(bool state) {
+	for (uint32_t i = 0;i < SEC_TO_MLS(SOLAR_NO_FLOW_RETRY_MAX + 60) && solar->getReleFlag() != state;i += TEST_LOOP_TIME) {
+		run(TEST_LOOP_TIME);
+	}
+
+	TEST_ASSERT_TRUE(solar->getReleFlag() == state);
+	return millis();
+}
+
+// the pump runs dry for SOLAR_NO_FLOW_TIME, the pause before the retry is returned in mls
+static uint32_t checkDryRun() {
+	uint32_t start = runUntil(true);
+	uint32_t stop = runUntil(false);
+
+	TEST_ASSERT_INT_WITHIN(SEC_TO_MLS(1), SEC_TO_MLS(SOLAR_NO_FLOW_TIME), stop - start);
+	TEST_ASSERT_EQUAL(8, solar->getStatus());
+	TEST_ASSERT_EQUAL(SOLAR_REASON_NO_FLOW, solar->getSnapshot()->channels[0].reason);
+
+	// the error policy does not restart it during the pause
+	return runUntil(true) - stop;
+}
+
+
+void test_rate_and_volume_follow_the_pulses() {
+	setFlow(1250); // 12.5 l/min
+	run(MIN_TO_MLS(2));
+
+	sensor_sample_t* rate = sensors->getSample(SENSOR_SOURCE_FLOW);
+	sensor_sample_t* volume = sensors->getSample(SENSOR_SOURCE_FLOW_VOLUME);
+
+	TEST_ASSERT_EQUAL(SENSOR_TYPE_FLOW, rate->type);
+	TEST_ASSERT_INT_WITHIN(15, 1250, rate->value); // one pulse of a one second window
+	TEST_ASSERT_INT_WITHIN(21, 2500, volume->value); // the last window is not collected yet
+
+	setFlow(0);
+	run(SEC_TO_MLS(2));
+	TEST_ASSERT_EQUAL(0, rate->value);
+}
+
+void test_isr_counts_only_with_a_port() {
+	sensors->setFlowPort(FLOW_PORT_OFF);
+
+	TEST_ASSERT_FALSE(mock::interrupt(TEST_FLOW_PORT));
+	TEST_ASSERT_EQUAL(SENSOR_TYPE_NONE, sensors->getSample(SENSOR_SOURCE_FLOW)->type);
+}
+
+void test_dry_run_stops_under_error_on() {
+	solar->setChannelErrorPolicy(0, SOLAR_ERROR_ON);
+	TEST_ASSERT_INT_WITHIN(SEC_TO_MLS(1), SEC_TO_MLS(SOLAR_NO_FLOW_RETRY_TIME), checkDryRun());
+}
+
+void test_dry_run_stops_under_error_hold() {
+	solar->setChannelErrorPolicy(0, SOLAR_ERROR_HOLD);
+	TEST_ASSERT_INT_WITHIN(SEC_TO_MLS(1), SEC_TO_MLS(SOLAR_NO_FLOW_RETRY_TIME), checkDryRun());
+}
+
+// every dry retry doubles the pause up to the limit, a retry with flow keeps running and resets it
+void test_retry_backoff() {
+	solar->setChannelErrorPolicy(0, SOLAR_ERROR_ON);
+
+	for (uint32_t pause = SOLAR_NO_FLOW_RETRY_TIME;pause <= SOLAR_NO_FLOW_RETRY_MAX * 2;pause *= 2) {
+		TEST_ASSERT_INT_WITHIN(SEC_TO_MLS(1), SEC_TO_MLS(min(pause, (uint32_t) SOLAR_NO_FLOW_RETRY_MAX)), checkDryRun());
+	}
+
+	setFlow(800);
+	run(MIN_TO_MLS(5));
+
+	TEST_ASSERT_TRUE(solar->getReleFlag());
+	TEST_ASSERT_EQUAL(0, solar->getStatus());
+
+	setFlow(0);
+	TEST_ASSERT_INT_WITHIN(SEC_TO_MLS(1), SEC_TO_MLS(SOLAR_NO_FLOW_RETRY_TIME), checkDryRun());
+}
+
+// a manual start does not let the pump run dry either
+void test_override_is_stopped() {
+	solar->setChannelErrorPolicy(0, SOLAR_ERROR_OFF);
+	devices[0]->setT(TEST_BOILER_T);
+	run(SEC_TO_MLS(TEST_SETTLE_TIME));
+
+	solar->getReleDriver()->override(true);
+	run(SEC_TO_MLS(SOLAR_NO_FLOW_TIME + 2));
+
+	TEST_ASSERT_FALSE(solar->getReleFlag());
+	TEST_ASSERT_FALSE(solar->getReleDriver()->getOverrideFlag());
+	TEST_ASSERT_EQUAL(8, solar->getStatus());
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_rate_and_volume_follow_the_pulses);
+	RUN_TEST(test_isr_counts_only_with_a_port);
+	RUN_TEST(test_dry_run_stops_under_error_on);
+	RUN_TEST(test_dry_run_stops_under_error_hold);
+	RUN_TEST(test_retry_backoff);
+	RUN_TEST(test_override_is_stopped);
+
+	return UNITY_END();
+}